@@ -59,6 +59,16 @@
 #define TVec4           VL_V_SUFF(Vec4)
 #define TQuat           VL_V_SUFF(Quat)
 #define TMat4           VL_M_SUFF(Mat4)
+#define TMat34          VL_M_SUFF(Mat34)
+
+#define TVec3x          VL_PASTE(TVec3, x)
+#define TVec3x4         VL_PASTE(TVec3, x4)
+#define TVec3x8         VL_PASTE(TVec3, x8)
+#define TVec3x16        VL_PASTE(TVec3, x16)
+#define TVec4x          VL_PASTE(TVec4, x)
+#define TVec4x4         VL_PASTE(TVec4, x4)
+#define TVec4x8         VL_PASTE(TVec4, x8)
+#define TVec4x16        VL_PASTE(TVec4, x16)
 
 #define TVec            VL_V_SUFF(Vec)
 #define TRefVec         VL_V_SUFF(RefVec)
@@ -88,6 +98,19 @@
 #define TConstRefVol    VL_M_SUFF(ConstRefVol)
 #define TConstSliceVol  VL_M_SUFF(ConstSliceVol)
 
+#define TSparseMat      VL_M_SUFF(SparseMat)
+
+#define TPreconditioner             VL_M_SUFF(Preconditioner)
+#define TJacobiPreconditioner       VL_M_SUFF(JacobiPreconditioner)
+#define TBlockJacobiPreconditioner  VL_M_SUFF(BlockJacobiPreconditioner)
+#define TSSORPreconditioner         VL_M_SUFF(SSORPreconditioner)
+#define TIC0Preconditioner          VL_M_SUFF(IC0Preconditioner)
+#define TLinearOperator             VL_M_SUFF(LinearOperator)
+#define TSolveWorkspace             VL_M_SUFF(SolveWorkspace)
+
+#define TLUFactor       VL_M_SUFF(LUFactor)
+#define TQRFactor       VL_M_SUFF(QRFactor)
+
 #define Scale2          VL_M_SUFF(Scale2)
 #define CRot2           VL_M_SUFF(CRot2 )
 #define RRot2           VL_M_SUFF(RRot2 )
@@ -114,7 +137,13 @@
 #define HRTrans4        VL_M_SUFF(HRTrans4)
 #define HTrans4         VL_M_SUFF(HTrans4 )
 
+#define HScale34        VL_M_SUFF(HScale34 )
+#define HCRot34         VL_M_SUFF(HCRot34  )
+#define HCTrans34       VL_M_SUFF(HCTrans34)
+
 #include "Math.hpp"
+#include "Threads.hpp"
+#include "Lanes.hpp"
 
 VL_NS_BEGIN
 
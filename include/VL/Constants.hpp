@@ -16,6 +16,8 @@ enum    VLBlock      { vl_zero = 0, vl_one = 1, vl_minus_one = -1, vl_0 = 0, vl_
 enum    VLAxis       { vl_x, vl_y, vl_z, vl_w };
 enum    VLMinusAxis  { vl_minus_x, vl_minus_y, vl_minus_z, vl_minus_w, vl_nx = 0, vl_ny, vl_nz, vl_nw };
 
+enum    VLSVDMethod  { kVLSVDGolubKahan, kVLSVDJacobi };   // see SVDFactorization
+
 typedef VLAxis      vl_axis;        // e.g., Vecf(10, vl_axis(4)), Vec3f(vl_axis(i))
 typedef VLMinusAxis vl_minus_axis;  // e.g., Vecf(10, vl_minus_axis(4))
 
@@ -12,6 +12,8 @@
 
 #define VL_PREFIX_(PREFIX, NAME) PREFIX ## _ ## NAME
 #define VL_PREFIX(PREFIX, NAME) VL_PREFIX_(PREFIX, NAME)
+#define VL_PASTE_(A, B) A ## B
+#define VL_PASTE(A, B) VL_PASTE_(A, B)
 
 // Assertions
 
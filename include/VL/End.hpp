@@ -19,8 +19,18 @@ VL_NS_END
 #undef TMat3
 #undef TVec4
 #undef TMat4
+#undef TMat34
 #undef TQuat
 
+#undef TVec3x
+#undef TVec3x4
+#undef TVec3x8
+#undef TVec3x16
+#undef TVec4x
+#undef TVec4x4
+#undef TVec4x8
+#undef TVec4x16
+
 #undef TVec
 #undef TRefVec
 #undef TSliceVec
@@ -49,6 +59,19 @@ VL_NS_END
 #undef TConstRefVol
 #undef TConstSliceVol
 
+#undef TSparseMat
+
+#undef TPreconditioner
+#undef TJacobiPreconditioner
+#undef TBlockJacobiPreconditioner
+#undef TSSORPreconditioner
+#undef TIC0Preconditioner
+#undef TLinearOperator
+#undef TSolveWorkspace
+
+#undef TLUFactor
+#undef TQRFactor
+
 #undef Scale2
 #undef Rot2
 #undef Scale3
@@ -59,14 +82,19 @@ VL_NS_END
 #undef HScale4
 #undef HRot4
 #undef HTrans4
+#undef HScale34
+#undef HCRot34
+#undef HCTrans34
 
 #undef VL_H
 // #undef VL_CONSTANTS_H
 #undef VL_FACTOR_H
+#undef VL_FACTOR3_H
 #undef VL_MAT_H
 #undef VL_MAT2_H
 #undef VL_MAT3_H
 #undef VL_MAT4_H
+#undef VL_MAT34_H
 #undef VL_MAT_SLICE_H
 //#undef VL_MATH_H
 #undef VL_OPS_H
@@ -75,6 +103,7 @@ VL_NS_END
 //#undef VL_PRINT_BASE_H
 #undef VL_QUAT_H
 #undef VL_SOLVE_H
+#undef VL_SPARSE_MAT_H
 #undef VL_STREAM_H
 #undef VL_STREAM_234_H
 #undef VL_SWIZZLE_H
@@ -86,6 +115,7 @@ VL_NS_END
 #undef VL_VEC_SLICE_H
 #undef VL_VOL_H
 #undef VL_VOL_SLICE_H
+#undef VL_WIDE_H
 
 #undef VL_V_ELT
 #undef VL_M_ELT
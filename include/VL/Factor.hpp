@@ -15,12 +15,34 @@
                 + QR factors A into A = Q R, where R is upper-triangular,
                 and Q is orthogonal.
 
+                + SymmetricEigen factors symmetric A into V D Vt, where
+                V is orthogonal, and D is diagonal, holding the
+                eigenvalues of A.
+
+                + LanczosEigen and LanczosSVD find just the top k
+                eigenpairs or singular triplets of a large matrix, which
+                may be sparse, or only available as an operator.
+                RandomizedSVD approximates the top k singular triplets of a
+                large dense matrix much faster.
+
+                + TQRFactor is a blocked QR that keeps Q implicitly, as
+                its Householder reflectors, for least squares problems.
+
+                + LU factors square A into P A = L U, where L is unit
+                lower-triangular, U is upper-triangular, and P is a row
+                permutation. TLUFactor keeps the factors around so that
+                many systems can be solved against the same A.
+
     Copyright:  Andrew Willmott
 */
 
 #ifndef VL_FACTOR_H
 #define VL_FACTOR_H
 
+VL_NS_END
+#include <vector>
+VL_NS_BEGIN
+
 // --- Factorization routines--------------------------------------------------
 
 TMElt QRFactorization(TRefMat A, TMat&   Q, TMat&   R);
@@ -28,15 +50,151 @@ TMElt QRFactorization(TRefMat A, TRefMat Q, TRefMat R);
 // Factor A into an orthogonal matrix Q and an upper-triangular matrix R.
 // Destroys A.
 
-void  SVDFactorization(TRefMat A, TMat&   U, TMat&   V, TMVec&   diagonal);
-void  SVDFactorization(TRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal);
-// Factor A into U D V^t. Destroys A.
+#ifndef VL_MIXED
+void  SVDFactorization(TRefMat A, TMat&   U, TMat&   V, TMVec&   diagonal, VLSVDMethod method = kVLSVDGolubKahan);
+void  SVDFactorization(TRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal, VLSVDMethod method = kVLSVDGolubKahan);
+// Factor A into U D V^t. Destroys A. Tall matrices are first reduced by QR,
+// so the cost of U is only ever that of the m x n result.
+// kVLSVDJacobi selects one-sided Jacobi, which threads across column pairs,
+// and finds small singular values to high relative accuracy.
+void  SVDFactorization(TRefMat A, TMVec&   diagonal, VLSVDMethod method = kVLSVDGolubKahan);
+void  SVDFactorization(TRefMat A, TMRefVec diagonal, VLSVDMethod method = kVLSVDGolubKahan);
+// Finds only the singular values of A, D, skipping the accumulation of U
+// and V. Use for ranks, condition numbers, and norms. Destroys A.
+#endif
 
 bool  Cholesky(TConstRefMat A, TRefMat L);
 // Factors symmetric positive definite matrix 'A' into L Lt, where
-// L is lower triangular.
+// L is lower triangular. Returns false if A isn't positive definite.
+// L may be A itself.
 void  BacksolveLLt(TConstRefMat L, TRefVec x, TConstRefVec b);
 // Given 'L' from a Cholesky decomposition, solve L Lt x = b.
+#ifndef VL_MIXED
+void  BacksolveLLt(TConstRefMat L, TRefMat X, TConstRefMat B);
+// Solves L Lt X = B, for each column of B. X and B may be the same matrix.
+void  SolveLower (TConstRefMat L, TRefMat X);   // X = L^-1 X,  where L is lower triangular, e.g., for whitening
+void  SolveLowerT(TConstRefMat L, TRefMat X);   // X = Lt^-1 X
+
+void  CholeskyUpdate  (TRefMat L, TConstRefVec v);
+// Given 'L' from a Cholesky decomposition of A, updates it in O(n^2) to be
+// that of A + v vt.
+bool  CholeskyDowndate(TRefMat L, TConstRefVec v);
+// Given 'L' from a Cholesky decomposition of A, updates it in O(n^2) to be
+// that of A - v vt. Returns false, leaving L unchanged, if A - v vt isn't
+// positive definite.
+
+void  SymmetricEigen(TRefMat A, TMat&   V, TVec&   eigenvalues);
+void  SymmetricEigen(TRefMat A, TRefMat V, TRefVec eigenvalues);
+// Factors symmetric A into V diag(eigenvalues) Vt, where V is orthogonal,
+// and its columns are the eigenvectors. The eigenvalues are sorted in
+// decreasing order. Destroys A.
+void  SymmetricEigen(TRefMat A, TVec&   eigenvalues);
+void  SymmetricEigen(TRefMat A, TRefVec eigenvalues);
+// Finds only the eigenvalues of symmetric A, which after the initial
+// O(n^3) reduction costs only O(n^2). Destroys A.
+#endif
+
+#ifndef VL_MIXED
+// --- LU factorization -------------------------------------------------------
+
+class TLUFactor
+// LU factorization with partial pivoting, P A = L U. Factor once, then
+// solve against any number of right-hand sides in O(n^2) each.
+{
+public:
+    TLUFactor();
+    explicit TLUFactor(TConstRefMat A, TElt epsilon = TElt(1e-20));
+
+    bool  Factor(TConstRefMat A, TElt epsilon = TElt(1e-20));
+    // Factors square matrix A. Returns false if A is singular, i.e., a pivot
+    // was <= epsilon in magnitude.
+
+    bool  IsSingular() const;                       // True if the last Factor() found A to be singular
+    int   Size() const;                             // Dimension of A
+
+    void  Solve(TRefVec x, TConstRefVec b) const;   // Solves A x = b. x and b may be the same vector.
+    void  Solve(TRefMat X, TConstRefMat B) const;   // Solves A X = B, i.e., for each column of B. X and B may be the same matrix.
+    TVec  Solve(TConstRefVec b) const;              // Returns A^-1 b
+    TMat  Solve(TConstRefMat B) const;              // Returns A^-1 B
+
+    TElt  Det() const;                              // Returns det(A)
+    TMat  Inverse() const;                          // Returns A^-1
+
+    TConstRefMat LU() const;                        // L and U packed into one matrix, with L's unit diagonal implied
+    const int*   Pivots() const;                    // At step i, row i was swapped with row Pivots()[i]
+
+protected:
+    TMat             lu;
+    std::vector<int> pivots;
+    int              sign;          // sign of the permutation
+    bool             singular;
+};
+
+// --- QR factorization -------------------------------------------------------
+
+class TQRFactor
+// Householder QR factorization, A = Q R, of an m x n matrix with m >= n.
+// Q = H_0 H_1 .. H_n-1 is kept as its Householder reflectors, stored below
+// the diagonal of R, so it's never formed unless asked for.
+{
+public:
+    TQRFactor();
+    explicit TQRFactor(TConstRefMat A);
+
+    void  Factor(TConstRefMat A);
+
+    int   Rows() const;                             // m
+    int   Cols() const;                             // n
+
+    void  ApplyQ (TRefVec x) const;                 // x = Q x, where x has m elements
+    void  ApplyQt(TRefVec x) const;                 // x = Qt x
+    void  ApplyQ (TRefMat X) const;                 // X = Q X, where X has m rows
+    void  ApplyQt(TRefMat X) const;                 // X = Qt X
+
+    TMat  Q() const;                                // Returns the first n columns of Q, which is all A needs
+    TMat  R() const;                                // Returns the n x n upper-triangular R
+
+    void  Solve(TRefVec x, TConstRefVec b) const;   // Finds the least squares solution x of A x = b
+    void  Solve(TRefMat X, TConstRefMat B) const;   // Ditto for each column of B
+    TVec  Solve(TConstRefVec b) const;
+    TMat  Solve(TConstRefMat B) const;
+
+    TConstRefMat QR() const;                        // R on and above the diagonal, reflector vectors below, with their unit first element implied
+    TConstRefVec Tau() const;                       // H_i = I - Tau()[i] v_i v_it
+
+protected:
+    TMat  qr;
+    TVec  tau;
+    TMat  blockT;   // per-block triangular factors, so each block of reflectors is I - V T Vt
+};
+
+// --- Partial decompositions -------------------------------------------------
+
+int   LanczosEigen(TConstRefMat           A, int k, TMat& V, TVec& values, TElt epsilon, int* steps = 0);
+int   LanczosEigen(const TSparseMat&      A, int k, TMat& V, TVec& values, TElt epsilon, int* steps = 0);
+int   LanczosEigen(const TLinearOperator& A, int k, TMat& V, TVec& values, TElt epsilon, int* steps = 0);
+// Finds the k largest eigenvalues of symmetric A, in decreasing order, and
+// their eigenvectors as the columns of V, using thick-restart Lanczos. Only
+// needs A x, and O(nk) memory. Returns how many pairs converged to a
+// residual |A v - lambda v| <= epsilon |lambda_max|. 'steps' returns the
+// number of products with A.
+
+int   LanczosSVD(TConstRefMat           A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps = 0);
+int   LanczosSVD(const TSparseMat&      A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps = 0);
+int   LanczosSVD(const TLinearOperator& A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps = 0);
+// Finds the k largest singular values of A, in decreasing order, and the
+// corresponding columns of U and V, using thick-restart Golub-Kahan-Lanczos
+// bidiagonalization. Only needs A x and At x, and O((m + n) k) memory.
+// Returns the number of converged triplets, as for LanczosEigen, and
+// 'steps' the number of products with A or At.
+
+void  RandomizedSVD(TConstRefMat A, int k, TMat& U, TMat& V, TVec& values, int powerIterations = 2, int oversample = 10);
+// Finds an approximation to the k largest singular values of A, in
+// decreasing order, and the corresponding columns of U and V, via a
+// randomized range finder. The cost is a few products of A with
+// (k + oversample)-column matrices. Each power iteration costs two more, and
+// improves accuracy when the singular values decay slowly.
+#endif
 
 // --- Utility routines--------------------------------------------------------
 
@@ -56,10 +214,10 @@ void  ReducedRowEchelonForm(TRefMat A, TMElt epsilon);
 // The non-zero rows form the row space of the matrix.
 // The pivot columns (those containing a leading one) form the column space.
 
-TMElt LeftHouseholder (TRefMat A, TRefMat U, int i); // Apply Householder xform for column i on left of A
-TMElt RightHouseholder(TRefMat A, TRefMat V, int i); // Apply Householder xform for row i on right of A
+TMElt LeftHouseholder (TRefMat A, TRefMat U, int i); // Apply Householder xform for column i on left of A. U may be null.
+TMElt RightHouseholder(TRefMat A, TRefMat V, int i); // Apply Householder xform for row i on right of A. V may be null.
 
-void  Bidiagonalize(TRefMat A, TRefMat U, TRefMat V, TRefVec diagonal, TRefVec superDiag);  // bidiagonalize 'A' using Householder transforms
-void  Diagonalize  (                                 TRefVec diagonal, TRefVec superDiag, TRefMat U, TRefMat V);  // Diagonalise diagonal/superDiagonal 
+void  Bidiagonalize(TRefMat A, TRefMat U, TRefMat V, TRefVec diagonal, TRefVec superDiag);  // bidiagonalize 'A' using Householder transforms. U/V may be null.
+void  Diagonalize  (                                 TRefVec diagonal, TRefVec superDiag, TRefMat U, TRefMat V);  // Diagonalise diagonal/superDiagonal. U/V may be null.
 
 #endif
@@ -0,0 +1,42 @@
+/*
+    File:       Factor3.hpp
+
+    Function:   Fixed-size 3 x 3 matrix factorizations: SVD, polar
+                decomposition, and symmetric eigen-decomposition.
+
+                These need no allocation, and have no data-dependent
+                branches, so the batch versions run several matrices at once
+                across SIMD lanes.
+
+    Copyright:  Andrew Willmott
+ */
+
+#ifndef VL_FACTOR3_H
+#define VL_FACTOR3_H
+
+#include "Mat3.hpp"
+
+
+// --- Mat3 Factorizations ----------------------------------------------------
+
+void SVDFactorization  (const TMat3& A, TMat3& U, TMat3& V, TVec3& diagonal);
+// Factors A = U diag(diagonal) trans(V), where U and V are rotations.
+// The singular values are sorted by decreasing magnitude, and the last is
+// negative if det(A) < 0.
+
+void PolarDecomposition(const TMat3& A, TMat3& R, TMat3& S);
+// Factors A = R S, where R is a rotation and S is symmetric. S is positive
+// semi-definite unless det(A) < 0, in which case the reflection is left in S
+// rather than R.
+
+void SymmetricEigen    (const TMat3& S, TMat3& V, TVec3& eigenvalues);
+// Factors the symmetric matrix S = V diag(eigenvalues) trans(V), where V is a
+// rotation whose columns are the eigenvectors. The eigenvalues are sorted in
+// decreasing order.
+
+// Batch versions of the above, applied to arrays of 'count' matrices
+void SVDFactorization  (int count, const TMat3 A[], TMat3 U[], TMat3 V[], TVec3 diagonals[]);
+void PolarDecomposition(int count, const TMat3 A[], TMat3 R[], TMat3 S[]);
+void SymmetricEigen    (int count, const TMat3 S[], TMat3 V[], TVec3 eigenvalues[]);
+
+#endif
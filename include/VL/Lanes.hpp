@@ -0,0 +1,450 @@
+/*
+    File:       Lanes.hpp
+
+    Function:   Fixed-width groups of scalars, operated on in lock-step.
+                These are the building block for the wide vector types in
+                Wide.hpp, and for batch routines that process several
+                problems at once across SIMD lanes.
+
+    Copyright:  Andrew Willmott
+ */
+
+#ifndef VL_LANES_H
+#define VL_LANES_H
+
+/*
+    NOTE
+
+    With GCC and clang, lanes are stored as generic vectors
+    (__attribute__((vector_size))), so each operation is a single
+    instruction on targets with registers of the same width, or a short
+    sequence of narrower ones otherwise: VLLanes<float, 8> is one AVX
+    register, or two SSE ones. This keeps the types portable, and lets code
+    built with -mavx2 or -mavx512f use the wider registers with no source
+    changes. The alignment is reduced to that of T, so arrays of lanes can
+    be heap-allocated without special allocators. Elsewhere, lanes are plain
+    arrays with fixed-length loops, for the auto-vectorizer. Either way sqrt
+    is spelled out with intrinsics, as errno handling otherwise stops it
+    vectorizing.
+
+    Comparisons produce masks rather than branches, via vl_if_less(), so
+    the same template code can be run on a single scalar or on lanes.
+*/
+
+#ifndef VL_NO_SIMD
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define VL_LANES_SSE2
+    #elif defined(__aarch64__) || defined(_M_ARM64)
+        #define VL_LANES_NEON
+    #endif
+
+    #if defined(__GNUC__)
+        #define VL_LANES_VECTOR_EXT
+    #endif
+#endif
+
+// VL_SIMD opts in to SSE/NEON versions of the Vec4f and Mat4f operations,
+// see Simd4.cpp. This aligns Vec4f to 16 bytes, and so changes the layout
+// of structures containing Vec4fs and Mat4fs.
+#if defined(VL_SIMD) && (defined(VL_LANES_SSE2) || defined(VL_LANES_NEON))
+    #define VL_SIMD4
+#endif
+
+#if defined(VL_LANES_SSE2)
+    #include <immintrin.h>
+#elif defined(VL_LANES_NEON)
+    #include <arm_neon.h>
+#endif
+
+// VL_LANES_EVAL(r, expr) sets lanes r to expr, where expr refers to the
+// lanes of its arguments via VL_LANE().
+#ifdef VL_LANES_VECTOR_EXT
+    #define VL_LANE(X) (X).v
+    #define VL_LANES_EVAL(R, E) VL_LANE(R) = E
+#else
+    #define VL_LANE(X) (X).v[i]
+    #define VL_LANES_EVAL(R, E) for (int i = 0; i < N; i++) VL_LANE(R) = E
+#endif
+
+VL_NS_BEGIN
+
+// --- Vec4 alignment ---------------------------------------------------------
+
+template<class T> struct VLVec4Align { enum { kAlign = alignof(T) }; };
+
+#ifdef VL_SIMD4
+template<> struct VLVec4Align<float> { enum { kAlign = 16 }; };
+
+    #define VL_VEC4_ALIGN alignas(VLVec4Align<TElt>::kAlign)
+#else
+    #define VL_VEC4_ALIGN
+#endif
+
+
+// --- Lanes ------------------------------------------------------------------
+
+template<class T, int N> struct VLLanes
+// N values of T, operated on in lock-step. N must be a power of two.
+{
+    enum { kLanes = N };
+
+#ifdef VL_LANES_VECTOR_EXT
+    typedef T Vector __attribute__((vector_size(N * sizeof(T)), aligned(sizeof(T))));
+#else
+    typedef T Vector[N];
+#endif
+
+    VLLanes() {}
+    VLLanes(T s);
+
+    T&       operator [] (int i)                    { return Data()[i]; }
+    const T& operator [] (int i) const              { return Data()[i]; }
+
+    T*       Data()                                 { return (T*) &v; }
+    const T* Data() const                           { return (const T*) &v; }
+
+    Vector v;
+};
+
+template<class T> struct VLLaneGroup
+// Lane group filling the widest vector register available
+{
+#if defined(__AVX512F__)
+    enum { kBytes = 64 };
+#elif defined(__AVX__)
+    enum { kBytes = 32 };
+#else
+    enum { kBytes = 16 };
+#endif
+    enum { kLanes = kBytes / sizeof(T) < 4 ? 4 : kBytes / sizeof(T) };
+
+    typedef VLLanes<T, kLanes> Type;
+};
+
+template<class T, int N> VLLanes<T, N> operator - (const VLLanes<T, N>& a);
+
+template<class T, int N> VLLanes<T, N> sqrt(const VLLanes<T, N>& a);
+template<class T, int N> VLLanes<T, N> abs (const VLLanes<T, N>& a);
+
+template<class T, int N> VLLanes<T, N> vl_min(const VLLanes<T, N>& a, const VLLanes<T, N>& b);
+template<class T, int N> VLLanes<T, N> vl_max(const VLLanes<T, N>& a, const VLLanes<T, N>& b);
+
+template<class T> T vl_if_less(T a, T b, T x, T y);
+template<class T, int N> VLLanes<T, N> vl_if_less(const VLLanes<T, N>& a, const VLLanes<T, N>& b, const VLLanes<T, N>& x, const VLLanes<T, N>& y);
+// Returns a < b ? x : y, per lane
+
+template<class T, int N> T vl_sum(const VLLanes<T, N>& a);
+// Returns the sum of a's lanes
+
+template<class T, int N> void vl_load_lanes (const T* p, int count, VLLanes<T, N>& x, VLLanes<T, N>& y, VLLanes<T, N>& z);
+template<class T, int N> void vl_load_lanes (const T* p, int count, VLLanes<T, N>& x, VLLanes<T, N>& y, VLLanes<T, N>& z, VLLanes<T, N>& w);
+// Deinterleaves 'count' consecutive xyz or xyzw tuples from p into lanes,
+// zeroing the remaining lanes
+template<class T, int N> void vl_store_lanes(T* p, int count, const VLLanes<T, N>& x, const VLLanes<T, N>& y, const VLLanes<T, N>& z);
+template<class T, int N> void vl_store_lanes(T* p, int count, const VLLanes<T, N>& x, const VLLanes<T, N>& y, const VLLanes<T, N>& z, const VLLanes<T, N>& w);
+// Interleaves the first 'count' lanes into xyz or xyzw tuples at p
+
+
+// --- Inlines ----------------------------------------------------------------
+
+template<class T, int N> inline VLLanes<T, N>::VLLanes(T s)
+{
+#ifdef VL_LANES_VECTOR_EXT
+    static_assert((N & (N - 1)) == 0, "(VLLanes) lane count must be a power of two");
+    v = Vector() + s;
+#else
+    for (int i = 0; i < N; i++)
+        v[i] = s;
+#endif
+}
+
+#define VL_LANE_OP(OP) \
+    template<class T, int N> inline VLLanes<T, N> operator OP (const VLLanes<T, N>& a, const VLLanes<T, N>& b) \
+    { VLLanes<T, N> r; VL_LANES_EVAL(r, VL_LANE(a) OP VL_LANE(b)); return r; } \
+    template<class T, int N> inline VLLanes<T, N> operator OP (const VLLanes<T, N>& a, T s) \
+    { VLLanes<T, N> r; VL_LANES_EVAL(r, VL_LANE(a) OP s); return r; } \
+    template<class T, int N> inline VLLanes<T, N> operator OP (T s, const VLLanes<T, N>& a) \
+    { VLLanes<T, N> r; VL_LANES_EVAL(r, s OP VL_LANE(a)); return r; } \
+    template<class T, int N> inline VLLanes<T, N>& operator OP##= (VLLanes<T, N>& a, const VLLanes<T, N>& b) \
+    { VL_LANES_EVAL(a, VL_LANE(a) OP VL_LANE(b)); return a; } \
+    template<class T, int N> inline VLLanes<T, N>& operator OP##= (VLLanes<T, N>& a, T s) \
+    { VL_LANES_EVAL(a, VL_LANE(a) OP s); return a; }
+
+VL_LANE_OP(+)
+VL_LANE_OP(-)
+VL_LANE_OP(*)
+VL_LANE_OP(/)
+#undef VL_LANE_OP
+
+template<class T, int N> inline VLLanes<T, N> operator - (const VLLanes<T, N>& a)
+{ VLLanes<T, N> r; VL_LANES_EVAL(r, -VL_LANE(a)); return r; }
+
+template<class T, int N> inline VLLanes<T, N> sqrt(const VLLanes<T, N>& a)
+{ VLLanes<T, N> r; for (int i = 0; i < N; i++) r[i] = std::sqrt(a[i]); return r; }
+
+template<int N> inline VLLanes<float, N> sqrt(const VLLanes<float, N>& a)
+{
+    VLLanes<float, N> r;
+    const float* ad = a.Data();
+    float*       rd = r.Data();
+    int i = 0;
+#if defined(VL_LANES_SSE2)
+    for (; i + 4 <= N; i += 4)
+        _mm_storeu_ps(rd + i, _mm_sqrt_ps(_mm_loadu_ps(ad + i)));
+#elif defined(VL_LANES_NEON)
+    for (; i + 4 <= N; i += 4)
+        vst1q_f32(rd + i, vsqrtq_f32(vld1q_f32(ad + i)));
+#endif
+    for (; i < N; i++)
+        rd[i] = std::sqrt(ad[i]);
+    return r;
+}
+
+template<int N> inline VLLanes<double, N> sqrt(const VLLanes<double, N>& a)
+{
+    VLLanes<double, N> r;
+    const double* ad = a.Data();
+    double*       rd = r.Data();
+    int i = 0;
+#if defined(VL_LANES_SSE2)
+    for (; i + 2 <= N; i += 2)
+        _mm_storeu_pd(rd + i, _mm_sqrt_pd(_mm_loadu_pd(ad + i)));
+#elif defined(VL_LANES_NEON)
+    for (; i + 2 <= N; i += 2)
+        vst1q_f64(rd + i, vsqrtq_f64(vld1q_f64(ad + i)));
+#endif
+    for (; i < N; i++)
+        rd[i] = std::sqrt(ad[i]);
+    return r;
+}
+
+template<class T, int N> inline VLLanes<T, N> abs(const VLLanes<T, N>& a)
+{ VLLanes<T, N> r; VL_LANES_EVAL(r, VL_LANE(a) < T(0) ? -VL_LANE(a) : VL_LANE(a)); return r; }
+
+template<class T, int N> inline VLLanes<T, N> vl_min(const VLLanes<T, N>& a, const VLLanes<T, N>& b)
+{ VLLanes<T, N> r; VL_LANES_EVAL(r, VL_LANE(a) < VL_LANE(b) ? VL_LANE(a) : VL_LANE(b)); return r; }
+
+template<class T, int N> inline VLLanes<T, N> vl_max(const VLLanes<T, N>& a, const VLLanes<T, N>& b)
+{ VLLanes<T, N> r; VL_LANES_EVAL(r, VL_LANE(a) > VL_LANE(b) ? VL_LANE(a) : VL_LANE(b)); return r; }
+
+template<class T> inline T vl_if_less(T a, T b, T x, T y)
+{ return a < b ? x : y; }
+
+template<class T, int N> inline VLLanes<T, N> vl_if_less(const VLLanes<T, N>& a, const VLLanes<T, N>& b, const VLLanes<T, N>& x, const VLLanes<T, N>& y)
+{ VLLanes<T, N> r; VL_LANES_EVAL(r, VL_LANE(a) < VL_LANE(b) ? VL_LANE(x) : VL_LANE(y)); return r; }
+
+template<class T, int N> inline T vl_sum(const VLLanes<T, N>& a)
+{ T s = a[0]; for (int i = 1; i < N; i++) s += a[i]; return s; }
+
+template<class T, int N> inline void vl_load_lanes(const T* p, int count, VLLanes<T, N>& x, VLLanes<T, N>& y, VLLanes<T, N>& z)
+{
+    for (int i = 0; i < count; i++, p += 3)
+    {
+        x[i] = p[0];
+        y[i] = p[1];
+        z[i] = p[2];
+    }
+
+    for (int i = count; i < N; i++)
+        x[i] = y[i] = z[i] = T(0);
+}
+
+template<class T, int N> inline void vl_load_lanes(const T* p, int count, VLLanes<T, N>& x, VLLanes<T, N>& y, VLLanes<T, N>& z, VLLanes<T, N>& w)
+{
+    for (int i = 0; i < count; i++, p += 4)
+    {
+        x[i] = p[0];
+        y[i] = p[1];
+        z[i] = p[2];
+        w[i] = p[3];
+    }
+
+    for (int i = count; i < N; i++)
+        x[i] = y[i] = z[i] = w[i] = T(0);
+}
+
+template<class T, int N> inline void vl_store_lanes(T* p, int count, const VLLanes<T, N>& x, const VLLanes<T, N>& y, const VLLanes<T, N>& z)
+{
+    for (int i = 0; i < count; i++, p += 3)
+    {
+        p[0] = x[i];
+        p[1] = y[i];
+        p[2] = z[i];
+    }
+}
+
+template<class T, int N> inline void vl_store_lanes(T* p, int count, const VLLanes<T, N>& x, const VLLanes<T, N>& y, const VLLanes<T, N>& z, const VLLanes<T, N>& w)
+{
+    for (int i = 0; i < count; i++, p += 4)
+    {
+        p[0] = x[i];
+        p[1] = y[i];
+        p[2] = z[i];
+        p[3] = w[i];
+    }
+}
+
+#ifdef VL_LANES_SSE2
+// Full groups of four floats are transposed in registers, as element-wise
+// copies would otherwise stall the vector loads that follow. With AVX,
+// pairs of groups are combined before storing, for the same reason.
+
+inline void vl_deinterleave(const float* p, __m128& x, __m128& y, __m128& z)
+{
+    __m128 a = _mm_loadu_ps(p);        // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(p + 4);    // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(p + 8);    // z2 x3 y3 z3
+
+    __m128 xy23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    __m128 yz01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+
+    x = _mm_shuffle_ps(a,    xy23, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(yz01, xy23, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(yz01, c,    _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+inline void vl_deinterleave(const float* p, __m128& x, __m128& y, __m128& z, __m128& w)
+{
+    x = _mm_loadu_ps(p);
+    y = _mm_loadu_ps(p + 4);
+    z = _mm_loadu_ps(p + 8);
+    w = _mm_loadu_ps(p + 12);
+
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+inline void vl_interleave(float* p, __m128 x, __m128 y, __m128 z)
+{
+    __m128 xy02 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));  // x0 x2 y0 y2
+    __m128 yz13 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));  // y1 y3 z1 z3
+    __m128 zx   = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));  // z0 z2 x1 x3
+
+    _mm_storeu_ps(p,     _mm_shuffle_ps(xy02, zx,   _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(yz13, xy02, _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(zx,   yz13, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+inline void vl_interleave(float* p, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    _mm_storeu_ps(p,      x);
+    _mm_storeu_ps(p + 4,  y);
+    _mm_storeu_ps(p + 8,  z);
+    _mm_storeu_ps(p + 12, w);
+}
+
+#ifdef __AVX__
+inline __m256 vl_combine(__m128 a, __m128 b)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(a), b, 1);
+}
+#endif
+
+template<int N> inline void vl_load_lanes(const float* p, int count, VLLanes<float, N>& x, VLLanes<float, N>& y, VLLanes<float, N>& z)
+{
+    if (count != N || N % 4 != 0)
+        return vl_load_lanes<float, N>(p, count, x, y, z);
+
+    int i = 0;
+#ifdef __AVX__
+    for (; i + 8 <= N; i += 8, p += 24)
+    {
+        __m128 x0, y0, z0, x1, y1, z1;
+        vl_deinterleave(p,      x0, y0, z0);
+        vl_deinterleave(p + 12, x1, y1, z1);
+
+        _mm256_storeu_ps(x.Data() + i, vl_combine(x0, x1));
+        _mm256_storeu_ps(y.Data() + i, vl_combine(y0, y1));
+        _mm256_storeu_ps(z.Data() + i, vl_combine(z0, z1));
+    }
+#endif
+    for (; i < N; i += 4, p += 12)
+    {
+        __m128 x0, y0, z0;
+        vl_deinterleave(p, x0, y0, z0);
+
+        _mm_storeu_ps(x.Data() + i, x0);
+        _mm_storeu_ps(y.Data() + i, y0);
+        _mm_storeu_ps(z.Data() + i, z0);
+    }
+}
+
+template<int N> inline void vl_load_lanes(const float* p, int count, VLLanes<float, N>& x, VLLanes<float, N>& y, VLLanes<float, N>& z, VLLanes<float, N>& w)
+{
+    if (count != N || N % 4 != 0)
+        return vl_load_lanes<float, N>(p, count, x, y, z, w);
+
+    int i = 0;
+#ifdef __AVX__
+    for (; i + 8 <= N; i += 8, p += 32)
+    {
+        __m128 x0, y0, z0, w0, x1, y1, z1, w1;
+        vl_deinterleave(p,      x0, y0, z0, w0);
+        vl_deinterleave(p + 16, x1, y1, z1, w1);
+
+        _mm256_storeu_ps(x.Data() + i, vl_combine(x0, x1));
+        _mm256_storeu_ps(y.Data() + i, vl_combine(y0, y1));
+        _mm256_storeu_ps(z.Data() + i, vl_combine(z0, z1));
+        _mm256_storeu_ps(w.Data() + i, vl_combine(w0, w1));
+    }
+#endif
+    for (; i < N; i += 4, p += 16)
+    {
+        __m128 x0, y0, z0, w0;
+        vl_deinterleave(p, x0, y0, z0, w0);
+
+        _mm_storeu_ps(x.Data() + i, x0);
+        _mm_storeu_ps(y.Data() + i, y0);
+        _mm_storeu_ps(z.Data() + i, z0);
+        _mm_storeu_ps(w.Data() + i, w0);
+    }
+}
+
+template<int N> inline void vl_store_lanes(float* p, int count, const VLLanes<float, N>& x, const VLLanes<float, N>& y, const VLLanes<float, N>& z)
+{
+    if (count != N || N % 4 != 0)
+        return vl_store_lanes<float, N>(p, count, x, y, z);
+
+    int i = 0;
+#ifdef __AVX__
+    for (; i + 8 <= N; i += 8, p += 24)
+    {
+        __m256 xi = _mm256_loadu_ps(x.Data() + i);
+        __m256 yi = _mm256_loadu_ps(y.Data() + i);
+        __m256 zi = _mm256_loadu_ps(z.Data() + i);
+
+        vl_interleave(p,      _mm256_castps256_ps128(xi),    _mm256_castps256_ps128(yi),    _mm256_castps256_ps128(zi));
+        vl_interleave(p + 12, _mm256_extractf128_ps(xi, 1), _mm256_extractf128_ps(yi, 1), _mm256_extractf128_ps(zi, 1));
+    }
+#endif
+    for (; i < N; i += 4, p += 12)
+        vl_interleave(p, _mm_loadu_ps(x.Data() + i), _mm_loadu_ps(y.Data() + i), _mm_loadu_ps(z.Data() + i));
+}
+
+template<int N> inline void vl_store_lanes(float* p, int count, const VLLanes<float, N>& x, const VLLanes<float, N>& y, const VLLanes<float, N>& z, const VLLanes<float, N>& w)
+{
+    if (count != N || N % 4 != 0)
+        return vl_store_lanes<float, N>(p, count, x, y, z, w);
+
+    int i = 0;
+#ifdef __AVX__
+    for (; i + 8 <= N; i += 8, p += 32)
+    {
+        __m256 xi = _mm256_loadu_ps(x.Data() + i);
+        __m256 yi = _mm256_loadu_ps(y.Data() + i);
+        __m256 zi = _mm256_loadu_ps(z.Data() + i);
+        __m256 wi = _mm256_loadu_ps(w.Data() + i);
+
+        vl_interleave(p,      _mm256_castps256_ps128(xi),    _mm256_castps256_ps128(yi),    _mm256_castps256_ps128(zi),    _mm256_castps256_ps128(wi));
+        vl_interleave(p + 16, _mm256_extractf128_ps(xi, 1), _mm256_extractf128_ps(yi, 1), _mm256_extractf128_ps(zi, 1), _mm256_extractf128_ps(wi, 1));
+    }
+#endif
+    for (; i < N; i += 4, p += 16)
+        vl_interleave(p, _mm_loadu_ps(x.Data() + i), _mm_loadu_ps(y.Data() + i), _mm_loadu_ps(z.Data() + i), _mm_loadu_ps(w.Data() + i));
+}
+#endif
+
+VL_NS_END
+
+#endif
@@ -251,6 +251,7 @@ TMat    abs    (TConstRefMat m);                           // | m_i_j |
 TMat    clamped(TConstRefMat m, TElt eps = TElt(1e-7));    // Clamp each entry |e| < eps to 0.
 TMat    hprod  (TConstRefMat a, TConstRefMat b);           // Hadamard product: component-wise multiply of a and b
 TMat    oprod  (TConstRefVec a, TConstRefVec b);           // Outer product: a_t b
+TMat    gram   (TConstRefMat m);                           // Gram matrix: M_t M, without forming M_t
 
 // Arbitrary per-element function application. E.g., sin(m) = transformed(m, std::sin)
 TMat    transformed(TConstRefMat m, TElt op(TElt));        // Returns 'm with 'op' applied to each element
@@ -272,7 +273,16 @@ void    Divide       (TConstRefMat m, TElt s, TRefMat result);
 void    Multiply(TConstRefMat m, TConstRefVec v, TRefVec result);
 void    Multiply(TConstRefVec v, TConstRefMat m, TRefVec result);
 
+void    MultiplyAtB (TConstRefMat a, TConstRefMat b, TRefMat result);  // result = a_t b
+void    MultiplyABt (TConstRefMat a, TConstRefMat b, TRefMat result);  // result = a b_t
+void    MultiplyAtA (TConstRefMat a, TRefMat result);                  // result = a_t a, computing only half
+void    MultiplyAAt (TConstRefMat a, TRefMat result);                  // result = a a_t, ditto
+void    MultiplyAtAx(TConstRefMat a, TConstRefVec x, TRefVec result, TElt* scratch = 0);  // result = a_t (a x), reading a once
+int     MultiplyAtAxScratch(TConstRefMat a);        // Elements of 'scratch' MultiplyAtAx(a, ...) needs to run allocation-free, or 0
+
 void    Transpose      (TConstRefMat m, TRefMat result);
+void    TransposeInPlace(TRefMat     m);                    // Transposes square m in place
+void    TransposeInPlace(TMat&       m);                    // Transposes m of any shape in place, swapping its dimensions
 void    Absolute       (TConstRefMat m, TRefMat result);
 void    Clamp          (TRefMat      m, TElt eps = TElt(1e-7));
 TElt    InnerProduct   (TConstRefMat a, TConstRefMat b);
@@ -681,15 +691,10 @@ inline TElt sum(TConstRefMat m)
     return sum(m.AsVec());
 }
 
-inline TElt sumsqr(TConstRefMat m)
-{
-    return sqrlen(m.AsVec());
-}
-
 #ifndef VL_NO_REAL
 inline TElt frob(TConstRefMat m)
 {
-    return len(m.AsVec());
+    return sqrt(sumsqr(m));
 }
 #endif
 
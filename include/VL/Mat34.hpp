@@ -0,0 +1,313 @@
+/*
+    File:       Mat34.hpp
+
+    Function:   Defines a 3 x 4 affine matrix.
+
+    Copyright:  Andrew Willmott
+*/
+
+#ifndef VL_MAT34_H
+#define VL_MAT34_H
+
+#include "Mat4.hpp"
+
+
+// --- Mat34 Class ------------------------------------------------------------
+
+/*
+    A Mat34 is a Mat4 with the implied last row [0 0 0 1], for affine
+    transforms on column vectors. Each row is [R_i t_i], for linear part R
+    and translation t, so p' = R p + t. This saves a quarter of the storage
+    of a Mat4, and composition and application skip the constant row.
+*/
+
+class TMat34 : public VLMatType
+{
+public:
+    typedef TVec4 Vec;
+
+    // Constructors
+    TMat34();
+    TMat34(TElt a, TElt b, TElt c, TElt d,
+           TElt e, TElt f, TElt g, TElt h,
+           TElt i, TElt j, TElt k, TElt l);
+    TMat34(TVec4 v0, TVec4 v1, TVec4 v2);
+    TMat34(const TMat34& m);
+
+    TMat34(VLDiag k);
+    TMat34(VLBlock k);
+
+    explicit TMat34(const TMat3& m, const TVec3& t = TVec3(vl_0));  // [m t]
+    explicit TMat34(const TMat4& m);                                // Drops the last row
+    explicit TMat34(const TElt m[12]);
+
+    // Accessor functions
+    int          Elts() const { return 12; };
+    int          Rows() const { return 3; };
+    int          Cols() const { return 4; };
+
+    TVec4&       operator [] (int i);
+    const TVec4& operator [] (int i) const;
+
+    TElt&        operator () (int i, int j);
+    TElt         operator () (int i, int j) const;
+
+    TElt*        Ref();
+    const TElt*  Ref() const;
+
+    // Assignment operators
+    TMat34&      operator =  (const TMat34& m);
+    TMat34&      operator =  (VLDiag k);
+    TMat34&      operator =  (VLBlock k);
+
+    TMat34&      operator += (const TMat34& m);
+    TMat34&      operator -= (const TMat34& m);
+    TMat34&      operator *= (const TMat34& m);
+    TMat34&      operator *= (TElt s);
+    TMat34&      operator /= (TElt s);
+
+    // Comparison operators
+    bool         operator == (const TMat34& m) const; // M == N?
+    bool         operator != (const TMat34& m) const; // M != N?
+
+    // Arithmetic operators
+    TMat34       operator + (const TMat34& m) const;  // M + N
+    TMat34       operator - (const TMat34& m) const;  // M - N
+    const TMat34& operator + () const;                // +M
+    TMat34       operator - () const;                 // -M
+    TMat34       operator * (const TMat34& m) const;  // M * N: apply N then M
+    TMat34       operator * (TElt s) const;           // M * s
+    TMat34       operator / (TElt s) const;           // M / s
+
+    // Initialisers
+    void         MakeZero();                          // Zero matrix
+    void         MakeIdentity();                      // Identity transform
+    void         MakeDiag (TElt k = vl_one);          // Diagonal = k, 0 otherwise
+    void         MakeBlock(TElt k = vl_one);          // all elts = k
+
+    // Conversion
+    TMat3        AsMat3() const;                      // Linear part
+    TVec3        Translation() const;                 // Translation part
+    TMat4        AsMat4() const;                      // With last row [0 0 0 1]
+
+    // Data
+    TVec4 x;
+    TVec4 y;
+    TVec4 z;
+};
+
+
+// --- Matrix operators -------------------------------------------------------
+
+TVec3  operator * (const TMat34& m, const TVec4& v);  // m * v, for homogeneous v
+TMat34 operator * (const TElt    s, const TMat34& m); // s * m
+
+TVec3  HApply      (const TMat34& m, const TVec3& p); // Transform point p: R p + t
+TVec3  HApplyVector(const TMat34& m, const TVec3& v); // Transform direction v: R v
+
+TVec4  row(const TMat34& m, int i);            // Return row i of 'm' (same as m[i])
+TVec3  col(const TMat34& m, int j);            // Return column j of 'm'
+
+TElt   det      (const TMat34& m);             // Determinant of the linear part
+#ifndef VL_NO_REAL
+TMat34 inv      (const TMat34& m);             // Affine inverse
+TMat34 inv_rigid(const TMat34& m);             // Inverse, assuming R is a rotation
+#endif
+TMat34 abs      (const TMat34& m);             // abs(m_ij)
+
+// Mat34 is always a column-vector transform, so these don't depend on
+// VL_ROW_ORIENT.
+TVec3  xform(const TMat34& m, const TVec3& v); // Transform of point v by m
+TMat34 xform(const TMat34& m, const TMat34& n);// Xform v -> m(n(v))
+
+
+// --- Inlines ----------------------------------------------------------------
+
+inline TMat34::TMat34()
+{
+}
+
+inline TMat34::TMat34
+(
+    TElt a, TElt b, TElt c, TElt d,
+    TElt e, TElt f, TElt g, TElt h,
+    TElt i, TElt j, TElt k, TElt l
+) :
+    x(a, b, c, d),
+    y(e, f, g, h),
+    z(i, j, k, l)
+{
+}
+
+inline TMat34::TMat34(TVec4 v0, TVec4 v1, TVec4 v2) :
+    x(v0),
+    y(v1),
+    z(v2)
+{
+}
+
+inline TMat34::TMat34(const TMat34& m) :
+    x(m.x),
+    y(m.y),
+    z(m.z)
+{
+}
+
+inline TMat34::TMat34(VLDiag k)
+{
+    MakeDiag(TElt(k));
+}
+
+inline TMat34::TMat34(VLBlock k)
+{
+    MakeBlock(TElt(k));
+}
+
+inline TMat34::TMat34(const TMat3& m, const TVec3& t) :
+    x(m.x, t.x),
+    y(m.y, t.y),
+    z(m.z, t.z)
+{
+}
+
+inline TMat34::TMat34(const TMat4& m) :
+    x(m.x),
+    y(m.y),
+    z(m.z)
+{
+}
+
+inline TMat34::TMat34(const TElt m[12])
+{
+    TElt* elts = Ref();
+    for (int i = 0; i < 12; i++)
+        *elts++ = *m++;
+}
+
+inline TVec4& TMat34::operator [] (int i)
+{
+    VL_RANGE_MSG(i, 0, 3, "(Mat34::[i]) index out of range");
+    return (&x)[i];
+}
+
+inline const TVec4& TMat34::operator [] (int i) const
+{
+    VL_RANGE_MSG(i, 0, 3, "(Mat34::[i]) index out of range");
+    return (&x)[i];
+}
+
+inline TElt& TMat34::operator () (int i, int j)
+{
+    VL_RANGE_MSG(i, 0, 3, "(Mat34::(i,j)) index out of range");
+    VL_RANGE_MSG(j, 0, 4, "(Mat34::(i,j)) index out of range");
+
+    return (&x)[i][j];
+}
+
+inline TElt TMat34::operator () (int i, int j) const
+{
+    VL_RANGE_MSG(i, 0, 3, "(Mat34::(i,j)) index out of range");
+    VL_RANGE_MSG(j, 0, 4, "(Mat34::(i,j)) index out of range");
+
+    return (&x)[i][j];
+}
+
+inline TElt* TMat34::Ref()
+{
+    return &x.x;
+}
+
+inline const TElt* TMat34::Ref() const
+{
+    return &x.x;
+}
+
+inline TMat34& TMat34::operator = (const TMat34& m)
+{
+    x = m.x;
+    y = m.y;
+    z = m.z;
+
+    return *this;
+}
+
+inline TMat34& TMat34::operator = (VLDiag k)
+{
+    MakeDiag(TElt(k));
+    return *this;
+}
+
+inline TMat34& TMat34::operator = (VLBlock k)
+{
+    MakeBlock(TElt(k));
+    return *this;
+}
+
+inline const TMat34& TMat34::operator + () const
+{
+    return *this;
+}
+
+inline TMat3 TMat34::AsMat3() const
+{
+    return TMat3(x.AsVec3(), y.AsVec3(), z.AsVec3());
+}
+
+inline TVec3 TMat34::Translation() const
+{
+    return TVec3(x.w, y.w, z.w);
+}
+
+inline TVec3 operator * (const TMat34& m, const TVec4& v)
+{
+    return TVec3(dot(m.x, v), dot(m.y, v), dot(m.z, v));
+}
+
+inline TMat34 operator * (TElt s, const TMat34& m)
+{
+    return m * s;
+}
+
+inline TVec3 HApply(const TMat34& m, const TVec3& p)
+{
+    return TVec3
+    (
+        m.x.x * p.x + m.x.y * p.y + m.x.z * p.z + m.x.w,
+        m.y.x * p.x + m.y.y * p.y + m.y.z * p.z + m.y.w,
+        m.z.x * p.x + m.z.y * p.y + m.z.z * p.z + m.z.w
+    );
+}
+
+inline TVec3 HApplyVector(const TMat34& m, const TVec3& v)
+{
+    return TVec3
+    (
+        m.x.x * v.x + m.x.y * v.y + m.x.z * v.z,
+        m.y.x * v.x + m.y.y * v.y + m.y.z * v.z,
+        m.z.x * v.x + m.z.y * v.y + m.z.z * v.z
+    );
+}
+
+inline TVec4 row(const TMat34& m, int i)
+{
+    VL_INDEX(i, 3);
+    return TVec4(*(&m.x + i));
+}
+
+inline TVec3 col(const TMat34& m, int j)
+{
+    VL_INDEX(j, 4);
+    return TVec3(m.x[j], m.y[j], m.z[j]);
+}
+
+inline TVec3 xform(const TMat34& m, const TVec3& v)
+{
+    return HApply(m, v);
+}
+
+inline TMat34 xform(const TMat34& m, const TMat34& n)
+{
+    return m * n;
+}
+
+#endif
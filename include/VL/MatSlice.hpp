@@ -146,6 +146,9 @@ TMat    clamped(TConstSliceMat m, TElt eps = TElt(1e-7)); // Clamp each entry |e
 TMat    hprod  (TConstSliceMat m, TConstSliceMat n);      // Hadamard product: component-wise multiply of m and n
 TMat    oprod  (TConstSliceVec a, TConstSliceVec b);      // Outer product: a_t b
 
+void    Multiply     (TConstSliceMat a, TConstSliceMat b, TSliceMat result);          // result = a * b
+void    MultiplyAccum(TConstSliceMat a, TConstSliceMat b, TElt s, TSliceMat result);  // result += s * a * b
+
 // Arbitrary per-element function application. E.g., sin(m) = transformed(m, std::sin)
 TMat    transformed(TConstSliceMat m, TElt op(TElt));        // Returns 'm with 'op' applied to each element
 void    transform  (     TSliceMat m, TElt op(TElt));        // Applies 'op' to each element of m
@@ -50,6 +50,7 @@ TQuat QuatInv  (const TQuat& q);                 // Quaternion inverse.
 
 TQuat NLerp(const TQuat& q1, const TQuat& q2, TElt s); // Return linear + renormalize interpolation between q1 and q2. Fast, accurate for smaller angles
 TQuat SLerp(const TQuat& q1, const TQuat& q2, TElt s); // Return spherical interpolation between q1 and q2
+TQuat SLerpFast(const TQuat& q1, const TQuat& q2, TElt s); // Polynomial approximation to SLerp along the shorter arc. Error < 4e-5
 
 TQuat FastRenormalize(const TQuat& q);                 // Renormalizes a mostly-already-normalized quaternion.
 TQuat QuatConstrain(const TQuat& q1, const TQuat& q2); // Return q2 adjusted so lerp between q1 & q2 takes shortest path.
@@ -83,6 +84,21 @@ TVec3 QuatDiff3(const TQuat& a, const TQuat& b); // Returns LogUnit3(MakeQuat(a,
 TQuat SLerp(TQuat q, TVec3 wd, TElt t);  // SLerp that takes wd=QuatDiff3(q, qb)). Avoids acos, allows multiple rotations by scaling wd
 TQuat SLerp(TQuat q, TVec3 n, TElt w, TElt t);  // Alternate version with separate (normalised) axis and angle
 
+// Batch versions of the above, applied to arrays of 'count' elements. These
+// work on several quaternions at once across SIMD lanes.
+void  QuatApply(int count, const TVec3 p[],  const TQuat q[],  TVec3 r[]);          // r[i] = QuatApply(p[i], q[i])
+void  QuatMult (int count, const TQuat a[],  const TQuat b[],  TQuat r[]);          // r[i] = QuatMult(a[i], b[i])
+void  NLerp    (int count, const TQuat q1[], const TQuat q2[], TElt s, TQuat r[]);  // r[i] = NLerp(q1[i], q2[i], s)
+void  SLerp    (int count, const TQuat q1[], const TQuat q2[], TElt s, TQuat r[]);  // r[i] = SLerp(q1[i], q2[i], s)
+void  SLerpFast(int count, const TQuat q1[], const TQuat q2[], TElt s, TQuat r[]);  // r[i] = SLerpFast(q1[i], q2[i], s)
+
+void  CRotFromQuat(int count, const TQuat q[], TMat3 r[]);
+void  CRotFromQuat(int count, const TQuat q[], TMat4 r[], const TVec3 translations[] = 0);
+void  CRotFromQuat(int count, const TQuat q[], TMat34 r[], const TVec3 translations[] = 0);
+// Writes the column-vector rotation matrices for q. The Mat4 and Mat34
+// versions produce affine transforms, translated by translations[i] if
+// given, e.g., for a skinning palette.
+
 
 // --- Inlines ----------------------------------------------------------------
 
@@ -4,7 +4,8 @@
     Function:   Contains routines for solving a system of linear equations.
                 Includes the overrelaxation (a more general version of
                 Gauss Seidel) and conjugate gradient methods, for both
-                normal and sparse matrices.
+                normal and sparse matrices, and preconditioners for the
+                latter.
 
     Copyright:  Andrew Willmott
  */
@@ -26,8 +27,180 @@ TMElt SolveOverRelax
 
 TMElt SolveConjGrad    (TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0);
 // Solves A x = b. If specified, *steps contains max iterations, and actual #
-// of iterations is returned.
+// of iterations is returned. A must be symmetric positive definite: for
+// non-symmetric A, see SolveBiCGStab and SolveGMRES.
 TMElt SolveConjGrad_AtA(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0);
 // Solves AtA x = At b, without having to form AtA
 
+#ifndef VL_MIXED
+// --- Solver workspace -------------------------------------------------------
+
+class TSolveWorkspace
+// Scratch storage for the iterative solvers below. Solves that are passed
+// the same workspace share its storage, so once it has grown to fit a
+// problem, repeated solves make no heap allocations.
+{
+public:
+    TSolveWorkspace();
+    explicit TSolveWorkspace(int n, int restart = 30);
+    // Preallocates enough storage for any of the solvers on an n x n
+    // system, with GMRES using the given restart.
+
+    TElt* Reserve(int elts);    // Returns storage for at least 'elts' elements, growing it if necessary
+    int   Elts() const;         // Current size of storage
+
+protected:
+    TVec storage;
+};
+
+TMElt SolveConjGrad    (TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace);
+TMElt SolveConjGrad_AtA(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace);
+// As above, but taking temporaries from 'workspace'. This and the other
+// solvers below take an optional workspace as their last argument.
+
+// Sparse versions of the above
+
+TMElt SolveOverRelax
+(
+    const TSparseMat& A,
+    TRefVec      x,
+    TConstRefVec b,
+    TMElt        epsilon,
+    TMElt        omega = TMElt(1),
+    int*         steps = 0
+);
+TMElt SolveConjGrad    (const TSparseMat& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+TMElt SolveConjGrad_AtA(const TSparseMat& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+
+// --- Preconditioning --------------------------------------------------------
+
+class TPreconditioner
+// Approximates A^-1 for the preconditioned conjugate gradient solver. To
+// supply your own, derive from this and implement Apply().
+{
+public:
+    virtual ~TPreconditioner();
+
+    virtual void Apply(TConstRefVec r, TRefVec z) const = 0;
+    // Sets z = M^-1 r, where M approximates A. r and z are distinct.
+};
+
+class TJacobiPreconditioner : public TPreconditioner
+// M = diag(A)
+{
+public:
+    explicit TJacobiPreconditioner(TConstRefMat A);
+    explicit TJacobiPreconditioner(const TSparseMat& A);
+
+    void Apply(TConstRefVec r, TRefVec z) const override;
+
+protected:
+    TVec invDiag;
+};
+
+class TBlockJacobiPreconditioner : public TPreconditioner
+// M = the block diagonal of A, with blocks of blockSize x blockSize. Suits
+// systems with a few coupled unknowns per node, e.g., 3D displacements.
+{
+public:
+    TBlockJacobiPreconditioner(TConstRefMat A, int blockSize);
+    TBlockJacobiPreconditioner(const TSparseMat& A, int blockSize);
+
+    void Apply(TConstRefVec r, TRefVec z) const override;
+
+protected:
+    void Init(const TSparseMat& A);
+
+    TMat invBlocks;     // Inverse of each diagonal block, stacked vertically
+    int  blockSize;
+};
+
+class TSSORPreconditioner : public TPreconditioner
+// Symmetric successive over-relaxation,
+// M = w/(2-w) (D/w + L) (D/w)^-1 (D/w + U).
+{
+public:
+    TSSORPreconditioner(TConstRefMat A, TElt omega = TElt(1));
+    TSSORPreconditioner(const TSparseMat& A, TElt omega = TElt(1));
+
+    void Apply(TConstRefVec r, TRefVec z) const override;
+
+protected:
+    void Init();
+
+    TSparseMat m;
+    TVec       diag;
+    TElt       omega;
+};
+
+class TIC0Preconditioner : public TPreconditioner
+// Incomplete Cholesky with no fill-in: M = L Lt, where L has the sparsity
+// of A's lower triangle. Usually the most effective of these for the
+// symmetric positive definite systems that come from discretised PDEs.
+{
+public:
+    explicit TIC0Preconditioner(TConstRefMat A);
+    explicit TIC0Preconditioner(const TSparseMat& A);
+
+    void Apply(TConstRefVec r, TRefVec z) const override;
+
+protected:
+    void Init(const TSparseMat& A);
+
+    TSparseMat L;       // Lower triangle, diagonal last in each row
+};
+
+TMElt SolveConjGrad(TConstRefMat      A, TRefVec x, TConstRefVec b, const TPreconditioner& M, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+TMElt SolveConjGrad(const TSparseMat& A, TRefVec x, TConstRefVec b, const TPreconditioner& M, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+// Preconditioned conjugate gradient. As for SolveConjGrad, but using M to
+// reduce the iteration count. A and M must both be symmetric positive
+// definite.
+
+// --- Matrix-free operators --------------------------------------------------
+
+class TLinearOperator
+// A linear operator that is applied on the fly rather than stored, e.g., a
+// stencil, or a Jacobian-vector product. Derive from this and implement
+// Apply() to use the conjugate gradient solvers without forming A.
+{
+public:
+    virtual ~TLinearOperator();
+
+    virtual int  Rows() const = 0;
+    virtual int  Cols() const = 0;
+
+    virtual void Apply(TConstRefVec x, TRefVec y) const = 0;
+    // Sets y = A x. x and y are distinct.
+    virtual void ApplyTranspose(TConstRefVec x, TRefVec y) const;
+    // Sets y = At x. Only needed for SolveConjGrad_AtA.
+};
+
+bool  is_square(const TLinearOperator& A);
+void  Multiply (const TLinearOperator& A, TConstRefVec x, TRefVec y);    // y = A x
+void  Multiply (TConstRefVec x, const TLinearOperator& A, TRefVec y);    // y = x A, i.e., At x
+
+TMElt SolveConjGrad    (const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+TMElt SolveConjGrad    (const TLinearOperator& A, TRefVec x, TConstRefVec b, const TPreconditioner& M, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+TMElt SolveConjGrad_AtA(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+// As above, but with A supplied as an operator. (SolveOverRelax needs
+// access to the individual rows of A, so has no operator form.)
+
+// --- Non-symmetric solvers --------------------------------------------------
+
+TMElt SolveBiCGStab(TConstRefMat           A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+TMElt SolveBiCGStab(const TSparseMat&      A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+TMElt SolveBiCGStab(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, TSolveWorkspace* workspace = 0);
+// Solves A x = b for general square A via the stabilised bi-conjugate
+// gradient method. Uses two products with A per iteration, and a fixed
+// amount of memory. Conventions are as for SolveConjGrad.
+
+TMElt SolveGMRES(TConstRefMat           A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, int restart = 30, TSolveWorkspace* workspace = 0);
+TMElt SolveGMRES(const TSparseMat&      A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, int restart = 30, TSolveWorkspace* workspace = 0);
+TMElt SolveGMRES(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps = 0, int restart = 30, TSolveWorkspace* workspace = 0);
+// Solves A x = b for general square A via GMRES(restart). Uses one
+// product with A per iteration, but stores 'restart' basis vectors. The
+// residual decreases monotonically, which makes it more robust than
+// BiCGStab for hard problems. Conventions are as for SolveConjGrad.
+#endif
+
 #endif
@@ -0,0 +1,122 @@
+/*
+    File:       SparseMat.hpp
+
+    Function:   Defines a sparse matrix, stored in compressed sparse row
+                (CSR) form, for large systems with only a few non-zero
+                elements per row.
+
+    Copyright:  Andrew Willmott
+ */
+
+#ifndef VL_SPARSE_MAT_H
+#define VL_SPARSE_MAT_H
+
+#include "Mat.hpp"
+
+VL_NS_END
+#include <vector>
+VL_NS_BEGIN
+
+
+// --- SparseMat Class --------------------------------------------------------
+
+class TSparseMat
+// Sparse matrix in compressed sparse row (CSR) form. The non-zero elements of
+// row i are elts[rowStarts[i] .. rowStarts[i + 1]), with their column indices
+// in the matching entries of colIndices, in increasing order.
+//
+// Compressed sparse column (CSC) storage of A is the same thing as CSR
+// storage of trans(A), so use trans() to convert between the two.
+{
+public:
+    // Constructors
+    TSparseMat();
+    TSparseMat(int rows, int cols);                         // Zero matrix
+    explicit TSparseMat(TConstRefMat m, TElt eps = TElt(0)); // Keeps elements with |m_ij| > eps
+
+    // Accessor methods
+    int     Rows() const;
+    int     Cols() const;
+    int     NonZeros() const;                               // Number of stored elements
+    TElt    operator () (int i, int j) const;               // Element (i, j), which may be zero. O(log(row non-zeros)).
+
+    int         RowElts   (int i) const;                    // Number of stored elements in row i
+    const int*  RowIndices(int i) const;                    // Column indices of row i's elements
+    const TElt* RowData   (int i) const;                    // Row i's elements
+
+    // Sizing
+    void    SetSize(int rows, int cols);                    // Makes this a rows x cols zero matrix
+    void    SetFromTriplets
+            (
+                int rows, int cols,
+                int count, const int* rowIndices, const int* colIndices, const TElt* values
+            );
+    // Builds a rows x cols matrix from 'count' (row, col, value) entries,
+    // given in any order. Duplicate entries are summed.
+
+    // Data
+    std::vector<int>  rowStarts;    // rows + 1 entries
+    std::vector<int>  colIndices;
+    std::vector<TElt> elts;
+    int               cols;
+    int               rows;
+};
+
+
+// --- SparseMat Arithmetic Operators -----------------------------------------
+
+TVec        operator * (const TSparseMat& m, TConstRefVec v);   // m v
+TVec        operator * (TConstRefVec v, const TSparseMat& m);   // v m, i.e., trans(m) v
+
+// --- SparseMat Functions ----------------------------------------------------
+
+bool        is_square(const TSparseMat& m);
+TSparseMat  trans    (const TSparseMat& m);     // Transpose. Also converts between CSR and CSC forms.
+TMat        dense    (const TSparseMat& m);     // Returns m as a dense matrix
+
+void Multiply (const TSparseMat& m, TConstRefVec v, TRefVec result);    // result = m v
+void Multiply (TConstRefVec v, const TSparseMat& m, TRefVec result);    // result = v m, i.e., trans(m) v
+void Transpose(const TSparseMat& m, TSparseMat& result);
+
+
+// --- SparseMat Inlines ------------------------------------------------------
+
+inline int TSparseMat::Rows() const
+{
+    return rows;
+}
+
+inline int TSparseMat::Cols() const
+{
+    return cols;
+}
+
+inline int TSparseMat::NonZeros() const
+{
+    return int(elts.size());
+}
+
+inline int TSparseMat::RowElts(int i) const
+{
+    VL_RANGE_MSG(i, 0, rows, "(SparseMat::RowElts) illegal row index");
+    return rowStarts[i + 1] - rowStarts[i];
+}
+
+inline const int* TSparseMat::RowIndices(int i) const
+{
+    VL_RANGE_MSG(i, 0, rows, "(SparseMat::RowIndices) illegal row index");
+    return colIndices.data() + rowStarts[i];
+}
+
+inline const TElt* TSparseMat::RowData(int i) const
+{
+    VL_RANGE_MSG(i, 0, rows, "(SparseMat::RowData) illegal row index");
+    return elts.data() + rowStarts[i];
+}
+
+inline bool is_square(const TSparseMat& m)
+{
+    return m.rows == m.cols;
+}
+
+#endif
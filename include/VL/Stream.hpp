@@ -30,28 +30,15 @@ class TConstRefVol;
 class TSliceVol;
 class TConstSliceVol;
 
-class TSparseVec;
-class TSubSVec;
-class TSparseMat;
-class TSubSMat;
-
 std::ostream& operator << (std::ostream& s, TConstRefVec v);
 std::istream& operator >> (std::istream& s, TVec& v);
 std::ostream& operator << (std::ostream& s, TConstSliceVec v);
 std::istream& operator >> (std::istream& s, TSliceVec v);
-std::ostream& operator << (std::ostream& s, const TSparseVec& v);
-std::istream& operator >> (std::istream& s, TSparseVec& v);
-std::ostream& operator << (std::ostream& s, const TSubSVec& v);
-std::istream& operator >> (std::istream& s, TSubSVec& v);
 
 std::ostream& operator << (std::ostream& s, TConstRefMat m);
 std::istream& operator >> (std::istream& s, TMat& m);
 std::ostream& operator << (std::ostream& s, TConstSliceMat m);
 std::istream& operator >> (std::istream& s, TSliceMat m);
-std::ostream& operator << (std::ostream& s, const TSparseMat& m);
-std::istream& operator >> (std::istream& s, TSparseMat& m);
-std::ostream& operator << (std::ostream& s, const TSubSMat& m);
-std::istream& operator >> (std::istream& s, TSubSMat& m);
 
 std::ostream& operator << (std::ostream& s, TConstRefVol m);
 std::istream& operator >> (std::istream& s, TVol& m);
@@ -38,5 +38,9 @@ std::istream& operator >> (std::istream& s, TMat3& m);
 std::ostream& operator << (std::ostream& s, const TMat4& m);
 std::istream& operator >> (std::istream& s, TMat4& m);
 
+#ifdef VL_MAT34_H
+std::ostream& operator << (std::ostream& s, const TMat34& m);
+#endif
+
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+    File:       Threads.hpp
+
+    Function:   Controls multi-threading of large matrix and volume
+                operations. Threading is off by default.
+
+    Copyright:  Andrew Willmott
+ */
+
+#ifndef VL_THREADS_H
+#define VL_THREADS_H
+
+VL_NS_BEGIN
+
+// --- Threading --------------------------------------------------------------
+
+enum VLThreadOp
+{
+    kVLThreadMultiply,      // Mat * Mat and Mat * Vec
+    kVLThreadTranspose,     // Transpose/trans
+    kVLThreadInvert,        // Invert/inv, Cholesky, Jacobi SVD
+    kVLThreadElementwise,   // Vol +, -, *, / etc.
+    kVLThreadReduce,        // sumsqr, frob
+    kVLThreadTransform,     // Batch point, normal and quaternion operations
+    kVLThreadOps
+};
+
+void vl_set_threads(int n);
+// Sets the number of threads used for large operations, including the
+// calling thread. 1 disables threading (the default), 0 uses all hardware
+// threads.
+int  vl_threads();
+// Returns the number of threads set by vl_set_threads()
+
+void vl_set_thread_threshold(VLThreadOp op, double minWork);
+// Sets how much work (roughly, multiply-adds or elements) 'op' must involve
+// before it is split across threads.
+double vl_thread_threshold(VLThreadOp op);
+// Returns the current threshold for 'op'
+
+
+// --- Inlines ----------------------------------------------------------------
+
+struct VLThreadConfig
+{
+    int    threads = 1;
+    double thresholds[kVLThreadOps] =
+    {
+        double(1 << 20),    // kVLThreadMultiply
+        double(1 << 18),    // kVLThreadTranspose
+        double(1 << 21),    // kVLThreadInvert
+        double(1 << 18),    // kVLThreadElementwise
+        double(1 << 18),    // kVLThreadReduce
+        double(1 << 20),    // kVLThreadTransform
+    };
+};
+
+inline VLThreadConfig& vl_thread_config()
+{
+    static VLThreadConfig sConfig;
+    return sConfig;
+}
+
+inline void vl_set_threads(int n)
+{
+    vl_thread_config().threads = n < 0 ? 1 : n;
+}
+
+inline int vl_threads()
+{
+    return vl_thread_config().threads;
+}
+
+inline void vl_set_thread_threshold(VLThreadOp op, double minWork)
+{
+    vl_thread_config().thresholds[op] = minWork;
+}
+
+inline double vl_thread_threshold(VLThreadOp op)
+{
+    return vl_thread_config().thresholds[op];
+}
+
+VL_NS_END
+
+#endif
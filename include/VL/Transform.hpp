@@ -42,6 +42,14 @@ TMat4 HRRot4  (const TVec3& from, const TVec3& to);  // RRot3 as 4x4 homogeneous
 TMat4 HCTrans4(const TVec3& t);     // Given 3d translation as 4x4 homogeneous matrix on col vectors
 TMat4 HRTrans4(const TVec3& t);     // Given 3d translation as 4x4 homogeneous matrix on row vectors
 
+TMat34 HScale34 (const TVec3& s);                       // Scale3 as 3x4 affine matrix
+TMat34 HCRot34  (const TVec3& axis, TElt theta);        // CRot3 as 3x4 affine matrix
+TMat34 HCRot34  (VLAxis       axis, TElt theta);        // CRot3 as 3x4 affine matrix
+TMat34 HCRot34  (const TVec4& q);                       // CRot3 as 3x4 affine matrix
+TMat34 HCRot34  (const TVec4& q, const TVec3& t);       // Rotation by q followed by translation t
+TMat34 HCRot34  (const TVec3& from, const TVec3& to);   // CRot3 as 3x4 affine matrix
+TMat34 HCTrans34(const TVec3& t);   // Given 3d translation as 3x4 affine matrix
+
 TVec2 HApply(TVec2 v, const TMat3& m);  // Apply given affine row-vector transform 'm' to 'v'
 TVec3 HApply(TVec3 v, const TMat4& m);  // Apply given affine row-vector transform 'm' to 'v'
 TVec2 HApply(const TMat3& m, TVec2 v);  // Apply given affine col-vector transform 'm' to 'v'
@@ -52,6 +60,24 @@ TVec3 HProj(TVec3 v, const TMat4& m);   // Apply given affine row-vector project
 TVec2 HProj(const TMat3& m, TVec2 v);   // Apply given affine col-vector projection 'm' to 'v'
 TVec3 HProj(const TMat4& m, TVec3 v);   // Apply given affine col-vector projection 'm' to 'v'
 
+// Batch versions for arrays of 'count' vectors, using column-vector transforms.
+// Strides are in bytes, to allow for interleaved vertex data, and r may be
+// the same as the input.
+void HApply(const TMat4& m, int count, const TVec3 p[], TVec3 r[], int pStride = sizeof(TVec3), int rStride = sizeof(TVec3));
+void HProj (const TMat4& m, int count, const TVec3 p[], TVec3 r[], int pStride = sizeof(TVec3), int rStride = sizeof(TVec3));
+
+void HApplyNormals(const TMat4& m, int count, const TVec3 n[], TVec3 r[], int nStride = sizeof(TVec3), int rStride = sizeof(TVec3), bool normalize = true);
+// Transforms normals n by the inverse transpose of m's upper-left 3x3, so
+// they stay perpendicular to surfaces transformed by m, and optionally
+// renormalizes them.
+
+void HApply(const TMat34& m, int count, const TVec3 p[], TVec3 r[], int pStride = sizeof(TVec3), int rStride = sizeof(TVec3));
+
+void xform(const TMat3& m, int count, const TVec3 v[], TVec3 r[], int vStride = sizeof(TVec3), int rStride = sizeof(TVec3));
+void xform(const TMat4& m, int count, const TVec3 p[], TVec3 r[], int pStride = sizeof(TVec3), int rStride = sizeof(TVec3));
+// As for xform(m, v), for arrays. The Mat4 version includes the perspective
+// divide.
+
 // Legacy, strongly recommended you use explicit RRot/CRot calls.
 #ifdef VL_ROW_ORIENT
 inline TMat2 Rot2(TElt theta)                            { return RRot2(theta); }
@@ -145,6 +171,16 @@ inline TMat4 HRRot4(const TQuat& q)
     return TMat4(RRotFromQuat(q));
 }
 
+inline TMat34 HCRot34(const TQuat& q)
+{
+    return TMat34(CRotFromQuat(q));
+}
+
+inline TMat34 HCRot34(const TQuat& q, const TVec3& t)
+{
+    return TMat34(CRotFromQuat(q), t);
+}
+
 inline TVec2 HApply(TVec2 v, const TMat3& m)
 {
     return v.x * m.x.AsVec2() + v.y * m.y.AsVec2() + m.z.AsVec2();
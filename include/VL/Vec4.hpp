@@ -16,7 +16,7 @@
 class TVec2;
 class TVec3;
 
-class TVec4 : public VLVecType
+class VL_VEC4_ALIGN TVec4 : public VLVecType
 {
 public:
     // Constructors
@@ -586,15 +586,10 @@ inline TElt sum(TConstRefVol v)
     return sum(v.AsVec());
 }
 
-inline TElt sumsqr(TConstRefVol v)
-{
-    return sqrlen(v.AsVec());
-}
-
 #ifndef VL_NO_REAL
 inline TElt frob(TConstRefVol v)
 {
-    return len(v.AsVec());
+    return sqrt(sumsqr(v));
 }
 #endif
 
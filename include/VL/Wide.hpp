@@ -0,0 +1,729 @@
+/*
+    File:       Wide.hpp
+
+    Function:   Defines 'wide' structure-of-arrays vectors, whose x, y, z
+                (and w) members are lane groups, so a single Vec3fx8 holds
+                eight Vec3fs. Operations on them apply to all lanes at
+                once, which the compiler turns into SIMD code.
+
+    Copyright:  Andrew Willmott
+ */
+
+#ifndef VL_WIDE_H
+#define VL_WIDE_H
+
+#include "Transform.hpp"
+
+/*
+    NOTE
+
+    The usual way to use these is to load a group of vectors from an array,
+    operate on them as if they were a single TVec3 or TVec4, and store the
+    results back, e.g.,
+
+        Vec3fx8 p, n;
+        p.Load(points + i);
+        n = norm(xform(m, p));
+        n.Store(normals + i);
+
+    Load() and Store() take an optional count for the final partial group.
+    Comparisons don't return bool, so there are no ==, < etc. operators;
+    use vl_if_less() on the lanes instead.
+*/
+
+
+// --- Wide Vec3 --------------------------------------------------------------
+
+template<int N> class TVec3x
+{
+public:
+    typedef VLLanes<TElt, N> Lanes;
+    enum { kLanes = N };
+
+    // Constructors
+    TVec3x();
+    TVec3x(const Lanes& x, const Lanes& y, const Lanes& z);
+    explicit TVec3x(const TVec3& v);            // v in every lane
+
+    // Accessor functions
+    TVec3       Get(int i) const;               // Vector in lane i
+    void        Set(int i, const TVec3& v);     // Set lane i to v
+
+    void        Load (const TVec3 v[], int count = N);        // Lanes from v[0 .. count), remainder zero
+    void        Store(TVec3 v[],       int count = N) const;  // Lanes to v[0 .. count)
+
+    // Assignment operators
+    TVec3x&     operator += (const TVec3x& a);
+    TVec3x&     operator -= (const TVec3x& a);
+    TVec3x&     operator *= (const TVec3x& a);
+    TVec3x&     operator *= (const Lanes& s);
+    TVec3x&     operator *= (TElt s);
+    TVec3x&     operator /= (const Lanes& s);
+    TVec3x&     operator /= (TElt s);
+
+    // Arithmetic operators
+    TVec3x      operator + (const TVec3x& a) const; // v + a
+    TVec3x      operator - (const TVec3x& a) const; // v - a
+    TVec3x      operator - () const;                // -v
+    TVec3x      operator * (const TVec3x& a) const; // v * a (vx * ax, ...)
+    TVec3x      operator * (const Lanes& s) const;  // v * s, per lane
+    TVec3x      operator * (TElt s) const;          // v * s
+    TVec3x      operator / (const TVec3x& a) const; // v / a (vx / ax, ...)
+    TVec3x      operator / (const Lanes& s) const;  // v / s, per lane
+    TVec3x      operator / (TElt s) const;          // v / s
+
+    // Data
+    Lanes x;
+    Lanes y;
+    Lanes z;
+};
+
+typedef TVec3x<4>  TVec3x4;
+typedef TVec3x<8>  TVec3x8;
+typedef TVec3x<16> TVec3x16;
+
+
+// --- Wide Vec4 --------------------------------------------------------------
+
+template<int N> class TVec4x
+{
+public:
+    typedef VLLanes<TElt, N> Lanes;
+    enum { kLanes = N };
+
+    // Constructors
+    TVec4x();
+    TVec4x(const Lanes& x, const Lanes& y, const Lanes& z, const Lanes& w);
+    TVec4x(const TVec3x<N>& v, const Lanes& w); // Hom. 3D vector
+    explicit TVec4x(const TVec4& v);            // v in every lane
+
+    // Accessor functions
+    TVec4       Get(int i) const;               // Vector in lane i
+    void        Set(int i, const TVec4& v);     // Set lane i to v
+
+    void        Load (const TVec4 v[], int count = N);        // Lanes from v[0 .. count), remainder zero
+    void        Store(TVec4 v[],       int count = N) const;  // Lanes to v[0 .. count)
+
+    // Assignment operators
+    TVec4x&     operator += (const TVec4x& a);
+    TVec4x&     operator -= (const TVec4x& a);
+    TVec4x&     operator *= (const TVec4x& a);
+    TVec4x&     operator *= (const Lanes& s);
+    TVec4x&     operator *= (TElt s);
+    TVec4x&     operator /= (const Lanes& s);
+    TVec4x&     operator /= (TElt s);
+
+    // Arithmetic operators
+    TVec4x      operator + (const TVec4x& a) const; // v + a
+    TVec4x      operator - (const TVec4x& a) const; // v - a
+    TVec4x      operator - () const;                // -v
+    TVec4x      operator * (const TVec4x& a) const; // v * a (vx * ax, ...)
+    TVec4x      operator * (const Lanes& s) const;  // v * s, per lane
+    TVec4x      operator * (TElt s) const;          // v * s
+    TVec4x      operator / (const TVec4x& a) const; // v / a (vx / ax, ...)
+    TVec4x      operator / (const Lanes& s) const;  // v / s, per lane
+    TVec4x      operator / (TElt s) const;          // v / s
+
+    // Conversion
+    TVec3x<N>   AsVec3() const;                     // x, y, z
+
+    // Data
+    Lanes x;
+    Lanes y;
+    Lanes z;
+    Lanes w;
+};
+
+typedef TVec4x<4>  TVec4x4;
+typedef TVec4x<8>  TVec4x8;
+typedef TVec4x<16> TVec4x16;
+
+
+// --- Wide operators ---------------------------------------------------------
+
+// lerp(a, b, s) is covered by the template in Math.hpp, for s either a TElt
+// or lanes.
+
+template<int N> TVec3x<N> operator * (TElt s, const TVec3x<N>& v);     // s * v
+template<int N> TVec3x<N> operator * (const VLLanes<TElt, N>& s, const TVec3x<N>& v);
+
+template<int N> VLLanes<TElt, N> dot(const TVec3x<N>& a, const TVec3x<N>& b); // a . b
+template<int N> TVec3x<N> cross (const TVec3x<N>& a, const TVec3x<N>& b);     // a x b
+template<int N> VLLanes<TElt, N> sqrlen(const TVec3x<N>& v);                  // v . v
+template<int N> VLLanes<TElt, N> len   (const TVec3x<N>& v);                  // || v ||
+template<int N> TVec3x<N> norm  (const TVec3x<N>& v);                         // v / || v ||
+template<int N> TVec3x<N> abs   (const TVec3x<N>& v);                         // abs(v_i)
+
+template<int N> TVec4x<N> operator * (TElt s, const TVec4x<N>& v);     // s * v
+template<int N> TVec4x<N> operator * (const VLLanes<TElt, N>& s, const TVec4x<N>& v);
+
+template<int N> VLLanes<TElt, N> dot(const TVec4x<N>& a, const TVec4x<N>& b); // a . b
+template<int N> VLLanes<TElt, N> sqrlen(const TVec4x<N>& v);                  // v . v
+template<int N> VLLanes<TElt, N> len   (const TVec4x<N>& v);                  // || v ||
+template<int N> TVec4x<N> norm  (const TVec4x<N>& v);                         // v / || v ||
+template<int N> TVec4x<N> abs   (const TVec4x<N>& v);                         // abs(v_i)
+template<int N> TVec3x<N> proj  (const TVec4x<N>& v);                         // homogeneous projection
+
+template<int N> TVec3x<N> operator * (const TMat3& m, const TVec3x<N>& v);  // m * v
+template<int N> TVec3x<N> operator * (const TVec3x<N>& v, const TMat3& m);  // v * m
+template<int N> TVec4x<N> operator * (const TMat4& m, const TVec4x<N>& v);  // m * v
+template<int N> TVec4x<N> operator * (const TVec4x<N>& v, const TMat4& m);  // v * m
+
+template<int N> TVec3x<N> HApply(const TVec3x<N>& v, const TMat4& m);  // Apply affine row-vector transform 'm' to 'v'
+template<int N> TVec3x<N> HApply(const TMat4& m, const TVec3x<N>& v);  // Apply affine col-vector transform 'm' to 'v'
+template<int N> TVec3x<N> HApply(const TMat34& m, const TVec3x<N>& v); // Apply affine transform 'm' to points 'v'
+template<int N> TVec3x<N> HApplyVector(const TMat34& m, const TVec3x<N>& v); // Apply 'm' to directions 'v'
+template<int N> TVec3x<N> HProj (const TVec3x<N>& v, const TMat4& m);  // Apply row-vector projection 'm' to 'v'
+template<int N> TVec3x<N> HProj (const TMat4& m, const TVec3x<N>& v);  // Apply col-vector projection 'm' to 'v'
+
+template<int N> TVec3x<N> xform(const TMat3& m, const TVec3x<N>& v);   // As for TVec3
+template<int N> TVec3x<N> xform(const TMat4& m, const TVec3x<N>& v);
+template<int N> TVec4x<N> xform(const TMat4& m, const TVec4x<N>& v);
+
+template<int N> TVec3x<N> QuatApply(const TVec3x<N>& p, const TVec4x<N>& q);  // As for TQuat
+template<int N> TVec4x<N> QuatMult (const TVec4x<N>& a, const TVec4x<N>& b);
+template<int N> TVec4x<N> NLerp    (const TVec4x<N>& q1, const TVec4x<N>& q2, TElt s);
+
+
+// --- Inlines ----------------------------------------------------------------
+
+// TVec3x
+
+template<int N> inline TVec3x<N>::TVec3x()
+{
+}
+
+template<int N> inline TVec3x<N>::TVec3x(const Lanes& a, const Lanes& b, const Lanes& c) :
+    x(a),
+    y(b),
+    z(c)
+{}
+
+template<int N> inline TVec3x<N>::TVec3x(const TVec3& v) :
+    x(v.x),
+    y(v.y),
+    z(v.z)
+{}
+
+template<int N> inline TVec3 TVec3x<N>::Get(int i) const
+{
+    VL_INDEX_MSG(i, N, "(Vec3x::Get) lane out of range");
+    return TVec3(x[i], y[i], z[i]);
+}
+
+template<int N> inline void TVec3x<N>::Set(int i, const TVec3& v)
+{
+    VL_INDEX_MSG(i, N, "(Vec3x::Set) lane out of range");
+    x[i] = v.x;
+    y[i] = v.y;
+    z[i] = v.z;
+}
+
+template<int N> inline void TVec3x<N>::Load(const TVec3 v[], int count)
+{
+    VL_ASSERT_MSG(count >= 0 && count <= N, "(Vec3x::Load) illegal count");
+    vl_load_lanes((const TElt*) v, count, x, y, z);
+}
+
+template<int N> inline void TVec3x<N>::Store(TVec3 v[], int count) const
+{
+    VL_ASSERT_MSG(count >= 0 && count <= N, "(Vec3x::Store) illegal count");
+    vl_store_lanes((TElt*) v, count, x, y, z);
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator += (const TVec3x& a)
+{
+    x += a.x;
+    y += a.y;
+    z += a.z;
+
+    return *this;
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator -= (const TVec3x& a)
+{
+    x -= a.x;
+    y -= a.y;
+    z -= a.z;
+
+    return *this;
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator *= (const TVec3x& a)
+{
+    x *= a.x;
+    y *= a.y;
+    z *= a.z;
+
+    return *this;
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator *= (const Lanes& s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+
+    return *this;
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator *= (TElt s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+
+    return *this;
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator /= (const Lanes& s)
+{
+    Lanes t = TElt(vl_one) / s;
+    return *this *= t;
+}
+
+template<int N> inline TVec3x<N>& TVec3x<N>::operator /= (TElt s)
+{
+    return *this *= TElt(vl_one) / s;
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator + (const TVec3x& a) const
+{
+    return TVec3x(x + a.x, y + a.y, z + a.z);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator - (const TVec3x& a) const
+{
+    return TVec3x(x - a.x, y - a.y, z - a.z);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator - () const
+{
+    return TVec3x(-x, -y, -z);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator * (const TVec3x& a) const
+{
+    return TVec3x(x * a.x, y * a.y, z * a.z);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator * (const Lanes& s) const
+{
+    return TVec3x(x * s, y * s, z * s);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator * (TElt s) const
+{
+    return TVec3x(x * s, y * s, z * s);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator / (const TVec3x& a) const
+{
+    return TVec3x(x / a.x, y / a.y, z / a.z);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator / (const Lanes& s) const
+{
+    Lanes t = TElt(vl_one) / s;
+    return TVec3x(x * t, y * t, z * t);
+}
+
+template<int N> inline TVec3x<N> TVec3x<N>::operator / (TElt s) const
+{
+    return *this * (TElt(vl_one) / s);
+}
+
+template<int N> inline TVec3x<N> operator * (TElt s, const TVec3x<N>& v)
+{
+    return v * s;
+}
+
+template<int N> inline TVec3x<N> operator * (const VLLanes<TElt, N>& s, const TVec3x<N>& v)
+{
+    return v * s;
+}
+
+template<int N> inline VLLanes<TElt, N> dot(const TVec3x<N>& a, const TVec3x<N>& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template<int N> inline TVec3x<N> cross(const TVec3x<N>& a, const TVec3x<N>& b)
+{
+    return TVec3x<N>
+    (
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x
+    );
+}
+
+template<int N> inline VLLanes<TElt, N> sqrlen(const TVec3x<N>& v)
+{
+    return dot(v, v);
+}
+
+template<int N> inline VLLanes<TElt, N> len(const TVec3x<N>& v)
+{
+    return sqrt(dot(v, v));
+}
+
+template<int N> inline TVec3x<N> norm(const TVec3x<N>& v)
+{
+    return v / sqrt(dot(v, v));
+}
+
+template<int N> inline TVec3x<N> abs(const TVec3x<N>& v)
+{
+    return TVec3x<N>(abs(v.x), abs(v.y), abs(v.z));
+}
+
+
+// TVec4x
+
+template<int N> inline TVec4x<N>::TVec4x()
+{
+}
+
+template<int N> inline TVec4x<N>::TVec4x(const Lanes& a, const Lanes& b, const Lanes& c, const Lanes& d) :
+    x(a),
+    y(b),
+    z(c),
+    w(d)
+{}
+
+template<int N> inline TVec4x<N>::TVec4x(const TVec3x<N>& v, const Lanes& d) :
+    x(v.x),
+    y(v.y),
+    z(v.z),
+    w(d)
+{}
+
+template<int N> inline TVec4x<N>::TVec4x(const TVec4& v) :
+    x(v.x),
+    y(v.y),
+    z(v.z),
+    w(v.w)
+{}
+
+template<int N> inline TVec4 TVec4x<N>::Get(int i) const
+{
+    VL_INDEX_MSG(i, N, "(Vec4x::Get) lane out of range");
+    return TVec4(x[i], y[i], z[i], w[i]);
+}
+
+template<int N> inline void TVec4x<N>::Set(int i, const TVec4& v)
+{
+    VL_INDEX_MSG(i, N, "(Vec4x::Set) lane out of range");
+    x[i] = v.x;
+    y[i] = v.y;
+    z[i] = v.z;
+    w[i] = v.w;
+}
+
+template<int N> inline void TVec4x<N>::Load(const TVec4 v[], int count)
+{
+    VL_ASSERT_MSG(count >= 0 && count <= N, "(Vec4x::Load) illegal count");
+    vl_load_lanes((const TElt*) v, count, x, y, z, w);
+}
+
+template<int N> inline void TVec4x<N>::Store(TVec4 v[], int count) const
+{
+    VL_ASSERT_MSG(count >= 0 && count <= N, "(Vec4x::Store) illegal count");
+    vl_store_lanes((TElt*) v, count, x, y, z, w);
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator += (const TVec4x& a)
+{
+    x += a.x;
+    y += a.y;
+    z += a.z;
+    w += a.w;
+
+    return *this;
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator -= (const TVec4x& a)
+{
+    x -= a.x;
+    y -= a.y;
+    z -= a.z;
+    w -= a.w;
+
+    return *this;
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator *= (const TVec4x& a)
+{
+    x *= a.x;
+    y *= a.y;
+    z *= a.z;
+    w *= a.w;
+
+    return *this;
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator *= (const Lanes& s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+    w *= s;
+
+    return *this;
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator *= (TElt s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+    w *= s;
+
+    return *this;
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator /= (const Lanes& s)
+{
+    Lanes t = TElt(vl_one) / s;
+    return *this *= t;
+}
+
+template<int N> inline TVec4x<N>& TVec4x<N>::operator /= (TElt s)
+{
+    return *this *= TElt(vl_one) / s;
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator + (const TVec4x& a) const
+{
+    return TVec4x(x + a.x, y + a.y, z + a.z, w + a.w);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator - (const TVec4x& a) const
+{
+    return TVec4x(x - a.x, y - a.y, z - a.z, w - a.w);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator - () const
+{
+    return TVec4x(-x, -y, -z, -w);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator * (const TVec4x& a) const
+{
+    return TVec4x(x * a.x, y * a.y, z * a.z, w * a.w);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator * (const Lanes& s) const
+{
+    return TVec4x(x * s, y * s, z * s, w * s);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator * (TElt s) const
+{
+    return TVec4x(x * s, y * s, z * s, w * s);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator / (const TVec4x& a) const
+{
+    return TVec4x(x / a.x, y / a.y, z / a.z, w / a.w);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator / (const Lanes& s) const
+{
+    Lanes t = TElt(vl_one) / s;
+    return TVec4x(x * t, y * t, z * t, w * t);
+}
+
+template<int N> inline TVec4x<N> TVec4x<N>::operator / (TElt s) const
+{
+    return *this * (TElt(vl_one) / s);
+}
+
+template<int N> inline TVec3x<N> TVec4x<N>::AsVec3() const
+{
+    return TVec3x<N>(x, y, z);
+}
+
+template<int N> inline TVec4x<N> operator * (TElt s, const TVec4x<N>& v)
+{
+    return v * s;
+}
+
+template<int N> inline TVec4x<N> operator * (const VLLanes<TElt, N>& s, const TVec4x<N>& v)
+{
+    return v * s;
+}
+
+template<int N> inline VLLanes<TElt, N> dot(const TVec4x<N>& a, const TVec4x<N>& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+template<int N> inline VLLanes<TElt, N> sqrlen(const TVec4x<N>& v)
+{
+    return dot(v, v);
+}
+
+template<int N> inline VLLanes<TElt, N> len(const TVec4x<N>& v)
+{
+    return sqrt(dot(v, v));
+}
+
+template<int N> inline TVec4x<N> norm(const TVec4x<N>& v)
+{
+    return v / sqrt(dot(v, v));
+}
+
+template<int N> inline TVec4x<N> abs(const TVec4x<N>& v)
+{
+    return TVec4x<N>(abs(v.x), abs(v.y), abs(v.z), abs(v.w));
+}
+
+template<int N> inline TVec3x<N> proj(const TVec4x<N>& v)
+{
+    VLLanes<TElt, N> s = TElt(vl_one) / v.w;
+    return TVec3x<N>(v.x * s, v.y * s, v.z * s);
+}
+
+
+// Matrix products
+
+template<int N> inline TVec3x<N> operator * (const TMat3& m, const TVec3x<N>& v)
+{
+    return TVec3x<N>
+    (
+        v.x * m.x.x + v.y * m.x.y + v.z * m.x.z,
+        v.x * m.y.x + v.y * m.y.y + v.z * m.y.z,
+        v.x * m.z.x + v.y * m.z.y + v.z * m.z.z
+    );
+}
+
+template<int N> inline TVec3x<N> operator * (const TVec3x<N>& v, const TMat3& m)
+{
+    return TVec3x<N>
+    (
+        v.x * m.x.x + v.y * m.y.x + v.z * m.z.x,
+        v.x * m.x.y + v.y * m.y.y + v.z * m.z.y,
+        v.x * m.x.z + v.y * m.y.z + v.z * m.z.z
+    );
+}
+
+template<int N> inline TVec4x<N> operator * (const TMat4& m, const TVec4x<N>& v)
+{
+    return TVec4x<N>
+    (
+        v.x * m.x.x + v.y * m.x.y + v.z * m.x.z + v.w * m.x.w,
+        v.x * m.y.x + v.y * m.y.y + v.z * m.y.z + v.w * m.y.w,
+        v.x * m.z.x + v.y * m.z.y + v.z * m.z.z + v.w * m.z.w,
+        v.x * m.w.x + v.y * m.w.y + v.z * m.w.z + v.w * m.w.w
+    );
+}
+
+template<int N> inline TVec4x<N> operator * (const TVec4x<N>& v, const TMat4& m)
+{
+    return TVec4x<N>
+    (
+        v.x * m.x.x + v.y * m.y.x + v.z * m.z.x + v.w * m.w.x,
+        v.x * m.x.y + v.y * m.y.y + v.z * m.z.y + v.w * m.w.y,
+        v.x * m.x.z + v.y * m.y.z + v.z * m.z.z + v.w * m.w.z,
+        v.x * m.x.w + v.y * m.y.w + v.z * m.z.w + v.w * m.w.w
+    );
+}
+
+template<int N> inline TVec3x<N> HApply(const TVec3x<N>& v, const TMat4& m)
+{
+    return TVec3x<N>
+    (
+        v.x * m.x.x + v.y * m.y.x + v.z * m.z.x + m.w.x,
+        v.x * m.x.y + v.y * m.y.y + v.z * m.z.y + m.w.y,
+        v.x * m.x.z + v.y * m.y.z + v.z * m.z.z + m.w.z
+    );
+}
+
+template<int N> inline TVec3x<N> HApply(const TMat4& m, const TVec3x<N>& v)
+{
+    return TVec3x<N>
+    (
+        v.x * m.x.x + v.y * m.x.y + v.z * m.x.z + m.x.w,
+        v.x * m.y.x + v.y * m.y.y + v.z * m.y.z + m.y.w,
+        v.x * m.z.x + v.y * m.z.y + v.z * m.z.z + m.z.w
+    );
+}
+
+template<int N> inline TVec3x<N> HApply(const TMat34& m, const TVec3x<N>& v)
+{
+    return TVec3x<N>
+    (
+        v.x * m.x.x + v.y * m.x.y + v.z * m.x.z + m.x.w,
+        v.x * m.y.x + v.y * m.y.y + v.z * m.y.z + m.y.w,
+        v.x * m.z.x + v.y * m.z.y + v.z * m.z.z + m.z.w
+    );
+}
+
+template<int N> inline TVec3x<N> HApplyVector(const TMat34& m, const TVec3x<N>& v)
+{
+    return TVec3x<N>
+    (
+        v.x * m.x.x + v.y * m.x.y + v.z * m.x.z,
+        v.x * m.y.x + v.y * m.y.y + v.z * m.y.z,
+        v.x * m.z.x + v.y * m.z.y + v.z * m.z.z
+    );
+}
+
+template<int N> inline TVec3x<N> HProj(const TVec3x<N>& v, const TMat4& m)
+{
+    return proj(TVec4x<N>(v, VLLanes<TElt, N>(TElt(vl_one))) * m);
+}
+
+template<int N> inline TVec3x<N> HProj(const TMat4& m, const TVec3x<N>& v)
+{
+    return proj(m * TVec4x<N>(v, VLLanes<TElt, N>(TElt(vl_one))));
+}
+
+#ifdef VL_ROW_ORIENT
+template<int N> inline TVec3x<N> xform(const TMat3& m, const TVec3x<N>& v)
+{ return v * m; }
+template<int N> inline TVec3x<N> xform(const TMat4& m, const TVec3x<N>& v)
+{ return HProj(v, m); }
+template<int N> inline TVec4x<N> xform(const TMat4& m, const TVec4x<N>& v)
+{ return v * m; }
+#else
+template<int N> inline TVec3x<N> xform(const TMat3& m, const TVec3x<N>& v)
+{ return m * v; }
+template<int N> inline TVec3x<N> xform(const TMat4& m, const TVec3x<N>& v)
+{ return HProj(m, v); }
+template<int N> inline TVec4x<N> xform(const TMat4& m, const TVec4x<N>& v)
+{ return m * v; }
+#endif
+
+
+// Quaternions
+
+template<int N> inline TVec3x<N> QuatApply(const TVec3x<N>& p, const TVec4x<N>& q)
+{
+    TVec3x<N> qv = q.AsVec3();
+    TVec3x<N> b0 = cross(qv, p);
+    TVec3x<N> b1 = cross(qv, b0);
+
+    return p + TElt(2) * (b0 * q.w + b1);
+}
+
+template<int N> inline TVec4x<N> QuatMult(const TVec4x<N>& a, const TVec4x<N>& b)
+{
+    return TVec4x<N>
+    (
+        a.w * b.x + a.z * b.y - a.y * b.z + a.x * b.w,
+        a.w * b.y - a.z * b.x + a.x * b.z + a.y * b.w,
+        a.y * b.x - a.x * b.y + a.w * b.z + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    );
+}
+
+template<int N> inline TVec4x<N> NLerp(const TVec4x<N>& q1, const TVec4x<N>& q2, TElt s)
+{
+    TVec4x<N> q = q1 + (q2 - q1) * s;
+    return q * ((TElt(3) - sqrlen(q)) * TElt(0.5));   // FastRenormalize
+}
+
+#endif
@@ -25,9 +25,12 @@
 #include "VL/Mat2.hpp"
 #include "VL/Mat3.hpp"
 #include "VL/Mat4.hpp"
+#include "VL/Mat34.hpp"
 
 #include "VL/Quat.hpp"
 #include "VL/Transform.hpp"
+#include "VL/Factor3.hpp"
+#include "VL/Wide.hpp"
 
 #include "VL/Print234.hpp"
 #include "VL/Stream234.hpp"
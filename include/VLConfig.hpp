@@ -21,6 +21,10 @@
 //  VL_NEW         - Hook for redirecting memory allocations
 //  VL_DELETE      - Ditto for free
 //  VL_SINCOS      - Specify sincos function
+//  VL_NO_SIMD     - Disable the runtime-selected SIMD kernels for Vec operations
+//  VL_SIMD        - Use SSE/NEON for Mat4f operations. Aligns Vec4f to 16 bytes,
+//                   so must be set consistently for all code using VL.
+//  VL_NO_THREADS  - Exclude the thread pool used for large operations (see vl_set_threads)
 //
 
 // --- Configuration ----------------------------------------------------------
@@ -30,3 +34,5 @@
 
 // #define VL_ASSERT_FULL MY_ASSERT_FULL
 // #define VL_EXPECT_FULL MY_EXPECT_FULL
+
+// #define VL_SIMD
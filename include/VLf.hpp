@@ -28,9 +28,12 @@
     #include "VL/Mat2.hpp"
     #include "VL/Mat3.hpp"
     #include "VL/Mat4.hpp"
+    #include "VL/Mat34.hpp"
     
     #include "VL/Quat.hpp"
     #include "VL/Transform.hpp"
+    #include "VL/Factor3.hpp"
+    #include "VL/Wide.hpp"
 
     #include "VL/Print234.hpp"
     #include "VL/Stream234.hpp"
@@ -42,6 +45,7 @@
 #include "VL/Vec.hpp"
 #include "VL/Mat.hpp"
 #include "VL/Vol.hpp"
+#include "VL/SparseMat.hpp"
 
 #include "VL/Solve.hpp"
 #include "VL/Factor.hpp"
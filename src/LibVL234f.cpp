@@ -19,8 +19,10 @@
 #include "VL/Mat2.cpp"
 #include "VL/Mat3.cpp"
 #include "VL/Mat4.cpp"
+#include "VL/Mat34.cpp"
 
 #include "VL/Transform.cpp"
+#include "VL/Factor3.cpp"
 
 #include "VL/Print234.cpp"
 #include "VL/Stream234.cpp"
@@ -12,12 +12,16 @@
 
 #include "VL/Begin.hpp"
 
+#include "VL/Constants.hpp"
+
 #include "VL/Vec.cpp"
 #include "VL/VecSlice.cpp"
 
 #include "VL/Mat.cpp"
 #include "VL/MatSlice.cpp"
 
+#include "VL/SparseMat.cpp"
+
 #include "VL/Solve.cpp"
 #include "VL/Factor.cpp"
 
@@ -12,17 +12,15 @@
 
 #include "VL/Begin.hpp"
 
+#include "VL/Constants.hpp"
+
 #include "VL/Vec.cpp"
 #include "VL/VecSlice.cpp"
 
 #include "VL/Mat.cpp"
 #include "VL/MatSlice.cpp"
 
-#include "VL/SparseVec.cpp"
-#include "VL/SubSVec.cpp"
-
 #include "VL/SparseMat.cpp"
-#include "VL/SubSMat.cpp"
 
 #include "VL/Solve.cpp"
 #include "VL/Factor.cpp"
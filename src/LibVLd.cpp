@@ -19,9 +19,11 @@
 #include "VL/Mat2.cpp"
 #include "VL/Mat3.cpp"
 #include "VL/Mat4.cpp"
+#include "VL/Mat34.cpp"
 
 #include "VL/Quat.cpp"
 #include "VL/Transform.cpp"
+#include "VL/Factor3.cpp"
 
 #include "VL/Print234.cpp"
 #include "VL/Stream234.cpp"
@@ -35,6 +37,8 @@
 #include "VL/Vol.cpp"
 #include "VL/VolSlice.cpp"
 
+#include "VL/SparseMat.cpp"
+
 #include "VL/Solve.cpp"
 #include "VL/Factor.cpp"
 
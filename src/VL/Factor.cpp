@@ -7,9 +7,59 @@
 */
 
 #include "VL/Factor.hpp"
+#include "Threads.cpp"
 
 // We must #ifndef all calls that don't mix TMat + TVec with VL_MIXED
 
+namespace
+{
+    void ApplyLeftHouseholders(TConstRefMat A, int count, TRefMat U)
+    // Sets U = H_0 H_1 .. H_count-1 U, where H_i is the Householder
+    // transform left in column i of A by LeftHouseholder().
+    {
+        const int m = A.Rows();
+        const int n = U.Cols();
+
+        TMVec t(n);
+
+        for (int i = count - 1; i >= 0; i--)
+        {
+            // H = I - w wt / g, and g = |w|^2 / 2
+            TMElt g = 0;
+            for (int k = i; k < m; k++)
+                g += sqr(A[k][i]);
+
+            if (g == 0)
+                continue;
+
+            g /= 2;
+
+            // t = wt U / g, working along U's rows, in place to avoid
+            // temporaries
+            t.MakeZero();
+            for (int k = i; k < m; k++)
+            {
+                TMElt        w  = A[k][i];
+                const TMElt* uk = U[k].data;
+
+                for (int j = 0; j < n; j++)
+                    t[j] += w * uk[j];
+            }
+
+            t /= g;
+
+            for (int k = i; k < m; k++)
+            {
+                TMElt  w  = A[k][i];
+                TMElt* uk = U[k].data;
+
+                for (int j = 0; j < n; j++)
+                    uk[j] -= w * t[j];
+            }
+        }
+    }
+}
+
 #ifndef VL_MIXED
 TMElt QRFactorization(TRefMat A, TMat& Q, TMat& R)
 // Factor A into an orthogonal matrix Q and an upper-triangular matrix R.
@@ -17,136 +67,2084 @@ TMElt QRFactorization(TRefMat A, TMat& Q, TMat& R)
 {
     VL_ASSERT_MSG(A.Rows() >= A.Cols(), "matrix must have rows >= cols");
 
-    Q.SetSize(A.Rows(), A.Cols());
-    R.SetSize(A.Cols(), A.Cols());
+    Q.SetSize(A.Rows(), A.Cols());
+    R.SetSize(A.Cols(), A.Cols());
+
+    return QRFactorization(A, (TRefMat) Q, (TRefMat) R);
+}
+
+TMElt QRFactorization(TRefMat A, TRefMat Q, TRefMat R)
+// Factor A into an orthogonal matrix Q and an upper-triangular matrix R.
+// Destroys A.
+{
+    VL_ASSERT_MSG(A.Rows() >= A.Cols(), "matrix must have rows >= cols");
+    VL_ASSERT_MSG(Q.Rows() == A.Rows() && Q.Cols() == A.Cols(), "Q size mismatch");
+    VL_ASSERT_MSG(R.Rows() == A.Cols() && R.Cols() == A.Cols(), "R size mismatch");
+
+    // Q is formed directly in its m x n form, from the blocked factors
+    TQRFactor qr(A);
+
+    Q = qr.Q();
+    R = qr.R();
+
+    TMElt normAcc = vl_0;
+
+    for (int i = 0; i < A.Cols(); i++)
+        normAcc = vl_max(normAcc, TMElt(abs(R(i, i))));
+
+    return normAcc;
+}
+
+/*
+    NOTE
+
+    For a tall matrix, rows >= kSVDQRRatio * cols, it's cheaper to first
+    factor A = Q R, and then find the SVD of the small n x n R = Ur D Vt,
+    as bidiagonalizing R is independent of the number of rows. Then
+    A = (Q Ur) D Vt. Q is never formed: it's applied directly to Ur to
+    find U. (The cross-over ratio follows LAPACK's xGESVD.)
+
+    Whichever way we go, the only m-row matrices allocated are U itself,
+    and the QR factors, and if only the singular values are wanted, U and
+    V aren't touched at all.
+
+    The alternative to Golub-Kahan is one-sided Jacobi (Hestenes, 1958).
+    This applies plane rotations to pairs of columns of A until they're
+    all mutually orthogonal, so A V = U D, where the column norms are D.
+    Each rotation only touches its own two columns, so with a round-robin
+    ordering, a step of n/2 disjoint pairs can run across threads. We work
+    on At, and Vt, so that the columns are unit-stride rows. Because each
+    rotation is computed from the columns themselves, rather than from a
+    bidiagonal form with errors relative to |A|, small singular values are
+    found to high relative accuracy (Demmel & Veselic, 1992).
+*/
+
+namespace
+{
+    const TMElt kSVDQRRatio       = TMElt(1.6);
+    const int   kJacobiMaxSweeps  = 40;
+    const TElt  kJacobiEpsilon    = sizeof(TElt) > 4 ? TElt(vld_eps) : TElt(vlf_eps);
+
+    bool SVDUseQR(TConstRefMat A)
+    {
+        return A.Rows() >= kSVDQRRatio * A.Cols() && A.Cols() > 0;
+    }
+
+    bool JacobiRotate(TRefVec a, TRefVec b, TRefMat Vt, int p, int q, TElt tolerance)
+    // Rotates a and b, which are columns p and q, to be orthogonal, applying
+    // the same rotation to rows p and q of Vt. Returns false if they
+    // already were.
+    {
+        TElt alpha = sqrlen(a);
+        TElt beta  = sqrlen(b);
+        TElt gamma = dot(a, b);
+
+        if (abs(gamma) <= tolerance * sqrt(alpha * beta))
+            return false;
+
+        TElt zeta = (beta - alpha) / (2 * gamma);
+        TElt t = (zeta >= 0 ? 1 : -1) / (abs(zeta) + sqrt(1 + zeta * zeta));
+        TElt c = 1 / sqrt(1 + t * t);
+        TElt s = c * t;
+
+        const int m = a.Elts();
+        TElt* ad = a.Ref();
+        TElt* bd = b.Ref();
+
+        for (int k = 0; k < m; k++)
+        {
+            TElt x = ad[k];
+            TElt y = bd[k];
+
+            ad[k] = c * x - s * y;
+            bd[k] = s * x + c * y;
+        }
+
+        if (!Vt.IsNull())
+        {
+            const int n = Vt.Cols();
+            TElt* vp = Vt[p].Ref();
+            TElt* vq = Vt[q].Ref();
+
+            for (int k = 0; k < n; k++)
+            {
+                TElt x = vp[k];
+                TElt y = vq[k];
+
+                vp[k] = c * x - s * y;
+                vq[k] = s * x + c * y;
+            }
+        }
+
+        return true;
+    }
+
+    void JacobiSVD(TConstRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal)
+    // U and V may be null, in which case only the singular values are found
+    {
+        const int m = A.Rows();
+        const int n = A.Cols();
+        const int slots = n + (n & 1);     // round-robin positions, one a bye if n is odd
+        const int pairs = slots / 2;
+
+        TMat At(n, m);
+        Transpose(A, At);
+
+        TMat Vt;
+        if (!V.IsNull())
+            Vt.SetSize(n, n), Vt = vl_I;
+
+        std::vector<int>  order(slots);
+        std::vector<char> rotated(pairs);
+
+        for (int i = 0; i < slots; i++)
+            order[i] = i;
+
+        const TElt tolerance = sqrt(TElt(m)) * kJacobiEpsilon;
+        const double pairWork = 6.0 * (m + (V.IsNull() ? 0 : n));
+
+        for (int sweep = 0; sweep < kJacobiMaxSweeps; sweep++)
+        {
+            bool any = false;
+
+            for (int step = 0; step < slots - 1; step++)
+            {
+                vl_parallel_for(kVLThreadInvert, pairWork * pairs, pairs, vl_grain(pairWork),
+                    [&](int begin, int end)
+                    {
+                        for (int i = begin; i < end; i++)
+                        {
+                            int p = vl_min(order[i], order[slots - 1 - i]);
+                            int q = vl_max(order[i], order[slots - 1 - i]);
+
+                            rotated[i] = q < n && JacobiRotate(At[p], At[q], Vt, p, q, tolerance);
+                        }
+                    }
+                );
+
+                for (int i = 0; i < pairs; i++)
+                    any = any || rotated[i];
+
+                // Keep position 0 fixed, and cycle the rest
+                int last = order[slots - 1];
+
+                for (int i = slots - 1; i > 1; i--)
+                    order[i] = order[i - 1];
+
+                order[1] = last;
+            }
+
+            if (!any)
+                break;
+        }
+
+        for (int i = 0; i < n; i++)
+            diagonal[i] = len(At[i]);
+
+        if (U.IsNull())
+            return;
+
+        Transpose(Vt, V);
+
+        // The columns of U are the normalized columns of A V. Any with no
+        // length are filled out with unit vectors orthogonal to the rest.
+        TElt small = 0;
+
+        for (int i = 0; i < n; i++)
+            small = vl_max(small, TElt(diagonal[i]));
+
+        small *= kJacobiEpsilon;
+
+        for (int i = 0; i < n; i++)
+            if (diagonal[i] > small)
+                At[i] /= diagonal[i];
+
+        for (int i = 0, e = 0; i < n; i++)
+        {
+            if (diagonal[i] > small)
+                continue;
+
+            TRefVec u(At[i]);
+            TElt    ul = 0;
+
+            for ( ; e < m && ul < TElt(0.5); e++)
+            {
+                u.MakeZero();
+                u[e] = 1;
+
+                for (int pass = 0; pass < 2; pass++)
+                    for (int j = 0; j < n; j++)
+                        if (j != i && (diagonal[j] > small || j < i))
+                            u -= dot(u, At[j]) * At[j];
+
+                ul = len(u);
+            }
+
+            if (ul >= TElt(0.5))
+                u /= ul;
+            else
+                u.MakeZero();   // A is wide, so there's no room left
+        }
+
+        Transpose(At, U);
+    }
+
+    void SVDDirect(TRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal, VLSVDMethod method)
+    // U and V may be null
+    {
+        if (method == kVLSVDJacobi)
+        {
+            JacobiSVD(A, U, V, diagonal);
+            return;
+        }
+
+        TVec superDiag(A.Cols() - 1);
+
+        // Find the bidiagonal matrix, and then eliminate the
+        // elements above the diagonal to get the final
+        // result.
+        Bidiagonalize(A, U, V, diagonal, superDiag);
+        Diagonalize  (         diagonal, superDiag, U, V);
+    }
+
+    void SVDViaQR(TConstRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal, VLSVDMethod method)
+    // U may be null, in which case so must V be.
+    {
+        const int n = A.Cols();
+
+        TQRFactor qr(A);
+        TMat R(qr.R());
+
+        if (U.IsNull())
+        {
+            SVDDirect(R, TRefMat(), TRefMat(), diagonal, method);
+            return;
+        }
+
+        // Ur goes in the top n rows of U, ready for U = Q [Ur 0]t
+        TRefMat Ur(n, n, U.Ref());
+
+        SVDDirect(R, Ur, V, diagonal, method);
+
+        TRefMat(U.Rows() - n, n, U.Ref() + n * n) = vl_0;
+
+        qr.ApplyQ(U);
+    }
+}
+
+void SVDFactorization(TRefMat A, TMat& U, TMat& V, TMVec& diagonal, VLSVDMethod method)
+{
+    diagonal.SetSize(A.Cols());
+
+    U.SetSize(A.Rows(), A.Cols());
+    V.SetSize(A.Cols(), A.Cols());
+
+    SVDFactorization(A, TRefMat(U), TRefMat(V), TRefVec(diagonal), method);
+}
+
+void SVDFactorization(TRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal, VLSVDMethod method)
+{
+    VL_ASSERT(diagonal.Elts() == A.Cols());
+    VL_ASSERT(same_size(U, A));
+    VL_ASSERT(is_square(V) && V.Cols() == A.Cols());
+
+    if (SVDUseQR(A))
+        SVDViaQR(A, U, V, diagonal, method);
+    else
+        SVDDirect(A, U, V, diagonal, method);
+}
+
+void SVDFactorization(TRefMat A, TMVec& diagonal, VLSVDMethod method)
+{
+    diagonal.SetSize(A.Cols());
+
+    SVDFactorization(A, TRefVec(diagonal), method);
+}
+
+void SVDFactorization(TRefMat A, TMRefVec diagonal, VLSVDMethod method)
+{
+    VL_ASSERT(diagonal.Elts() == A.Cols());
+
+    if (SVDUseQR(A))
+        SVDViaQR(A, TRefMat(), TRefMat(), diagonal, method);
+    else
+        SVDDirect(A, TRefMat(), TRefMat(), diagonal, method);
+}
+#endif
+
+#ifndef VL_MIXED
+// --- Cholesky factorization -------------------------------------------------
+
+/*
+    NOTE
+
+    As with LU, the factorization is blocked and right-looking. For each
+    block column of kCholBlock columns, we factor the diagonal block with
+    the simple algorithm, solve for the panel below it, L21 = A21 L11^-t,
+    and then update the lower half of the trailing matrix,
+    A22 -= L21 L21t. The panel rows are independent, as are the block
+    columns of the trailing update, so those are the tasks that are split
+    across threads. Each trailing block column is a matrix product, so
+    the bulk of the work is done by the packed Multiply kernel.
+
+    The triangular solves with many right-hand sides are blocked the same
+    way as LUFactor::Solve().
+*/
+
+namespace
+{
+    const int kCholBlock = 64;
+
+    bool FactorCholDiag(TRefMat L, int k0, int nb)
+    // Unblocked Cholesky of the diagonal block at k0, in place, reading only
+    // its lower half.
+    {
+        for (int j = k0; j < k0 + nb; j++)
+        {
+            TElt* lj = L.data + j * L.cols;
+            TElt  d = lj[j];
+
+            for (int k = k0; k < j; k++)
+                d -= sqr(lj[k]);
+
+            if (d <= 0)
+                return false;
+
+            d = sqrt(d);
+            lj[j] = d;
+
+            for (int i = j + 1; i < k0 + nb; i++)
+            {
+                TElt* li = L.data + i * L.cols;
+                TElt  s = li[j];
+
+                for (int k = k0; k < j; k++)
+                    s -= li[k] * lj[k];
+
+                li[j] = s / d;
+            }
+        }
+
+        return true;
+    }
+
+    void SolveLowerBlock(TConstRefMat L, int i0, int nb, TSliceMat X)
+    // Solves L[i0 .. i0 + nb][i0 .. i0 + nb] X' = X in place
+    {
+        for (int i = 0; i < nb; i++)
+        {
+            TRefVec xi(X.cols, X.data + i * X.rspan);
+
+            for (int j = 0; j < i; j++)
+                MultiplyAccum(TConstRefVec(X.cols, X.data + j * X.rspan), -L(i0 + i, i0 + j), xi);
+
+            xi /= L(i0 + i, i0 + i);
+        }
+    }
+
+    void SolveLowerTBlock(TConstRefMat L, int i0, int nb, TSliceMat X)
+    // Solves trans(L[i0 .. i0 + nb][i0 .. i0 + nb]) X' = X in place
+    {
+        for (int i = nb - 1; i >= 0; i--)
+        {
+            TRefVec xi(X.cols, X.data + i * X.rspan);
+
+            for (int j = i + 1; j < nb; j++)
+                MultiplyAccum(TConstRefVec(X.cols, X.data + j * X.rspan), -L(i0 + j, i0 + i), xi);
+
+            xi /= L(i0 + i, i0 + i);
+        }
+    }
+}
+
+bool Cholesky(TConstRefMat A, TRefMat L)
+// Factors symmetric positive definite matrix 'A' into L Lt, where
+// L is lower triangular.
+{
+    VL_ASSERT_MSG(is_square(A), "(Cholesky) matrix must be square");
+    VL_ASSERT_MSG(same_size(L, A), "(Cholesky) L has the wrong size");
+
+    const int n = A.Rows();
+
+    if (L.data != A.data)
+        L = A;
+
+    for (int k0 = 0; k0 < n; k0 += kCholBlock)
+    {
+        int nb = vl_min(kCholBlock, n - k0);
+        int kEnd = k0 + nb;
+        int m = n - kEnd;
+
+        if (!FactorCholDiag(L, k0, nb))
+            return false;
+
+        if (m == 0)
+            break;
+
+        // L21 = A21 L11^-t, row by row
+        vl_parallel_for(kVLThreadInvert, double(m) * nb * nb / 2, m, vl_grain(double(nb) * nb / 2),
+            [&](int begin, int end)
+            {
+                for (int i = kEnd + begin; i < kEnd + end; i++)
+                {
+                    TElt* li = L.data + i * L.cols;
+
+                    for (int j = k0; j < kEnd; j++)
+                    {
+                        const TElt* lj = L.data + j * L.cols;
+                        TElt s = li[j];
+
+                        for (int k = k0; k < j; k++)
+                            s -= li[k] * lj[k];
+
+                        li[j] = s / lj[j];
+                    }
+                }
+            }
+        );
+
+        // A22 -= L21 L21t, lower half only, by block columns. (Taking a
+        // copy of L21t keeps the products' operands clear of their results.)
+        TMat L21t(trans(sub(L, kEnd, k0, m, nb)));
+        int  blocks = (m + kCholBlock - 1) / kCholBlock;
+
+        vl_parallel_for(kVLThreadInvert, double(m) * m * nb / 2, blocks, 1,
+            [&](int begin, int end)
+            {
+                for (int jb = begin; jb < end; jb++)
+                {
+                    int j0 = jb * kCholBlock;
+                    int jn = vl_min(kCholBlock, m - j0);
+
+                    MultiplyAccum(sub(L, kEnd + j0, k0, m - j0, nb), sub(L21t, 0, j0, nb, jn), TElt(vl_minus_one), sub(L, kEnd + j0, kEnd + j0, m - j0, jn));
+                }
+            }
+        );
+    }
+
+    // Clear the upper half, which the diagonal blocks of the trailing
+    // updates will have written to
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            L(i, j) = TElt(vl_zero);
+
+    return true;
+}
+
+void SolveLower(TConstRefMat L, TRefMat X)
+{
+    VL_ASSERT_MSG(is_square(L), "(SolveLower) L must be square");
+    VL_ASSERT_MSG(X.Rows() == L.Rows(), "(SolveLower) X has the wrong size");
+
+    const int n = L.Rows();
+    const int k = X.Cols();
+
+    for (int i0 = 0; i0 < n; i0 += kCholBlock)
+    {
+        int nb = vl_min(kCholBlock, n - i0);
+
+        if (i0 > 0)
+            MultiplyAccum(sub(L, i0, 0, nb, i0), sub(X, 0, 0, i0, k), TElt(vl_minus_one), sub(X, i0, 0, nb, k));
+
+        SolveLowerBlock(L, i0, nb, sub(X, i0, 0, nb, k));
+    }
+}
+
+void SolveLowerT(TConstRefMat L, TRefMat X)
+{
+    VL_ASSERT_MSG(is_square(L), "(SolveLowerT) L must be square");
+    VL_ASSERT_MSG(X.Rows() == L.Rows(), "(SolveLowerT) X has the wrong size");
+
+    const int n = L.Rows();
+    const int k = X.Cols();
+
+    for (int i1 = n; i1 > 0; i1 -= kCholBlock)
+    {
+        int nb = vl_min(kCholBlock, i1);
+        int i0 = i1 - nb;
+
+        if (i1 < n)
+            MultiplyAccum(transpose(sub(L, i1, i0, n - i1, nb)), sub(X, i1, 0, n - i1, k), TElt(vl_minus_one), sub(X, i0, 0, nb, k));
+
+        SolveLowerTBlock(L, i0, nb, sub(X, i0, 0, nb, k));
+    }
+}
+
+void BacksolveLLt(TConstRefMat L, TRefMat X, TConstRefMat B)
+{
+    VL_ASSERT_MSG(same_size(X, B), "(BacksolveLLt) X has the wrong size");
+
+    if (X.data != B.data)
+        X = B;
+
+    SolveLower (L, X);
+    SolveLowerT(L, X);
+}
+
+/*
+    NOTE
+
+    A rank-one update, L' L't = L Lt + v vt, can be found by applying the
+    Givens rotations that zero v against the columns of [L v]. A downdate
+    is the same with hyperbolic rotations, which can fail if A - v vt
+    isn't positive definite. Both are O(n^2). [Golub & Van Loan, "Matrix
+    Computations", 4th ed., 2013, sec. 6.5.4]
+
+    Before downdating we check that |L^-1 v| < 1, which holds exactly when
+    A - v vt is positive definite, so that we never leave a half-updated
+    L behind. [Dongarra et al., "LINPACK Users' Guide", 1979, ch. 10]
+*/
+
+void CholeskyUpdate(TRefMat L, TConstRefVec v)
+{
+    VL_ASSERT_MSG(is_square(L), "(CholeskyUpdate) L must be square");
+    VL_ASSERT_MSG(v.Elts() == L.Rows(), "(CholeskyUpdate) v has the wrong size");
+
+    const int n = L.Rows();
+    TVec x(v);
+
+    for (int k = 0; k < n; k++)
+    {
+        TElt lkk = L(k, k);
+        TElt r = sqrt(sqr(lkk) + sqr(x[k]));
+        TElt c = r / lkk;
+        TElt s = x[k] / lkk;
+
+        L(k, k) = r;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            L(i, k) = (L(i, k) + s * x[i]) / c;
+            x[i] = c * x[i] - s * L(i, k);
+        }
+    }
+}
+
+bool CholeskyDowndate(TRefMat L, TConstRefVec v)
+{
+    VL_ASSERT_MSG(is_square(L), "(CholeskyDowndate) L must be square");
+    VL_ASSERT_MSG(v.Elts() == L.Rows(), "(CholeskyDowndate) v has the wrong size");
+
+    const int n = L.Rows();
+
+    // Check |L^-1 v| < 1 first
+    TVec p(n);
+
+    for (int i = 0; i < n; i++)
+        p[i] = (v[i] - dot(TConstRefVec(i, L[i].data), TConstRefVec(i, p.data))) / L(i, i);
+
+    if (sqrlen(p) >= TElt(vl_one))
+        return false;
+
+    TVec x(v);
+
+    for (int k = 0; k < n; k++)
+    {
+        TElt lkk = L(k, k);
+        TElt r = sqrt((lkk - x[k]) * (lkk + x[k]));
+        TElt c = r / lkk;
+        TElt s = x[k] / lkk;
+
+        L(k, k) = r;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            L(i, k) = (L(i, k) - s * x[i]) / c;
+            x[i] = c * x[i] - s * L(i, k);
+        }
+    }
+
+    return true;
+}
+#endif
+
+void BacksolveLLt(TConstRefMat L, TRefVec x, TConstRefVec b)
+// Given 'L' from a Cholesky decomposition, solve L Lt x = b.
+{
+    VL_ASSERT(is_square(L));
+    VL_ASSERT(b.Elts() == L.Rows());
+    VL_ASSERT(x.Elts() == L.Rows());
+
+    const int n = L.Rows();
+
+    // Solve L x' = b
+    for (int i = 0; i < n; i++)
+    {
+        TMElt sum = 0;
+
+        for (int j = 0; j < i; j++)
+            sum += L(i, j) * x[j];
+
+        x[i] = TElt((b[i] - sum) / L(i, i));
+    }
+
+    // Solve Lt x = x'
+    for (int i = n - 1; i >= 0; i--)
+    {
+        TMElt sum = 0;
+
+        for (int j = i + 1; j < n; j++)
+            sum += L(j, i) * x[j];
+
+        x[i] = TElt((x[i] - sum) / L(i, i));
+    }
+}
+
+#ifndef VL_MIXED
+// --- LU factorization -------------------------------------------------------
+
+/*
+    NOTE
+
+    The factorization is blocked and right-looking: for each panel of
+    kLUBlock columns we first factor the panel itself with the simple
+    algorithm (including the pivot search), then solve for the matching
+    block row of U, and finally update the trailing sub-matrix with a
+    single matrix product, A22 -= L21 U12. That product accounts for almost
+    all of the flops, and goes through the packed (and possibly threaded)
+    Multiply kernel.
+
+    Row swaps are applied across the full width of the matrix as they're
+    found, so the stored factors are exactly P A = L U.
+*/
+
+namespace
+{
+    const int kLUBlock = 64;
+
+    inline void SwapRows(TRefMat A, int i, int j)
+    {
+        TElt* ai = A.data + i * A.cols;
+        TElt* aj = A.data + j * A.cols;
+
+        for (int k = 0; k < A.cols; k++)
+        {
+            TElt t = ai[k];
+            ai[k] = aj[k];
+            aj[k] = t;
+        }
+    }
+
+    void FactorPanel(TRefMat A, int k0, int nb, TElt epsilon, int* pivots, int* sign, bool* singular)
+    // Unblocked LU of columns k0 .. k0 + nb of A, rows k0 onwards
+    {
+        const int n = A.Rows();
+        const int kEnd = k0 + nb;
+
+        for (int j = k0; j < kEnd; j++)
+        {
+            int  p = j;
+            TElt pMax = abs(A(j, j));
+
+            for (int i = j + 1; i < n; i++)
+                if (abs(A(i, j)) > pMax)
+                {
+                    pMax = abs(A(i, j));
+                    p = i;
+                }
+
+            pivots[j] = p;
+
+            if (p != j)
+            {
+                SwapRows(A, p, j);
+                *sign = -*sign;
+            }
+
+            if (pMax <= epsilon)
+            {
+                *singular = true;
+
+                if (pMax == TElt(vl_0))
+                    continue;   // nothing to eliminate
+            }
+
+            const TElt* aj = A.data + j * A.cols;
+            TElt pivot = aj[j];
+
+            for (int i = j + 1; i < n; i++)
+            {
+                TElt* ai = A.data + i * A.cols;
+                TElt lij = (ai[j] /= pivot);
+
+                for (int k = j + 1; k < kEnd; k++)
+                    ai[k] -= lij * aj[k];
+            }
+        }
+    }
+
+    void SolveUnitLower(TConstRefMat L, int i0, int nb, TSliceMat X)
+    // Solves L[i0 .. i0 + nb][i0 .. i0 + nb] X' = X in place, with L unit lower triangular
+    {
+        for (int i = 1; i < nb; i++)
+        {
+            TRefVec xi(X.cols, X.data + i * X.rspan);
+
+            for (int j = 0; j < i; j++)
+                MultiplyAccum(TConstRefVec(X.cols, X.data + j * X.rspan), -L(i0 + i, i0 + j), xi);
+        }
+    }
+
+    void SolveUpper(TConstRefMat U, int i0, int nb, TSliceMat X)
+    // Solves U[i0 .. i0 + nb][i0 .. i0 + nb] X' = X in place, with U upper triangular
+    {
+        for (int i = nb - 1; i >= 0; i--)
+        {
+            TRefVec xi(X.cols, X.data + i * X.rspan);
+
+            for (int j = i + 1; j < nb; j++)
+                MultiplyAccum(TConstRefVec(X.cols, X.data + j * X.rspan), -U(i0 + i, i0 + j), xi);
+
+            xi /= U(i0 + i, i0 + i);
+        }
+    }
+}
+
+TLUFactor::TLUFactor() : sign(1), singular(true)
+{
+}
+
+TLUFactor::TLUFactor(TConstRefMat A, TElt epsilon) : sign(1), singular(true)
+{
+    Factor(A, epsilon);
+}
+
+bool TLUFactor::Factor(TConstRefMat A, TElt epsilon)
+{
+    VL_ASSERT_MSG(is_square(A), "(LUFactor) matrix must be square");
+
+    const int n = A.Rows();
+
+    lu.SetSize(A);
+    lu = A;
+    pivots.resize(n);
+    sign = 1;
+    singular = false;
+
+    for (int k0 = 0; k0 < n; k0 += kLUBlock)
+    {
+        int nb = vl_min(kLUBlock, n - k0);
+        int kEnd = k0 + nb;
+        int m = n - kEnd;
+
+        FactorPanel(lu, k0, nb, epsilon, pivots.data(), &sign, &singular);
+
+        if (m == 0)
+            break;
+
+        // U12 = L11^-1 A12
+        SolveUnitLower(lu, k0, nb, sub(lu, k0, kEnd, nb, m));
+
+        // A22 -= L21 U12
+        MultiplyAccum(sub(lu, kEnd, k0, m, nb), sub(lu, k0, kEnd, nb, m), TElt(vl_minus_one), sub(lu, kEnd, kEnd, m, m));
+    }
+
+    return !singular;
+}
+
+bool TLUFactor::IsSingular() const
+{
+    return singular;
+}
+
+int TLUFactor::Size() const
+{
+    return lu.Rows();
+}
+
+void TLUFactor::Solve(TRefVec x, TConstRefVec b) const
+{
+    VL_ASSERT_MSG(b.Elts() == Size(), "(LUFactor::Solve) b has the wrong size");
+    VL_ASSERT_MSG(x.Elts() == Size(), "(LUFactor::Solve) x has the wrong size");
+    VL_EXPECT_MSG(!singular, "(LUFactor::Solve) matrix is singular");
+
+    const int n = Size();
+
+    if (x.data != b.data)
+        x = b;
+
+    for (int i = 0; i < n; i++)
+        if (pivots[i] != i)
+        {
+            TElt t = x[i];
+            x[i] = x[pivots[i]];
+            x[pivots[i]] = t;
+        }
+
+    // L y = P b
+    for (int i = 1; i < n; i++)
+        x[i] -= dot(TConstRefVec(i, lu[i].data), TConstRefVec(i, x.data));
+
+    // U x = y
+    for (int i = n - 1; i >= 0; i--)
+    {
+        int m = n - i - 1;
+        x[i] = (x[i] - dot(TConstRefVec(m, lu[i].data + i + 1), TConstRefVec(m, x.data + i + 1))) / lu(i, i);
+    }
+}
+
+void TLUFactor::Solve(TRefMat X, TConstRefMat B) const
+{
+    VL_ASSERT_MSG(B.Rows() == Size(), "(LUFactor::Solve) B has the wrong size");
+    VL_ASSERT_MSG(same_size(X, B), "(LUFactor::Solve) X has the wrong size");
+    VL_EXPECT_MSG(!singular, "(LUFactor::Solve) matrix is singular");
+
+    const int n = Size();
+    const int k = B.Cols();
+
+    if (X.data != B.data)
+        X = B;
+
+    for (int i = 0; i < n; i++)
+        if (pivots[i] != i)
+            SwapRows(X, i, pivots[i]);
+
+    // Blocked forward and back substitution, so that the bulk of the work
+    // for many right-hand sides is done by matrix products.
+
+    // L Y = P B
+    for (int i0 = 0; i0 < n; i0 += kLUBlock)
+    {
+        int nb = vl_min(kLUBlock, n - i0);
+
+        if (i0 > 0)
+            MultiplyAccum(sub(lu, i0, 0, nb, i0), sub(X, 0, 0, i0, k), TElt(vl_minus_one), sub(X, i0, 0, nb, k));
+
+        SolveUnitLower(lu, i0, nb, sub(X, i0, 0, nb, k));
+    }
+
+    // U X = Y
+    for (int i1 = n; i1 > 0; i1 -= kLUBlock)
+    {
+        int nb = vl_min(kLUBlock, i1);
+        int i0 = i1 - nb;
+
+        if (i1 < n)
+            MultiplyAccum(sub(lu, i0, i1, nb, n - i1), sub(X, i1, 0, n - i1, k), TElt(vl_minus_one), sub(X, i0, 0, nb, k));
+
+        SolveUpper(lu, i0, nb, sub(X, i0, 0, nb, k));
+    }
+}
+
+TVec TLUFactor::Solve(TConstRefVec b) const
+{
+    TVec x(b.Elts());
+    Solve(x, b);
+    return x;
+}
+
+TMat TLUFactor::Solve(TConstRefMat B) const
+{
+    TMat X(B.Rows(), B.Cols());
+    Solve(X, B);
+    return X;
+}
+
+TElt TLUFactor::Det() const
+{
+    TElt det = TElt(sign);
+
+    for (int i = 0; i < Size(); i++)
+        det *= lu(i, i);
+
+    return det;
+}
+
+TMat TLUFactor::Inverse() const
+{
+    TMat result(Size(), Size(), vl_I);
+    Solve(result, result);
+    return result;
+}
+
+TConstRefMat TLUFactor::LU() const
+{
+    return lu;
+}
+
+const int* TLUFactor::Pivots() const
+{
+    return pivots.data();
+}
+#endif
+
+#ifndef VL_MIXED
+// --- QR factorization -------------------------------------------------------
+
+/*
+    NOTE
+
+    This is the blocked Householder QR of LAPACK's xGEQRF. Each panel of
+    kQRBlock columns is factored with the simple algorithm, and its
+    reflectors are then gathered up into the compact WY form,
+
+        H_k0 H_k0+1 .. H_k0+nb-1 = I - V T Vt
+
+    where V holds the reflector vectors as columns, and T is a small upper
+    triangular matrix [Schreiber & Van Loan, "A Storage-Efficient WY
+    Representation for Products of Householder Transformations", 1989].
+    The panel's effect on the rest of A, or on anything Q is applied to,
+    then comes down to three matrix products, V^t X, T (V^t X), and
+    X - V (T V^t X), which go through the packed (and possibly threaded)
+    Multiply kernel, rather than n passes over memory, one per reflector.
+
+    We keep the T for each block, so applying Q later costs the same as
+    one trailing update.
+*/
+
+namespace
+{
+    const int kQRBlock = 32;
+
+    void FactorQRPanel(TRefMat A, int k0, int nb, TElt* tau)
+    // Unblocked QR of columns k0 .. k0 + nb of A, rows k0 onwards
+    {
+        const int m = A.Rows();
+        const int kEnd = k0 + nb;
+
+        TElt s[kQRBlock];
+
+        for (int j = k0; j < kEnd; j++)
+        {
+            // Find H = I - tau v vt, with v[0] = 1, such that H x = [beta 0 ...]
+            TElt scale = TElt(vl_zero);
+            for (int r = j; r < m; r++)
+                scale = vl_max(scale, TElt(abs(A(r, j))));
+
+            if (scale == TElt(vl_zero))
+            {
+                tau[j] = TElt(vl_zero);     // nothing to eliminate, H = I
+                continue;
+            }
+
+            TElt sigma = TElt(vl_zero);
+            for (int r = j + 1; r < m; r++)
+                sigma += sqr(A(r, j) / scale);
+
+            TElt alpha = A(j, j);
+            TElt norm  = scale * sqrt(sqr(alpha / scale) + sigma);
+            TElt beta  = alpha > 0 ? -norm : norm;  // as LeftHouseholder, which always reflects
+
+            tau[j] = (beta - alpha) / beta;
+
+            TElt vScale = TElt(vl_one) / (alpha - beta);
+            for (int r = j + 1; r < m; r++)
+                A(r, j) *= vScale;
+
+            A(j, j) = beta;
+
+            // Apply H to the rest of the panel: A -= tau v (vt A)
+            int w = kEnd - j - 1;
+
+            if (w == 0)
+                continue;
+
+            const TElt* aj = A.data + j * A.cols + j + 1;
+
+            for (int c = 0; c < w; c++)
+                s[c] = aj[c];
+
+            for (int r = j + 1; r < m; r++)
+            {
+                const TElt* ar = A.data + r * A.cols + j + 1;
+                TElt vr = ar[-1];
+
+                for (int c = 0; c < w; c++)
+                    s[c] += vr * ar[c];
+            }
+
+            for (int c = 0; c < w; c++)
+                s[c] *= tau[j];
+
+            for (int c = 0; c < w; c++)
+                A(j, j + 1 + c) -= s[c];
+
+            for (int r = j + 1; r < m; r++)
+            {
+                TElt* ar = A.data + r * A.cols + j + 1;
+                TElt vr = ar[-1];
+
+                for (int c = 0; c < w; c++)
+                    ar[c] -= vr * s[c];
+            }
+        }
+    }
+
+    void FormBlockT(TConstRefMat A, int k0, int nb, const TElt* tau, TSliceMat T)
+    // Finds the upper triangular T for which the block of reflectors in
+    // columns k0 .. k0 + nb of A is I - V T Vt.
+    {
+        const int m = A.Rows();
+        const int kEnd = k0 + nb;
+
+        // G = Vt V, the part below the block via the matrix kernel
+        TMat G(nb, nb, vl_0);
+
+        if (kEnd < m)
+        {
+            TConstSliceMat V2 = sub(A, kEnd, k0, m - kEnd, nb);
+            MultiplyAccum(transpose(V2), V2, TElt(vl_one), G);
+        }
+
+        // ... and the unit lower triangular part
+        for (int i = 0; i < nb; i++)
+            for (int j = 0; j < i; j++)
+            {
+                TElt g = A(k0 + i, k0 + j);
+
+                for (int r = i + 1; r < nb; r++)
+                    g += A(k0 + r, k0 + j) * A(k0 + r, k0 + i);
+
+                G(j, i) += g;
+            }
+
+        // T_i = [T_i-1  -tau_i T_i-1 Vt v_i]
+        //       [  0          tau_i         ]
+        T = vl_0;
+
+        for (int i = 0; i < nb; i++)
+        {
+            TElt ti = tau[k0 + i];
+
+            for (int a = 0; a < i; a++)
+            {
+                TElt s = TElt(vl_zero);
+
+                for (int b = a; b < i; b++)
+                    s += T(a, b) * G(b, i);
+
+                T(a, i) = -ti * s;
+            }
+
+            T(i, i) = ti;
+        }
+    }
+
+    void ApplyBlockReflector(TConstRefMat A, int k0, int nb, TConstSliceMat T, bool transposeT, TSliceMat X)
+    // Applies the block of reflectors in columns k0 .. k0 + nb of A to X,
+    // which holds rows k0 onwards: X = (I - V T Vt) X, or, if transposeT is
+    // set, X = (I - V Tt Vt) X.
+    {
+        const int m = X.Rows();
+        const int k = X.Cols();
+
+        if (k == 0)
+            return;
+
+        // W = Vt X
+        TMat W(nb, k);
+
+        for (int i = 0; i < nb; i++)
+            for (int c = 0; c < k; c++)
+            {
+                TElt w = X(i, c);
+
+                for (int j = i + 1; j < nb; j++)
+                    w += A(k0 + j, k0 + i) * X(j, c);
+
+                W(i, c) = w;
+            }
+
+        if (m > nb)
+            MultiplyAccum(transpose(sub(A, k0 + nb, k0, m - nb, nb)), sub(X, nb, 0, m - nb, k), TElt(vl_one), W);
+
+        // W = T W or Tt W, in place
+        if (transposeT)
+            for (int i = nb - 1; i >= 0; i--)
+            {
+                W[i] *= T(i, i);
+
+                for (int j = 0; j < i; j++)
+                    W[i] += T(j, i) * W[j];
+            }
+        else
+            for (int i = 0; i < nb; i++)
+            {
+                W[i] *= T(i, i);
+
+                for (int j = i + 1; j < nb; j++)
+                    W[i] += T(i, j) * W[j];
+            }
+
+        // X -= V W
+        if (m > nb)
+            MultiplyAccum(sub(A, k0 + nb, k0, m - nb, nb), sub(W, 0, 0, nb, k), TElt(vl_minus_one), sub(X, nb, 0, m - nb, k));
+
+        for (int j = 0; j < nb; j++)
+            for (int c = 0; c < k; c++)
+            {
+                TElt v = W(j, c);
+
+                for (int i = 0; i < j; i++)
+                    v += A(k0 + j, k0 + i) * W(i, c);
+
+                X(j, c) -= v;
+            }
+    }
+
+    void ApplyReflector(TConstRefMat A, const TElt* tau, int j, TRefVec x)
+    // x = H_j x
+    {
+        if (tau[j] == TElt(vl_zero))
+            return;
+
+        const int m = A.Rows();
+
+        TElt s = x[j];
+        for (int r = j + 1; r < m; r++)
+            s += A(r, j) * x[r];
+
+        s *= tau[j];
+
+        x[j] -= s;
+        for (int r = j + 1; r < m; r++)
+            x[r] -= A(r, j) * s;
+    }
+}
+
+TQRFactor::TQRFactor()
+{
+}
+
+TQRFactor::TQRFactor(TConstRefMat A)
+{
+    Factor(A);
+}
+
+void TQRFactor::Factor(TConstRefMat A)
+{
+    VL_ASSERT_MSG(A.Rows() >= A.Cols(), "(QRFactor) matrix must have rows >= cols");
+
+    const int m = A.Rows();
+    const int n = A.Cols();
+
+    qr.SetSize(A);
+    qr = A;
+    tau.SetSize(n);
+    blockT.SetSize(vl_min(kQRBlock, n), n);
+
+    for (int k0 = 0; k0 < n; k0 += kQRBlock)
+    {
+        int nb = vl_min(kQRBlock, n - k0);
+        int kEnd = k0 + nb;
+
+        FactorQRPanel(qr, k0, nb, tau.data);
+        FormBlockT(qr, k0, nb, tau.data, sub(blockT, 0, k0, nb, nb));
+
+        // A2 = Qt_block A2
+        if (kEnd < n)
+            ApplyBlockReflector(qr, k0, nb, sub(blockT, 0, k0, nb, nb), true, sub(qr, k0, kEnd, m - k0, n - kEnd));
+    }
+}
+
+int TQRFactor::Rows() const
+{
+    return qr.Rows();
+}
+
+int TQRFactor::Cols() const
+{
+    return qr.Cols();
+}
+
+void TQRFactor::ApplyQ(TRefVec x) const
+{
+    VL_ASSERT_MSG(x.Elts() == Rows(), "(QRFactor::ApplyQ) x has the wrong size");
+
+    // For a single vector, the reflectors are as good as it gets
+    for (int j = Cols() - 1; j >= 0; j--)
+        ApplyReflector(qr, tau.data, j, x);
+}
+
+void TQRFactor::ApplyQt(TRefVec x) const
+{
+    VL_ASSERT_MSG(x.Elts() == Rows(), "(QRFactor::ApplyQt) x has the wrong size");
+
+    for (int j = 0; j < Cols(); j++)
+        ApplyReflector(qr, tau.data, j, x);
+}
+
+void TQRFactor::ApplyQ(TRefMat X) const
+{
+    VL_ASSERT_MSG(X.Rows() == Rows(), "(QRFactor::ApplyQ) X has the wrong size");
+
+    const int m = Rows();
+    const int n = Cols();
+
+    for (int k0 = ((n - 1) / kQRBlock) * kQRBlock; k0 >= 0; k0 -= kQRBlock)
+    {
+        int nb = vl_min(kQRBlock, n - k0);
+        ApplyBlockReflector(qr, k0, nb, sub(blockT, 0, k0, nb, nb), false, sub(X, k0, 0, m - k0, X.Cols()));
+    }
+}
+
+void TQRFactor::ApplyQt(TRefMat X) const
+{
+    VL_ASSERT_MSG(X.Rows() == Rows(), "(QRFactor::ApplyQt) X has the wrong size");
+
+    const int m = Rows();
+    const int n = Cols();
+
+    for (int k0 = 0; k0 < n; k0 += kQRBlock)
+    {
+        int nb = vl_min(kQRBlock, n - k0);
+        ApplyBlockReflector(qr, k0, nb, sub(blockT, 0, k0, nb, nb), true, sub(X, k0, 0, m - k0, X.Cols()));
+    }
+}
+
+TMat TQRFactor::Q() const
+{
+    TMat result(Rows(), Cols(), vl_I);
+    ApplyQ(result);
+    return result;
+}
+
+TMat TQRFactor::R() const
+{
+    const int n = Cols();
+    TMat result(n, n, vl_0);
+
+    for (int i = 0; i < n; i++)
+        last(result[i], n - i) = last(qr[i], n - i);
+
+    return result;
+}
+
+void TQRFactor::Solve(TRefVec x, TConstRefVec b) const
+{
+    VL_ASSERT_MSG(b.Elts() == Rows(), "(QRFactor::Solve) b has the wrong size");
+    VL_ASSERT_MSG(x.Elts() == Cols(), "(QRFactor::Solve) x has the wrong size");
+
+    const int n = Cols();
+
+    // R x = (Qt b)[0 .. n]
+    TVec y(b);
+    ApplyQt(y);
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        int k = n - i - 1;
+        x[i] = (y[i] - dot(TConstRefVec(k, qr[i].data + i + 1), TConstRefVec(k, x.data + i + 1))) / qr(i, i);
+    }
+}
+
+void TQRFactor::Solve(TRefMat X, TConstRefMat B) const
+{
+    VL_ASSERT_MSG(B.Rows() == Rows(), "(QRFactor::Solve) B has the wrong size");
+    VL_ASSERT_MSG(X.Rows() == Cols() && X.Cols() == B.Cols(), "(QRFactor::Solve) X has the wrong size");
+
+    const int n = Cols();
+
+    TMat Y(B);
+    ApplyQt(Y);
+
+    X = sub(Y, 0, 0, n, B.Cols());
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        for (int j = i + 1; j < n; j++)
+            X[i] -= qr(i, j) * X[j];
+
+        X[i] /= qr(i, i);
+    }
+}
+
+TVec TQRFactor::Solve(TConstRefVec b) const
+{
+    TVec x(Cols());
+    Solve(x, b);
+    return x;
+}
+
+TMat TQRFactor::Solve(TConstRefMat B) const
+{
+    TMat X(Cols(), B.Cols());
+    Solve(X, B);
+    return X;
+}
+
+TConstRefMat TQRFactor::QR() const
+{
+    return qr;
+}
+
+TConstRefVec TQRFactor::Tau() const
+{
+    return tau;
+}
+#endif
+
+#ifndef VL_MIXED
+// --- Symmetric eigen-decomposition ------------------------------------------
+
+/*
+    NOTE
+
+    A is first reduced to tridiagonal form, T = Qt A Q, by Householder
+    transforms applied from both sides, as in Golub & Van Loan 8.3.1. Each
+    H = I - w wt / g zeroes row i beyond the super-diagonal, and, as A
+    stays symmetric, the two-sided update is the rank-2 one
+
+        A' = A - w qt - q wt, where p = A w / g, q = p - (wt p / 2g) w
+
+    which works along A's rows. The w vectors are left in A below the
+    sub-diagonal, in the same form LeftHouseholder() uses, so that
+    ApplyLeftHouseholders() can turn T's eigenvectors into A's.
+
+    T is then diagonalized by the implicit QL algorithm with Wilkinson
+    shifts (the eigenvalue of the leading 2x2 block closer to its top
+    entry), which converges cubically for nearly all matrices. Only this
+    step's rotations need accumulating for the eigenvectors, so the values
+    alone cost O(n^2) after the reduction. The rotations are applied to
+    rows of Vt rather than columns of V to keep the O(n^3) accumulation
+    going along memory.
+*/
+
+namespace
+{
+    void Tridiagonalize(TRefMat A, TRefVec diagonal, TRefVec offDiag)
+    // Reduces symmetric A to tridiagonal form, returning its diagonal, and
+    // the n - 1 elements off it. The Householder vectors are left in A's
+    // columns, starting from the sub-diagonal.
+    {
+        const int n = A.Rows();
+        TVec w(n), p(n);
+
+        for (int i = 0; i < n - 2; i++)
+        {
+            const int m = n - i - 1;
+            TRefVec x(m, A[i].Ref() + i + 1);
+            TRefVec wi(m, w.Ref());
+            TRefVec pi(m, p.Ref());
+
+            diagonal[i] = A(i, i);
+
+            TElt scale = 0;
+            for (int k = 0; k < m; k++)
+                scale += abs(x[k]);
+
+            if (scale == 0)
+            {
+                offDiag[i] = 0;
+
+                for (int k = 0; k < m; k++)
+                    A(i + 1 + k, i) = 0;
+
+                continue;
+            }
+
+            wi = x / scale;
+
+            TElt vSqrLen = sqrlen(wi);
+            TElt oldOff = wi[0];
+            TElt newOff = sqrt(vSqrLen);
+            if (oldOff > 0)
+                newOff = -newOff;
+
+            TElt g = vSqrLen - oldOff * newOff;
+            wi[0] = oldOff - newOff;
+            offDiag[i] = newOff * scale;
+
+            // p = A w / g, then q = p - (w.p / 2g) w
+            for (int j = 0; j < m; j++)
+                pi[j] = dot(TConstRefVec(m, A[i + 1 + j].Ref() + i + 1), wi) / g;
+
+            TElt K = dot(wi, pi) / (2 * g);
+
+            for (int j = 0; j < m; j++)
+                pi[j] -= K * wi[j];
+
+            for (int j = 0; j < m; j++)
+            {
+                TElt* aj = A[i + 1 + j].Ref() + i + 1;
+                TElt  wj = wi[j];
+                TElt  pj = pi[j];
+
+                for (int k = 0; k < m; k++)
+                    aj[k] -= wj * pi[k] + pj * wi[k];
+            }
+
+            for (int k = 0; k < m; k++)
+                A(i + 1 + k, i) = wi[k];
+        }
+
+        if (n >= 2)
+        {
+            diagonal[n - 2] = A(n - 2, n - 2);
+            offDiag [n - 2] = A(n - 1, n - 2);
+        }
+
+        if (n >= 1)
+            diagonal[n - 1] = A(n - 1, n - 1);
+    }
 
-    return QRFactorization(A, (TRefMat) Q, (TRefMat) R);
-}
+    void DiagonalizeQL(TRefVec d, TVec& e, TRefMat Vt)
+    // Diagonalizes the symmetric tridiagonal matrix with diagonal d and
+    // off-diagonal e[0 .. n-1), leaving the eigenvalues in d. The rotations
+    // are applied to the rows of Vt, unless it's null.
+    {
+        const int n = d.Elts();
+        const int kMaxIterations = 30;
 
-TMElt QRFactorization(TRefMat A, TRefMat Q, TRefMat R)
-// Factor A into an orthogonal matrix Q and an upper-triangular matrix R.
-// Destroys A.
-{
-    VL_ASSERT_MSG(A.Rows() >= A.Cols(), "matrix must have rows >= cols");
-    VL_ASSERT_MSG(Q.Rows() == A.Rows() && Q.Cols() == A.Cols(), "Q size mismatch");
-    VL_ASSERT_MSG(R.Rows() == A.Cols() && R.Cols() == A.Cols(), "R size mismatch");
+        e[n - 1] = 0;
+
+        for (int l = 0; l < n; l++)
+        {
+            for (int iteration = 0; true; iteration++)
+            {
+                // Look for a negligible off-diagonal element to split at
+                int m;
+                for (m = l; m < n - 1; m++)
+                {
+                    TElt dd = abs(d[m]) + abs(d[m + 1]);
 
-    TMat Qs(A.Rows(), A.Rows(), vl_I);
+                    if (abs(e[m]) + dd == dd)
+                        break;
+                }
 
-    R = vl_0;
+                if (m == l)
+                    break;
 
-    TMElt normAcc = vl_0;
+                if (iteration == kMaxIterations)
+                {
+                    VL_EXPECT_MSG(false, "(SymmetricEigen) no convergence");
+                    break;
+                }
 
-    // for each column
-    for (int i = 0; i < A.Cols(); i++)
+                // Wilkinson shift
+                TElt g = (d[l + 1] - d[l]) / (2 * e[l]);
+                TElt r = sqrt(sqr(g) + TElt(vl_one));
+                g = d[m] - d[l] + e[l] / (g + (g >= 0 ? r : -r));
+
+                TElt s = 1;
+                TElt c = 1;
+                TElt p = 0;
+                int  i;
+
+                for (i = m - 1; i >= l; i--)
+                {
+                    TElt f = s * e[i];
+                    TElt b = c * e[i];
+
+                    r = sqrt(sqr(f) + sqr(g));
+                    e[i + 1] = r;
+
+                    if (r == 0)
+                    {
+                        // Underflow: deflate and go again
+                        d[i + 1] -= p;
+                        e[m] = 0;
+                        break;
+                    }
+
+                    s = f / r;
+                    c = g / r;
+                    g = d[i + 1] - p;
+                    r = (d[i] - g) * s + 2 * c * b;
+                    p = s * r;
+                    d[i + 1] = g + p;
+                    g = c * r - b;
+
+                    if (!Vt.IsNull())
+                    {
+                        TElt* v0 = Vt[i].Ref();
+                        TElt* v1 = Vt[i + 1].Ref();
+
+                        for (int k = 0; k < n; k++)
+                        {
+                            TElt t = v1[k];
+                            v1[k] = s * v0[k] + c * t;
+                            v0[k] = c * v0[k] - s * t;
+                        }
+                    }
+                }
+
+                if (r == 0 && i >= l)
+                    continue;
+
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0;
+            }
+        }
+    }
+
+    void SortEigen(TRefVec d, TRefMat Vt)
+    // Sorts the eigenvalues into decreasing order, along with the rows of Vt
     {
-        // apply householder
-        TMElt diagElt = LeftHouseholder(A, Qs, i);
+        const int n = d.Elts();
+
+        for (int i = 0; i < n - 1; i++)
+        {
+            int k = i;
 
-        // copy over row i of A to R
-        R(i, i) = diagElt;
+            for (int j = i + 1; j < n; j++)
+                if (d[j] > d[k])
+                    k = j;
 
-        int j = A.Cols() - i - 1;
+            if (k == i)
+                continue;
 
-        if (j != 0)
-            last(R[i], j) = last(A[i], j);
+            TElt t = d[i];
+            d[i] = d[k];
+            d[k] = t;
 
-        normAcc = vl_max(normAcc, abs(diagElt));
+            if (!Vt.IsNull())
+                for (int j = 0; j < n; j++)
+                {
+                    t = Vt(i, j);
+                    Vt(i, j) = Vt(k, j);
+                    Vt(k, j) = t;
+                }
+        }
     }
+}
 
-    Q = sub(Qs, 0, 0, A.Rows(), A.Cols());
+void SymmetricEigen(TRefMat A, TMat& V, TVec& eigenvalues)
+{
+    V.SetSize(A.Rows(), A.Rows());
+    eigenvalues.SetSize(A.Rows());
 
-    return normAcc;
+    SymmetricEigen(A, TRefMat(V), TRefVec(eigenvalues));
 }
 
-void SVDFactorization(TRefMat A, TMat& U, TMat& V, TMVec& diagonal)
+void SymmetricEigen(TRefMat A, TRefMat V, TRefVec eigenvalues)
 {
-    diagonal.SetSize(A.Cols());
+    VL_ASSERT_MSG(is_square(A), "(SymmetricEigen) A must be square");
+    VL_ASSERT_MSG(V.Rows() == A.Rows() && V.Cols() == A.Rows(), "(SymmetricEigen) V has the wrong size");
+    VL_ASSERT_MSG(eigenvalues.Elts() == A.Rows(), "(SymmetricEigen) eigenvalues has the wrong size");
 
-    U.SetSize(A.Rows(), A.Cols());
-    V.SetSize(A.Cols(), A.Cols());
+    const int n = A.Rows();
+
+    if (n == 0)
+        return;
 
-    SVDFactorization(A, TRefMat(U), TRefMat(V), TRefVec(diagonal));
+    TVec offDiag(n);
+    Tridiagonalize(A, eigenvalues, offDiag);
+
+    TMat Vt(n, n, vl_I);
+    DiagonalizeQL(eigenvalues, offDiag, Vt);
+    SortEigen(eigenvalues, Vt);
+
+    // V = Q Z, where Q = H_0 .. H_n-3 acts on coordinates 1 .. n-1
+    Transpose(Vt, V);
+
+    if (n > 2)
+        ApplyLeftHouseholders(TConstRefMat(n - 1, n, A[1].Ref()), n - 2, TRefMat(n - 1, n, V[1].Ref()));
 }
 
-void SVDFactorization(TRefMat A, TRefMat U, TRefMat V, TMRefVec diagonal)
+void SymmetricEigen(TRefMat A, TVec& eigenvalues)
 {
-    TVec superDiag(A.Cols() - 1);
+    eigenvalues.SetSize(A.Rows());
+    SymmetricEigen(A, TRefVec(eigenvalues));
+}
 
-    VL_ASSERT(diagonal.Elts() == A.Cols());
-    VL_ASSERT(same_size(U, A));
-    VL_ASSERT(is_square(V) && V.Cols() == A.Cols());
+void SymmetricEigen(TRefMat A, TRefVec eigenvalues)
+{
+    VL_ASSERT_MSG(is_square(A), "(SymmetricEigen) A must be square");
+    VL_ASSERT_MSG(eigenvalues.Elts() == A.Rows(), "(SymmetricEigen) eigenvalues has the wrong size");
 
-    // Find the bidiagonal matrix, and then eliminate the
-    // elements above the diagonal to get the final
-    // result.
-    Bidiagonalize(A, U, V, diagonal, superDiag);
-    Diagonalize  (         diagonal, superDiag, U, V);
+    const int n = A.Rows();
+
+    if (n == 0)
+        return;
+
+    TVec offDiag(n);
+    Tridiagonalize(A, eigenvalues, offDiag);
+    DiagonalizeQL(eigenvalues, offDiag, TRefMat());
+    SortEigen(eigenvalues, TRefMat());
 }
 #endif
 
 #ifndef VL_MIXED
-bool Cholesky(TConstRefMat A, TRefMat L)
-// Factors symmetric positive definite matrix 'A' into L Lt, where
-// L is lower triangular.
+// --- Lanczos partial decompositions -----------------------------------------
+
+/*
+    NOTE
+
+    For the top k eigenpairs of a large symmetric A, the Lanczos process
+    builds an orthonormal basis V of the Krylov space span{v, Av, A^2v..},
+    in which A is represented by the small matrix T = Vt A V. T's top
+    eigenpairs (the Ritz pairs) converge quickly to A's. For the SVD, the
+    Golub-Kahan-Lanczos process does the same with two bases, P and Q, and
+    A P = Q B.
+
+    The basis is limited to m ~ 2k vectors, so memory is O(nk). When it's
+    full, we restart thickly (Wu & Simon, 2000): the best l > k Ritz vectors
+    are kept, along with the last basis vector, which keeps the search
+    going where it left off rather than starting again from one vector.
+    T then has an arrow-head block at the top, which is why it's stored
+    densely, and decomposed with SymmetricEigen/SVDFactorization rather
+    than as a tridiagonal.
+
+    The new vectors are fully reorthogonalized against the basis, using
+    classical Gram-Schmidt twice, which is as accurate as the modified
+    form, but is two matrix-vector products, and so threads for large n.
+    This avoids the loss of orthogonality, and ghost copies of converged
+    eigenvalues, that plague plain Lanczos.
+
+    A Ritz pair (theta, x) has residual |A x - theta x| = beta |y_m|,
+    where beta is the norm of the last residual vector, and y_m the last
+    element of the Ritz vector in the basis, so convergence can be checked
+    without any further products with A.
+*/
+
+namespace
 {
-    for (int i = 0, n = A.Elts(); i < n; i++)
-        for (int j = i; j < n; j++)
+    const int  kLanczosMaxRestarts = 200;
+    const TElt kLanczosBreakdown   = sizeof(TElt) > 4 ? TElt(1e-12) : TElt(1e-6);
+
+    int LanczosBasisSize(int k, int n)
+    {
+        return vl_min(n, vl_max(2 * k + 1, k + 16));
+    }
+
+    void FillRandom(TRefVec v, unsigned seed)
+    // Deterministic pseudo-random values in [-1, 1)
+    {
+        for (int i = 0; i < v.Elts(); i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            v[i] = TElt(int(seed >> 8) - (1 << 23)) / TElt(1 << 23);
+        }
+    }
+
+    void LanczosStart(TRefVec v, unsigned seed)
+    {
+        FillRandom(v, seed);
+        v /= len(v);
+    }
+
+    TElt Orthogonalize(TConstRefMat V, TRefVec w, TRefVec h, TRefVec t)
+    // Makes w orthogonal to the rows of V, and returns its remaining
+    // length. Its components along V are returned in h. t is scratch.
+    {
+        const int count = V.Rows();
+        TRefVec c(count, t.Ref() + w.Elts());
+
+        for (int i = 0; i < count; i++)
+            h[i] = 0;
+
+        for (int pass = 0; pass < 2 && count > 0; pass++)
+        {
+            TRefVec tw(w.Elts(), t.Ref());
+
+            Multiply(V, w, c);
+            Multiply(c, V, tw);
+            w -= tw;
+
+            for (int i = 0; i < count; i++)
+                h[i] += c[i];
+        }
+
+        return len(w);
+    }
+
+    TElt NextBasisVector(TConstRefMat V, TRefVec w, TRefVec h, TRefVec t, unsigned seed)
+    // Orthogonalizes w against the basis V, and normalizes it. If there's
+    // nothing left, the basis spans an invariant subspace, so w is replaced
+    // by a new orthogonal direction, and 0 returned.
+    {
+        TElt norm = len(w);
+        TElt beta = Orthogonalize(V, w, h, t);
+
+        if (beta > kLanczosBreakdown * norm)
+        {
+            w /= beta;
+            return beta;
+        }
+
+        TVec hr(V.Rows());
+        LanczosStart(w, seed);
+
+        beta = Orthogonalize(V, w, hr, t);
+
+        if (beta > 0)   // else V already spans the whole space
+            w /= beta;
+
+        return 0;
+    }
+
+    void SortSVD(TRefVec d, TRefMat U, TRefMat V)
+    // Sorts the singular values into decreasing order, along with the
+    // columns of U and V
+    {
+        const int n = d.Elts();
+
+        for (int i = 0; i < n - 1; i++)
         {
-            TMElt sum = A(i, j);
+            int k = i;
+
+            for (int j = i + 1; j < n; j++)
+                if (d[j] > d[k])
+                    k = j;
 
-            for (int k = i - 1; k >= 0; k--)
-                sum -= L(i, k) * L(j, k);
+            if (k == i)
+                continue;
+
+            TElt t = d[i];
+            d[i] = d[k];
+            d[k] = t;
 
-            if (i == j)
+            for (int j = 0; j < U.Rows(); j++)
             {
-                if (sum <= 0)
-                    return false;
+                t = U(j, i);
+                U(j, i) = U(j, k);
+                U(j, k) = t;
+            }
 
-                L(i, i) = sqrt(sum);
+            for (int j = 0; j < V.Rows(); j++)
+            {
+                t = V(j, i);
+                V(j, i) = V(j, k);
+                V(j, k) = t;
             }
-            else
+        }
+    }
+
+    void RitzVectors(TConstRefMat Y, int count, TConstRefMat V, TRefMat X)
+    // Sets row i of X to the combination of V's rows given by column i of Y
+    {
+        TMat Yt(count, Y.Rows());
+
+        for (int i = 0; i < count; i++)
+            for (int j = 0; j < Y.Rows(); j++)
+                Yt(i, j) = Y(j, i);
+
+        Multiply(Yt, TConstRefMat(Y.Rows(), V.Cols(), V.Ref()), X);
+    }
+
+    int ThickRestartSize(int k, int m)
+    {
+        return vl_max(k, vl_min((m + k) / 2, m - 2));
+    }
+
+    template<class T_MAT> int Lanczos(const T_MAT& A, int k, TMat& X, TVec& values, TElt epsilon, int* steps)
+    {
+        VL_ASSERT_MSG(A.Rows() == A.Cols(), "(LanczosEigen) A must be square");
+        VL_ASSERT_MSG(k > 0 && k <= A.Rows(), "(LanczosEigen) k must be in [1, n]");
+
+        const int n = A.Rows();
+        const int m = LanczosBasisSize(k, n);
+
+        TMat V(m + 1, n);        // basis, as rows
+        TMat T(m, m, vl_0);      // Vt A V
+        TMat Y;
+        TVec theta;
+        TVec h(m + 1);
+        TVec t(n + m + 1);
+
+        LanczosStart(V[0], 1);
+
+        int  l = 0;
+        int  applied = 0;
+        int  converged = 0;
+
+        for (int restart = 0; true; restart++)
+        {
+            TElt beta = 0;
+
+            for (int j = l; j < m; j++)
             {
-                L(j, i) = sum / L(i, i);
-                L(i, j) = 0;
+                TRefVec w(V[j + 1]);
+
+                Multiply(A, V[j], w);
+                applied++;
+
+                beta = NextBasisVector(TConstRefMat(j + 1, n, V.Ref()), w, h, t, j + 2);
+
+                T(j, j) = h[j];
+
+                if (j + 1 < m)
+                    T(j, j + 1) = T(j + 1, j) = beta;
+            }
+
+            TMat TT(T);
+            SymmetricEigen(TT, Y, theta);
+
+            TElt scale = vl_max(abs(theta[0]), abs(theta[m - 1]));
+
+            for (converged = 0; converged < k; converged++)
+                if (abs(beta * Y(m - 1, converged)) > epsilon * scale)
+                    break;
+
+            if (converged == k || m == n || restart == kLanczosMaxRestarts)
+                break;
+
+            // Keep the best l Ritz vectors, and the last basis vector
+            l = ThickRestartSize(k, m);
+
+            TMat W(l, n);
+            RitzVectors(Y, l, V, W);
+
+            for (int i = 0; i < l; i++)
+                V[i] = W[i];
+
+            V[l] = V[m];
+
+            T = vl_0;
+            for (int i = 0; i < l; i++)
+            {
+                T(i, i) = theta[i];
+                T(i, l) = T(l, i) = beta * Y(m - 1, i);
             }
         }
 
-    return true;
-}
-#endif
+        TMat Xt(k, n);
+        RitzVectors(Y, k, V, Xt);
 
-void BacksolveLLt(TConstRefMat L, TRefVec x, TConstRefVec b)
-// Given 'L' from a Cholesky decomposition, solve L Lt x = b.
-{
-    VL_ASSERT(is_square(L));
-    VL_ASSERT(b.Elts() == L.Rows());
-    VL_ASSERT(x.Elts() == L.Rows());
+        X.SetSize(n, k);
+        Transpose(Xt, X);
 
-    const int n = L.Rows();
+        values.SetSize(k);
+        for (int i = 0; i < k; i++)
+            values[i] = theta[i];
 
-    // Solve L x' = b
-    for (int i = 0; i < n; i++)
+        if (steps)
+            *steps = applied;
+
+        return converged;
+    }
+
+    template<class T_MAT> int LanczosBidiag(const T_MAT& A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps)
     {
-        TMElt sum = 0;
+        const int rows = A.Rows();
+        const int cols = A.Cols();
 
-        for (int j = 0; j < i; j++)
-            sum += L(i, j) * x[j];
+        VL_ASSERT_MSG(k > 0 && k <= vl_min(rows, cols), "(LanczosSVD) k must be in [1, min(rows, cols)]");
 
-        x[i] = TElt((b[i] - sum) / L(i, i));
+        const int m = LanczosBasisSize(k, vl_min(rows, cols));
+
+        TMat P(m + 1, cols);     // right basis, as rows
+        TMat Q(m, rows);         // left basis, as rows
+        TMat B(m, m, vl_0);      // Qt A P
+        TMat X, Y;
+        TVec sigma;
+        TVec h(m + 1);
+        TVec t(vl_max(rows, cols) + m + 1);
+
+        LanczosStart(P[0], 1);
+
+        int  l = 0;
+        int  applied = 0;
+        int  converged = 0;
+
+        for (int restart = 0; true; restart++)
+        {
+            TElt beta = 0;
+
+            for (int j = l; j < m; j++)
+            {
+                // A P = Q B: B's column j comes from orthogonalizing A p_j
+                TRefVec q(Q[j]);
+
+                Multiply(A, P[j], q);
+                applied++;
+
+                TElt alpha = NextBasisVector(TConstRefMat(j, rows, Q.Ref()), q, h, t, j + 2);
+
+                for (int i = 0; i < j; i++)
+                    B(i, j) = h[i];
+
+                B(j, j) = alpha;
+
+                // At Q = P Bt + beta p_m e_mt
+                TRefVec p(P[j + 1]);
+
+                Multiply(q, A, p);
+                applied++;
+
+                beta = NextBasisVector(TConstRefMat(j + 1, cols, P.Ref()), p, h, t, j + 3);
+            }
+
+            TMat BB(B);
+            SVDFactorization(BB, X, Y, sigma);
+
+            SortSVD(sigma, X, Y);
+
+            TElt scale = sigma[0];
+
+            for (converged = 0; converged < k; converged++)
+                if (abs(beta * X(m - 1, converged)) > epsilon * scale)
+                    break;
+
+            if (converged == k || m == vl_min(rows, cols) || restart == kLanczosMaxRestarts)
+                break;
+
+            // Keep the best l singular vector pairs, and the last p
+            l = ThickRestartSize(k, m);
+
+            TVec    scratch(l * vl_max(rows, cols));
+            TRefMat PY(l, cols, scratch.Ref());
+            TRefMat QX(l, rows, scratch.Ref());
+
+            RitzVectors(Y, l, P, PY);
+            for (int i = 0; i < l; i++)
+                P[i] = PY[i];
+
+            P[l] = P[m];
+
+            RitzVectors(X, l, Q, QX);
+            for (int i = 0; i < l; i++)
+                Q[i] = QX[i];
+
+            B = vl_0;
+            for (int i = 0; i < l; i++)
+            {
+                B(i, i) = sigma[i];
+                B(i, l) = beta * X(m - 1, i);
+            }
+        }
+
+        TVec    scratch(k * vl_max(rows, cols));
+        TRefMat QX(k, rows, scratch.Ref());
+        TRefMat PY(k, cols, scratch.Ref());
+
+        RitzVectors(X, k, Q, QX);
+        U.SetSize(rows, k);
+        Transpose(QX, U);
+
+        RitzVectors(Y, k, P, PY);
+        V.SetSize(cols, k);
+        Transpose(PY, V);
+
+        values.SetSize(k);
+        for (int i = 0; i < k; i++)
+            values[i] = sigma[i];
+
+        if (steps)
+            *steps = applied;
+
+        return converged;
     }
+}
 
-    // Solve Lt x = x'
-    for (int i = n - 1; i >= 0; i--)
+int LanczosEigen(TConstRefMat A, int k, TMat& V, TVec& values, TElt epsilon, int* steps)
+{
+    return Lanczos(A, k, V, values, epsilon, steps);
+}
+
+int LanczosEigen(const TSparseMat& A, int k, TMat& V, TVec& values, TElt epsilon, int* steps)
+{
+    return Lanczos(A, k, V, values, epsilon, steps);
+}
+
+int LanczosEigen(const TLinearOperator& A, int k, TMat& V, TVec& values, TElt epsilon, int* steps)
+{
+    return Lanczos(A, k, V, values, epsilon, steps);
+}
+
+int LanczosSVD(TConstRefMat A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps)
+{
+    return LanczosBidiag(A, k, U, V, values, epsilon, steps);
+}
+
+int LanczosSVD(const TSparseMat& A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps)
+{
+    return LanczosBidiag(A, k, U, V, values, epsilon, steps);
+}
+
+int LanczosSVD(const TLinearOperator& A, int k, TMat& U, TMat& V, TVec& values, TElt epsilon, int* steps)
+{
+    return LanczosBidiag(A, k, U, V, values, epsilon, steps);
+}
+#endif
+
+#ifndef VL_MIXED
+// --- Randomized SVD ---------------------------------------------------------
+
+/*
+    NOTE
+
+    This is the randomized range finder of Halko, Martinsson & Tropp
+    (2011). For A m x n, and a random n x l matrix W, with l = k + p, the
+    columns of A W span, with high probability, nearly all of A's top k
+    singular directions. The p extra, or oversampled, columns are cheap
+    insurance against the few directions W happens to miss.
+
+    With an orthonormal basis Q for that range, A ~ Q Qt A, and the SVD of
+    the small l x n matrix Qt A gives that of A. Each power iteration
+    replaces Q with the basis of A At Q, which raises the singular values
+    to a higher power, so a slowly decaying spectrum separates better.
+    Re-orthonormalizing via QR at each half step keeps the small singular
+    values from being lost in rounding.
+
+    All the work on A is in products with l-column matrices, so it's done
+    by the blocked, threaded matrix multiply. Only the thin matrices are
+    ever transposed, as At Q = (Qt A)t.
+*/
+
+namespace
+{
+    void RangeBasis(TConstRefMat Y, TRefMat Q)
+    // Sets Q to an orthonormal basis for the columns of Y
     {
-        TMElt sum = 0;
+        TQRFactor qr(Y);
+        Q = vl_I;
+        qr.ApplyQ(Q);
+    }
+}
 
-        for (int j = i + 1; j < n; j++)
-            sum += L(j, i) * x[j];
+void RandomizedSVD(TConstRefMat A, int k, TMat& U, TMat& V, TVec& values, int powerIterations, int oversample)
+{
+    const int m = A.Rows();
+    const int n = A.Cols();
+    const int l = vl_min(k + oversample, vl_min(m, n));
 
-        x[i] = TElt((x[i] - sum) / L(i, i));
+    VL_ASSERT_MSG(k > 0 && k <= vl_min(m, n), "(RandomizedSVD) k must be in [1, min(rows, cols)]");
+    VL_ASSERT_MSG(oversample >= 0 && powerIterations >= 0, "(RandomizedSVD) illegal parameters");
+
+    TMat W(n, l);
+    TMat Y(m, l);
+    TMat Q(m, l);
+    TMat Qt(l, m);
+    TMat B(l, n);           // Qt A
+
+    FillRandom(W.AsVec(), 1);
+    Multiply(A, W, Y);
+    RangeBasis(Y, Q);
+
+    for (int i = 0; i < powerIterations; i++)
+    {
+        // Q = basis(A basis(At Q))
+        Transpose(Q, Qt);
+        Multiply(Qt, A, B);
+        Transpose(B, W);
+        RangeBasis(W, W);
+
+        Multiply(A, W, Y);
+        RangeBasis(Y, Q);
     }
+
+    Transpose(Q, Qt);
+    Multiply(Qt, A, B);
+
+    // Bt = Ub D Vbt, so A ~ Q B = (Q Vb) D Ubt
+    TMat Bt(trans(B));
+    TMat Ub, Vb;
+    TVec d;
+
+    SVDFactorization(Bt, Ub, Vb, d);
+    SortSVD(d, Ub, Vb);
+
+    TMat Vbk(l, k);
+    for (int i = 0; i < l; i++)
+        for (int j = 0; j < k; j++)
+            Vbk(i, j) = Vb(i, j);
+
+    U.SetSize(m, k);
+    Multiply(Q, Vbk, U);
+
+    V.SetSize(n, k);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < k; j++)
+            V(i, j) = Ub(i, j);
+
+    values.SetSize(k);
+    for (int i = 0; i < k; i++)
+        values[i] = d[i];
 }
+#endif
 
 #ifndef VL_MIXED
 TMat GramSchmidt(TConstRefMat M)
@@ -316,7 +2314,8 @@ void ReducedRowEchelonForm(TRefMat A, TMElt epsilon)
 TMElt LeftHouseholder(TRefMat A, TRefMat U, const int i)
 // Zeroes out those elements below the diagonal in column i by use of a
 // Householder transformation matrix H: A' = HA. U is replaced with UH,
-// so that U'A' = UH HA = UA
+// so that U'A' = UH HA = UA, unless it's null. The vector defining H is
+// left in column i of A, from the diagonal down.
 {
     VL_ASSERT_MSG(i < A.Rows(), "bad i");
 
@@ -365,7 +2364,7 @@ TMElt LeftHouseholder(TRefMat A, TRefMat U, const int i)
     }
 
     // Apply H to rows of U
-    for (int j = 0; j < A.Rows(); j++)
+    for (int j = 0, nu = U.IsNull() ? 0 : A.Rows(); j < nu; j++)
     {
         // vH = v - (v.w)w / g
 
@@ -385,7 +2384,7 @@ TMElt LeftHouseholder(TRefMat A, TRefMat U, const int i)
 TMElt RightHouseholder(TRefMat A, TRefMat V, const int i)
 // Zeroes out those elements to the right of the super-diagonal in row i
 // by use of a Householder transformation matrix H: A' = AH. V is
-// replaced with VH, so that A'V't = AH (HV)t = AVt
+// replaced with VH, so that A'V't = AH (HV)t = AVt, unless it's null.
 {
     VL_ASSERT_MSG(i < A.Cols() - 1, "bad i");
 
@@ -428,7 +2427,7 @@ TMElt RightHouseholder(TRefMat A, TRefMat V, const int i)
     }
 
     // Accumulate the transform in V
-    for (int j = 1; j < A.Cols(); j++)
+    for (int j = 1, nv = V.IsNull() ? 0 : A.Cols(); j < nv; j++)
     {
         TMElt dotProd = 0;
         for (int k = i + 1; k < A.Cols(); k++)
@@ -448,27 +2447,33 @@ TMElt RightHouseholder(TRefMat A, TRefMat V, const int i)
 void Bidiagonalize(TRefMat A, TRefMat U, TRefMat V, TRefVec diagonal, TRefVec superDiag)
 // bidiagonalize matrix A by using householder transformations to eliminate
 // columns below the diagonal and rows to the right of the super-diagonal.
-// A is modified, and the diagonal and superDiag set.
+// A is modified, and the diagonal and superDiag set. U and V may be null
+// if they're not needed.
 {
     VL_ASSERT_MSG(A.Rows() >= A.Cols(), "A must have rows >= cols");
     VL_ASSERT_MSG(diagonal .Elts() == A.Cols()    , "diagonal size mismatch");
     VL_ASSERT_MSG(superDiag.Elts() == A.Cols() - 1, "super diagonal size mismatch");
-    VL_ASSERT_MSG(U.Rows() == A.Rows() && U.Cols() == A.Cols(), "U size mismatch");
-    VL_ASSERT_MSG(V.Rows() == A.Cols() && V.Cols() == A.Cols(), "V size mismatch");
+    VL_ASSERT_MSG(U.IsNull() || (U.Rows() == A.Rows() && U.Cols() == A.Cols()), "U size mismatch");
+    VL_ASSERT_MSG(V.IsNull() || (V.Rows() == A.Cols() && V.Cols() == A.Cols()), "V size mismatch");
 
-    V = vl_I;
-
-    TMat Us(A.Rows(), A.Rows(), vl_I);
+    if (!V.IsNull())
+        V = vl_I;
 
+    // The left transforms are accumulated into U afterwards, from their
+    // vectors left in A, which needs only m x n rather than m x m space.
     for (int i = 0; i < A.Cols(); i++)
     {
-        diagonal[i] = TElt(LeftHouseholder(A, Us, i));
+        diagonal[i] = TElt(LeftHouseholder(A, TRefMat(), i));
 
         if (i < A.Cols() - 1)
             superDiag[i] = TElt(RightHouseholder(A, V, i));
     }
 
-    U = sub(Us, 0, 0, A.Rows(), A.Cols());
+    if (!U.IsNull())
+    {
+        U = vl_I;
+        ApplyLeftHouseholders(A, A.Cols(), U);
+    }
 }
 
 
@@ -516,6 +2521,9 @@ namespace
     // rotate U by the given Givens rotation: U' = UGt
     // where G is defined as above
     {
+        if (U.IsNull())
+            return;
+
         TMVec temp(col(U, i));
 
         col(U, i) =  c * col(U, i) - s * col(U, j);
@@ -602,7 +2610,7 @@ namespace
 
 void Diagonalize(TRefVec diagonal, TRefVec superDiag, TRefMat U, TRefMat V)
 // Diagonalise the bidiagonal matrix A = (diagonal, superDiag), accumulating
-// transforms into U on the left and Vt on the right.
+// transforms into U on the left and Vt on the right. U and V may be null.
 //
 // diag(A) = diagonal and diag(A, 1) = superDiag, that is to say, diagonal[0]
 // is A[0][0], and superDiag[0] is A[0][1].
@@ -758,7 +2766,8 @@ void Diagonalize(TRefVec diagonal, TRefVec superDiag, TRefMat U, TRefMat V)
         {
             diagonal[k] = -diagonal[k];
             // flip the corresponding row of Vt to balance out
-            col(V, k) = -col(V, k);
+            if (!V.IsNull())
+                col(V, k) = -col(V, k);
         }
     }
 }
@@ -0,0 +1,372 @@
+/*
+    File:       Factor3.cpp
+
+    Function:   Implements Factor3.hpp
+
+    Copyright:  Andrew Willmott
+*/
+
+
+#include "VL/Factor3.hpp"
+
+/*
+    NOTE
+
+    The SVD follows McAdams et al., "Computing the Singular Value
+    Decomposition of 3x3 matrices with minimal branching and elementary
+    floating point operations", 2011. A fixed number of cyclic Jacobi
+    sweeps diagonalizes trans(A) A = V diag(e) trans(V), which gives
+    B = A V with orthogonal columns. These are sorted by decreasing length,
+    and a Givens QR of B = U R then leaves the singular values on the
+    diagonal of R. The off-diagonal terms are zero to rounding error, as B's
+    columns are already orthogonal.
+
+    Unlike the paper, the Jacobi rotations are exact rather than
+    approximate, as sqrt is cheap on current hardware, and exact rotations
+    need fewer sweeps. Every step is written in terms of arithmetic and
+    vl_if_less(), so the same code runs on a single TElt, or on a lane group
+    (see Lanes.hpp) of several matrices, which the compiler turns into SIMD
+    code. The batch routines gather 4, 8 or 16 matrices into
+    structure-of-arrays form, according to the vector width available.
+
+    Forming trans(A) A squares the condition number, so for nearly
+    singular A the smallest singular value has only about half the relative
+    precision of the others. This is fine for rotation extraction, which is
+    the usual use.
+*/
+
+#ifndef VL_FACTOR3_IMPL
+#define VL_FACTOR3_IMPL
+
+namespace
+{
+    // --- Kernels, for T = scalar or lane group ------------------------------
+
+    template<class T> inline void SetIdentity(T m[3][3])
+    {
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                m[i][j] = T(i == j ? 1 : 0);
+    }
+
+    template<int p, int q, class T> inline void JacobiRotate(T s[3][3], T v[3][3])
+    // Applies the rotation in the (p, q) plane that zeroes s[p][q]
+    {
+        const int r = 3 - p - q;
+
+        T spq = s[p][q];
+        T d   = s[q][q] - s[p][p];
+        T h   = sqrt(d * d + T(4) * spq * spq);
+        T den = abs(d) + h;
+
+        // t = tan(theta), choosing the smaller angle
+        T t = T(2) * spq / vl_if_less(T(0), den, den, T(1));
+        t = vl_if_less(d, T(0), -t, t);
+
+        T c  = T(1) / sqrt(T(1) + t * t);
+        T sn = t * c;
+
+        s[p][p] = s[p][p] - t * spq;
+        s[q][q] = s[q][q] + t * spq;
+        s[p][q] = s[q][p] = T(0);
+
+        T srp = s[r][p];
+        T srq = s[r][q];
+
+        s[r][p] = s[p][r] = c * srp - sn * srq;
+        s[r][q] = s[q][r] = sn * srp + c * srq;
+
+        for (int k = 0; k < 3; k++)
+        {
+            T vkp = v[k][p];
+            T vkq = v[k][q];
+
+            v[k][p] = c * vkp - sn * vkq;
+            v[k][q] = sn * vkp + c * vkq;
+        }
+    }
+
+    template<class T> void JacobiEigen(T s[3][3], T v[3][3], int sweeps)
+    // Diagonalizes symmetric s, accumulating the rotations into v
+    {
+        SetIdentity(v);
+
+        for (int i = 0; i < sweeps; i++)
+        {
+            JacobiRotate<0, 1>(s, v);
+            JacobiRotate<0, 2>(s, v);
+            JacobiRotate<1, 2>(s, v);
+        }
+    }
+
+    template<class T> inline void SwapColumns(T ki, T kj, T m[3][3], int i, int j)
+    // If ki < kj, swaps columns i and j of m, negating the new column j to
+    // keep the determinant unchanged.
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            T mi = m[k][i];
+            T mj = m[k][j];
+
+            m[k][i] = vl_if_less(ki, kj, mj, mi);
+            m[k][j] = vl_if_less(ki, kj, -mi, mj);
+        }
+    }
+
+    template<class T> inline void SortStep(T key[3], int i, int j, T a[3][3], T (*b)[3])
+    {
+        T ki = key[i];
+        T kj = key[j];
+
+        SwapColumns(ki, kj, a, i, j);
+        if (b)
+            SwapColumns(ki, kj, b, i, j);
+
+        key[i] = vl_if_less(ki, kj, kj, ki);
+        key[j] = vl_if_less(ki, kj, ki, kj);
+    }
+
+    template<class T> inline void SortColumns(T key[3], T a[3][3], T (*b)[3] = 0)
+    // Sorts the columns of a, and optionally b, by decreasing key
+    {
+        SortStep(key, 0, 1, a, b);
+        SortStep(key, 1, 2, a, b);
+        SortStep(key, 0, 1, a, b);
+    }
+
+    template<class T> inline void GivensQR(T b[3][3], T u[3][3], int i, int j)
+    // Zeroes b[j][i] by rotating rows i and j of b, accumulating the
+    // transposed rotation into u.
+    {
+        T x  = b[i][i];
+        T y  = b[j][i];
+        T r2 = x * x + y * y;
+        T rr = T(1) / sqrt(vl_if_less(T(0), r2, r2, T(1)));
+
+        T c = vl_if_less(T(0), r2, x * rr, T(1));
+        T s = vl_if_less(T(0), r2, y * rr, T(0));
+
+        for (int k = 0; k < 3; k++)
+        {
+            T bi = b[i][k];
+            T bj = b[j][k];
+
+            b[i][k] = c * bi + s * bj;
+            b[j][k] = c * bj - s * bi;
+
+            T ui = u[k][i];
+            T uj = u[k][j];
+
+            u[k][i] = c * ui + s * uj;
+            u[k][j] = c * uj - s * ui;
+        }
+    }
+
+    template<class T> void SVD3(const T a[3][3], T u[3][3], T v[3][3], T d[3], int sweeps)
+    {
+        T s[3][3];
+
+        for (int i = 0; i < 3; i++)
+            for (int j = i; j < 3; j++)
+                s[i][j] = s[j][i] = a[0][i] * a[0][j] + a[1][i] * a[1][j] + a[2][i] * a[2][j];
+
+        JacobiEigen(s, v, sweeps);
+
+        T b[3][3];
+
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                b[i][j] = a[i][0] * v[0][j] + a[i][1] * v[1][j] + a[i][2] * v[2][j];
+
+        T len2[3];
+
+        for (int j = 0; j < 3; j++)
+            len2[j] = b[0][j] * b[0][j] + b[1][j] * b[1][j] + b[2][j] * b[2][j];
+
+        SortColumns(len2, b, v);
+
+        SetIdentity(u);
+        GivensQR(b, u, 0, 1);
+        GivensQR(b, u, 0, 2);
+        GivensQR(b, u, 1, 2);
+
+        for (int i = 0; i < 3; i++)
+            d[i] = b[i][i];
+    }
+
+    template<class T> void Polar3(const T a[3][3], T r[3][3], T s[3][3], int sweeps)
+    {
+        T u[3][3], v[3][3], d[3];
+
+        SVD3(a, u, v, d, sweeps);
+
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+            {
+                r[i][j] = u[i][0] * v[j][0] + u[i][1] * v[j][1] + u[i][2] * v[j][2];
+                s[i][j] = v[i][0] * d[0] * v[j][0] + v[i][1] * d[1] * v[j][1] + v[i][2] * d[2] * v[j][2];
+            }
+    }
+
+    template<class T> void SymmetricEigen3(const T a[3][3], T v[3][3], T e[3], int sweeps)
+    {
+        T s[3][3];
+
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                s[i][j] = a[i][j];
+
+        JacobiEigen(s, v, sweeps);
+
+        for (int i = 0; i < 3; i++)
+            e[i] = s[i][i];
+
+        SortColumns(e, v);
+    }
+
+
+    // --- Lane group load/store ----------------------------------------------
+
+    template<class T, int N, class T_MAT> inline void LoadLanes(VLLanes<T, N> m[3][3], const T_MAT a[], int count)
+    // Gathers a[0 .. count) into lanes, repeating the last matrix to fill
+    {
+        for (int k = 0; k < N; k++)
+        {
+            const T_MAT& ak = a[k < count ? k : count - 1];
+
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    m[i][j][k] = ak[i][j];
+        }
+    }
+
+    template<class T, int N, class T_MAT> inline void StoreLanes(const VLLanes<T, N> m[3][3], T_MAT a[], int count)
+    {
+        for (int k = 0; k < count; k++)
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    a[k][i][j] = m[i][j][k];
+    }
+
+    template<class T, int N, class T_VEC> inline void StoreLanes(const VLLanes<T, N> d[3], T_VEC a[], int count)
+    {
+        for (int k = 0; k < count; k++)
+            for (int i = 0; i < 3; i++)
+                a[k][i] = d[i][k];
+    }
+}
+
+#endif
+
+namespace
+{
+    const int kJacobiSweeps = sizeof(TElt) > 4 ? 5 : 4;
+
+    typedef VLLaneGroup<TElt>::Type TLanes;
+    const int kLanes = VLLaneGroup<TElt>::kLanes;
+}
+
+
+// --- Mat3 Factorizations ----------------------------------------------------
+
+void SVDFactorization(const TMat3& A, TMat3& U, TMat3& V, TVec3& diagonal)
+{
+    TElt a[3][3], u[3][3], v[3][3], d[3];
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            a[i][j] = A[i][j];
+
+    SVD3(a, u, v, d, kJacobiSweeps);
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            U[i][j] = u[i][j];
+            V[i][j] = v[i][j];
+        }
+
+        diagonal[i] = d[i];
+    }
+}
+
+void PolarDecomposition(const TMat3& A, TMat3& R, TMat3& S)
+{
+    TElt a[3][3], r[3][3], s[3][3];
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            a[i][j] = A[i][j];
+
+    Polar3(a, r, s, kJacobiSweeps);
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            R[i][j] = r[i][j];
+            S[i][j] = s[i][j];
+        }
+}
+
+void SymmetricEigen(const TMat3& S, TMat3& V, TVec3& eigenvalues)
+{
+    TElt s[3][3], v[3][3], e[3];
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            s[i][j] = S[i][j];
+
+    SymmetricEigen3(s, v, e, kJacobiSweeps);
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            V[i][j] = v[i][j];
+
+        eigenvalues[i] = e[i];
+    }
+}
+
+void SVDFactorization(int count, const TMat3 A[], TMat3 U[], TMat3 V[], TVec3 diagonals[])
+{
+    for (int base = 0; base < count; base += kLanes)
+    {
+        int n = vl_min(count - base, kLanes);
+        TLanes a[3][3], u[3][3], v[3][3], d[3];
+
+        LoadLanes(a, A + base, n);
+        SVD3(a, u, v, d, kJacobiSweeps);
+        StoreLanes(u, U + base, n);
+        StoreLanes(v, V + base, n);
+        StoreLanes(d, diagonals + base, n);
+    }
+}
+
+void PolarDecomposition(int count, const TMat3 A[], TMat3 R[], TMat3 S[])
+{
+    for (int base = 0; base < count; base += kLanes)
+    {
+        int n = vl_min(count - base, kLanes);
+        TLanes a[3][3], r[3][3], s[3][3];
+
+        LoadLanes(a, A + base, n);
+        Polar3(a, r, s, kJacobiSweeps);
+        StoreLanes(r, R + base, n);
+        StoreLanes(s, S + base, n);
+    }
+}
+
+void SymmetricEigen(int count, const TMat3 S[], TMat3 V[], TVec3 eigenvalues[])
+{
+    for (int base = 0; base < count; base += kLanes)
+    {
+        int n = vl_min(count - base, kLanes);
+        TLanes s[3][3], v[3][3], e[3];
+
+        LoadLanes(s, S + base, n);
+        SymmetricEigen3(s, v, e, kJacobiSweeps);
+        StoreLanes(v, V + base, n);
+        StoreLanes(e, eigenvalues + base, n);
+    }
+}
@@ -7,6 +7,12 @@
 */
 
 #include "VL/Mat.hpp"
+#include "Simd.cpp"
+#include "Threads.cpp"
+
+VL_NS_END
+#include <vector>
+VL_NS_BEGIN
 
 
 // --- RefMat Assignment Operators --------------------------------------------
@@ -35,8 +41,8 @@ const TRefMat& TRefMat::operator = (TConstSliceMat m) const
 {
     VL_ASSERT_MSG(same_size(gen(*this), m), "(Mat::=) Matrix dimensions don't match");
 
-    for (int i = 0, n = Elts(); i < n; i++)
-        data[i] = m.data[i];
+    for (int i = 0; i < rows; i++)
+        (*this)[i] = m[i];
 
     return *this;
 }
@@ -455,6 +461,13 @@ TMat oprod(TConstRefVec a, TConstRefVec b)
     return result;
 }
 
+TMat gram(TConstRefMat m)
+{
+    TMat result(m.cols, m.cols);
+    MultiplyAtA(m, result);
+    return result;
+}
+
 
 // --- Mat Functions ----------------------------------------------------------
 
@@ -478,8 +491,7 @@ void Multiply(TConstRefMat a, TConstRefMat b, TRefMat r)
     VL_ASSERT_MSG(r.cols == b.cols, "(Mat::*m) Matrix dimensions don't match");
     VL_ASSERT_MSG(r.rows == a.rows, "(Mat::*m) Matrix dimensions don't match");
 
-    for (int i = 0; i < a.rows; i++)
-        Multiply(a[i], b, r[i]);
+    Multiply(TConstSliceMat(a), TConstSliceMat(b), TSliceMat(r));
 }
 
 void Divide(TConstRefMat a, TConstRefMat b, TRefMat r)
@@ -518,8 +530,13 @@ void Multiply(TConstRefMat m, TConstRefVec v, TRefVec r)
     VL_ASSERT_MSG(v.elts == m.cols, "(Mat::*v) Matrix/Vector dimensions don't match");
     VL_ASSERT_MSG(r.elts == m.rows, "(Mat::*v) Matrix/Vector dimensions don't match");
 
-    for (int i = 0; i < m.rows; i++)
-        r.data[i] = dot(v, m[i]);
+    vl_parallel_for(kVLThreadMultiply, double(m.rows) * m.cols, m.rows, vl_grain(m.cols),
+        [&](int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+                r.data[i] = dot(v, m[i]);
+        }
+    );
 }
 
 void Multiply(TConstRefVec v, TConstRefMat m, TRefVec r)
@@ -536,14 +553,291 @@ void Multiply(TConstRefVec v, TConstRefMat m, TRefVec r)
         MultiplyAccum(m[i], v.data[i], r);
 }
 
+/*
+    NOTE
+
+    The transposed products go straight to the packed, blocked multiply in
+    MatSlice.cpp with transposed views of their arguments. Packing copies
+    each block into the order the kernel reads it in anyway, so no
+    transposed copy of a or b is ever made.
+
+    at a and a at are symmetric, so we compute only the blocks on and above
+    the diagonal, kGramBlock rows at a time, which is roughly half the
+    work, and then mirror them into the lower triangle.
+
+    at (a x) as two products reads a twice. Doing it a row at a time,
+    r += (a_i . x) a_i, reads each row once, while it's still in cache.
+    Threads each accumulate a partial result over their own rows, and
+    these are then summed in a fixed order.
+*/
+
+namespace
+{
+    const int kGramBlock = 96;
+
+    void MirrorUpper(TRefMat r)
+    // Copies r's upper triangle into its lower triangle
+    {
+        const int n = r.rows;
+
+        for (int i = 1; i < n; i++)
+            for (int j = 0; j < i; j++)
+                r.data[i * n + j] = r.data[j * n + i];
+    }
+}
+
+void MultiplyAtB(TConstRefMat a, TConstRefMat b, TRefMat r)
+{
+    VL_ASSERT_MSG(a.rows == b.rows, "(MultiplyAtB) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.rows == a.cols && r.cols == b.cols, "(MultiplyAtB) Matrix dimensions don't match");
+
+    Multiply(transpose(TConstSliceMat(a)), TConstSliceMat(b), TSliceMat(r));
+}
+
+void MultiplyABt(TConstRefMat a, TConstRefMat b, TRefMat r)
+{
+    VL_ASSERT_MSG(a.cols == b.cols, "(MultiplyABt) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.rows == a.rows && r.cols == b.rows, "(MultiplyABt) Matrix dimensions don't match");
+
+    Multiply(TConstSliceMat(a), transpose(TConstSliceMat(b)), TSliceMat(r));
+}
+
+void MultiplyAtA(TConstRefMat a, TRefMat r)
+{
+    VL_ASSERT_MSG(r.rows == a.cols && r.cols == a.cols, "(MultiplyAtA) Matrix dimensions don't match");
+
+    const int m = a.rows;
+    const int n = a.cols;
+
+    TConstSliceMat as(a);
+    TSliceMat      rs(r);
+
+    for (int i0 = 0; i0 < n; i0 += kGramBlock)
+    {
+        int nb = vl_min(kGramBlock, n - i0);
+        Multiply(transpose(sub(as, 0, i0, m, nb)), sub(as, 0, i0, m, n - i0), sub(rs, i0, i0, nb, n - i0));
+    }
+
+    MirrorUpper(r);
+}
+
+void MultiplyAAt(TConstRefMat a, TRefMat r)
+{
+    VL_ASSERT_MSG(r.rows == a.rows && r.cols == a.rows, "(MultiplyAAt) Matrix dimensions don't match");
+
+    const int m = a.rows;
+    const int n = a.cols;
+
+    TConstSliceMat as(a);
+    TSliceMat      rs(r);
+
+    for (int i0 = 0; i0 < m; i0 += kGramBlock)
+    {
+        int mb = vl_min(kGramBlock, m - i0);
+        Multiply(sub(as, i0, 0, mb, n), transpose(sub(as, i0, 0, m - i0, n)), sub(rs, i0, i0, mb, m - i0));
+    }
+
+    MirrorUpper(r);
+}
+
+namespace
+{
+    inline int AtAxGrain(int cols)
+    {
+        return vl_max(vl_grain(2.0 * cols), 64);
+    }
+}
+
+int MultiplyAtAxScratch(TConstRefMat a)
+{
+    int chunks = vl_parallel_chunks(kVLThreadMultiply, 2.0 * a.rows * a.cols, a.rows, AtAxGrain(a.cols));
+    return chunks > 1 ? chunks * a.cols : 0;
+}
+
+void MultiplyAtAx(TConstRefMat a, TConstRefVec x, TRefVec r, TElt* scratch)
+{
+    VL_ASSERT_MSG(x.elts == a.cols && r.elts == a.cols, "(MultiplyAtAx) Matrix/Vector dimensions don't match");
+    VL_ASSERT_MSG(r.data != x.data, "(MultiplyAtAx) r can't be the same as x");
+
+    const int    n      = a.cols;
+    const double work   = 2.0 * a.rows * n;
+    const int    grain  = AtAxGrain(n);
+    const int    chunks = vl_parallel_chunks(kVLThreadMultiply, work, a.rows, grain);
+
+    if (chunks == 1)
+    {
+        r = vl_0;
+
+        for (int i = 0; i < a.rows; i++)
+            MultiplyAccum(a[i], dot(a[i], x), r);
+
+        return;
+    }
+
+    // Per-chunk partial sums, added in order so the result doesn't depend
+    // on scheduling.
+    TVec local;
+    if (!scratch)
+    {
+        local.SetSize(chunks * n);
+        scratch = local.data;
+    }
+
+    vl_parallel_for(kVLThreadMultiply, work, a.rows, grain,
+        [&](int begin, int end)
+        {
+            for (int i0 = begin; i0 < end; i0 += grain)
+            {
+                TRefVec s(n, scratch + (i0 / grain) * n);
+                s = vl_0;
+
+                for (int i = i0, i1 = vl_min(i0 + grain, end); i < i1; i++)
+                    MultiplyAccum(a[i], dot(a[i], x), s);
+            }
+        }
+    );
+
+    r = TConstRefVec(n, scratch);
+    for (int c = 1; c < chunks; c++)
+        r += TConstRefVec(n, scratch + c * n);
+}
+
+/*
+    NOTE
+
+    A straightforward transpose reads along rows and writes down columns,
+    so for a large matrix every write touches a new cache line, and soon,
+    a new page. Instead we work in kTransposeTile square tiles, whose
+    source and destination rows both stay in cache, and within a tile, in
+    register-sized micro-tiles (see vl_transpose in Simd.cpp).
+
+    The square in-place transpose swaps tile (I, J) with the transpose of
+    tile (J, I), via a stack buffer. A rectangular matrix has no such
+    tiling, as element (i, j) moves from offset i c + j to j r + i. That
+    permutation splits into cycles, which we follow one at a time, using a
+    bit per element to mark those already moved. This is much slower than
+    the out-of-place version, but needs only n / 8 bytes of extra memory.
+*/
+
+namespace
+{
+    const int kTransposeTile = 32;
+
+    void SwapTransposeTiles(TElt* a, TElt* b, int stride, int rows, int cols)
+    // Sets the rows x cols block a to the transpose of b, and vice versa
+    {
+        TElt t[kTransposeTile * kTransposeTile];
+
+        vl_transpose(a, stride, t, kTransposeTile, rows, cols);
+        vl_transpose(b, stride, a, stride, cols, rows);
+
+        for (int j = 0; j < cols; j++)
+            for (int i = 0; i < rows; i++)
+                b[j * stride + i] = t[j * kTransposeTile + i];
+    }
+}
+
 void Transpose(TConstRefMat m, TRefMat r)
 {
     VL_ASSERT_MSG(r.cols == m.rows, "(Mat::trans) Matrix dimensions don't match");
     VL_ASSERT_MSG(r.rows == m.cols, "(Mat::trans) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.data != m.data || m.rows == 0, "(Mat::trans) use TransposeInPlace()");
+
+    const int tileRows = (m.rows + kTransposeTile - 1) / kTransposeTile;
+
+    vl_parallel_for(kVLThreadTranspose, double(m.rows) * m.cols, tileRows, vl_grain(double(kTransposeTile) * m.cols),
+        [&](int begin, int end)
+        {
+            for (int ti = begin; ti < end; ti++)
+            {
+                int i0 = ti * kTransposeTile;
+                int ni = vl_min(kTransposeTile, m.rows - i0);
+
+                for (int j0 = 0; j0 < m.cols; j0 += kTransposeTile)
+                {
+                    int nj = vl_min(kTransposeTile, m.cols - j0);
+                    vl_transpose(m.data + i0 * m.cols + j0, m.cols, r.data + j0 * r.cols + i0, r.cols, ni, nj);
+                }
+            }
+        }
+    );
+}
+
+void TransposeInPlace(TRefMat m)
+{
+    VL_ASSERT_MSG(m.rows == m.cols, "(TransposeInPlace) Matrix must be square");
+
+    const int n = m.rows;
+    const int tiles = (n + kTransposeTile - 1) / kTransposeTile;
+
+    vl_parallel_for(kVLThreadTranspose, double(n) * n / 2, tiles, vl_grain(double(kTransposeTile) * n / 2),
+        [&](int begin, int end)
+        {
+            for (int ti = begin; ti < end; ti++)
+            {
+                int i0 = ti * kTransposeTile;
+                int ni = vl_min(kTransposeTile, n - i0);
+
+                // Diagonal tile
+                for (int i = i0; i < i0 + ni; i++)
+                    for (int j = i0; j < i; j++)
+                    {
+                        TElt t = m.data[i * n + j];
+                        m.data[i * n + j] = m.data[j * n + i];
+                        m.data[j * n + i] = t;
+                    }
+
+                // Tiles to the right, with those below
+                for (int j0 = i0 + kTransposeTile; j0 < n; j0 += kTransposeTile)
+                {
+                    int nj = vl_min(kTransposeTile, n - j0);
+                    SwapTransposeTiles(m.data + i0 * n + j0, m.data + j0 * n + i0, n, ni, nj);
+                }
+            }
+        }
+    );
+}
+
+void TransposeInPlace(TMat& m)
+{
+    const int r = m.rows;
+    const int c = m.cols;
+
+    if (r == c)
+    {
+        TransposeInPlace(TRefMat(m));
+        return;
+    }
+
+    // Element k = i c + j moves to j r + i = k r mod (n - 1). The first and
+    // last elements stay put.
+    const int n = r * c;
+    std::vector<unsigned char> moved((n + 7) / 8, 0);
+
+    for (int start = 1; start < n - 1; start++)
+    {
+        if (moved[start >> 3] & (1 << (start & 7)))
+            continue;
+
+        TElt carry = m.data[start];
+        int  k = start;
+
+        do
+        {
+            int next = int((long long) k * r % (n - 1));
+            TElt t = m.data[next];
+
+            m.data[next] = carry;
+            carry = t;
+
+            moved[next >> 3] |= (unsigned char) (1 << (next & 7));
+            k = next;
+        }
+        while (k != start);
+    }
 
-    for (int i = 0; i < m.rows; i++)
-        for (int j = 0; j < m.cols; j++)
-            r(j, i) = m(i, j);
+    m.rows = c;
+    m.cols = r;
 }
 
 void Absolute(TConstRefMat m, TRefMat r)
@@ -563,6 +857,19 @@ TElt InnerProduct(TConstRefMat a, TConstRefMat b)
     return dot(a.AsVec(), b.AsVec());
 }
 
+TElt sumsqr(TConstRefMat m)
+{
+    int n = m.Elts();
+
+    return vl_parallel_sum<TElt>(kVLThreadReduce, n, n, vl_grain(1),
+        [&](int begin, int end)
+        {
+            TConstRefVec v(end - begin, m.data + begin);
+            return dot(v, v);
+        }
+    );
+}
+
 void OuterProduct(TConstRefVec a, TConstRefVec b, TRefMat r)
 {
     VL_ASSERT_MSG(r.rows == a.elts, "(Mat::oprod) Matrix dimensions don't match");
@@ -593,6 +900,10 @@ bool Invert(TConstRefMat m, TRefMat B, TElt* determinant, TElt epsilon)
     if (determinant)
         *determinant = TElt(vl_0);
 
+    // The row eliminations for each pivot are independent, so can be threaded
+    double work = double(n) * n * n;
+    int grain = vl_grain(2 * n);
+
     // ---------- Forward elimination -----------------------------------------
 
     TElt det = TElt(vl_1);
@@ -648,26 +959,36 @@ bool Invert(TConstRefMat m, TRefMat B, TElt* determinant, TElt epsilon)
 
         // We know that A(i, i) will be set to 1, so don't bother to do it
 
-        for (int j = i + 1; j < n; j++)
-        {                               // Eliminate in rows below i
-            TElt t = A(j, i);           // We're gonna zero this guy
-            for (int k = i + 1; k < n; k++) // Subtract scaled row i from row j
-                A(j, k) -= A(i, k) * t; // (Ignore k <= i, we know they're 0)
-            for (int k = 0; k < n; k++)
-                B(j, k) -= B(i, k) * t;
-        }
+        vl_parallel_for(kVLThreadInvert, work, n - i - 1, grain,
+            [&](int begin, int end)
+            {
+                for (int j = i + 1 + begin; j < i + 1 + end; j++)
+                {                               // Eliminate in rows below i
+                    TElt t = A(j, i);           // We're gonna zero this guy
+                    for (int k = i + 1; k < n; k++) // Subtract scaled row i from row j
+                        A(j, k) -= A(i, k) * t; // (Ignore k <= i, we know they're 0)
+                    for (int k = 0; k < n; k++)
+                        B(j, k) -= B(i, k) * t;
+                }
+            }
+        );
     }
 
     // ---------- Backward elimination ----------------------------------------
 
     for (int i = n - 1; i > 0; i--)         // Eliminate in column i, above diag
     {
-        for (int j = 0; j < i; j++)         // Eliminate in rows above i
-        {
-            TElt t = A(j, i);               // We're gonna zero this guy
-            for (int k = 0; k < n; k++)     // Subtract scaled row i from row j
-                B(j, k) -= B(i, k) * t;
-        }
+        vl_parallel_for(kVLThreadInvert, work, i, grain,
+            [&](int begin, int end)
+            {
+                for (int j = begin; j < end; j++)   // Eliminate in rows above i
+                {
+                    TElt t = A(j, i);               // We're gonna zero this guy
+                    for (int k = 0; k < n; k++)     // Subtract scaled row i from row j
+                        B(j, k) -= B(i, k) * t;
+                }
+            }
+        );
     }
 
     if (determinant)
@@ -0,0 +1,207 @@
+/*
+    File:       Mat34.cpp
+
+    Function:   Implements Mat34.hpp
+
+    Copyright:  Andrew Willmott
+*/
+
+
+#include "VL/Mat34.hpp"
+#include "Simd4.cpp"
+
+
+TMat34& TMat34::operator += (const TMat34& m)
+{
+    x += m.x;
+    y += m.y;
+    z += m.z;
+
+    return *this;
+}
+
+TMat34& TMat34::operator -= (const TMat34& m)
+{
+    x -= m.x;
+    y -= m.y;
+    z -= m.z;
+
+    return *this;
+}
+
+TMat34& TMat34::operator *= (const TMat34& m)
+{
+    return *this = *this * m;
+}
+
+TMat34& TMat34::operator *= (TElt s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+
+    return *this;
+}
+
+TMat34& TMat34::operator /= (TElt s)
+{
+    x /= s;
+    y /= s;
+    z /= s;
+
+    return *this;
+}
+
+
+bool TMat34::operator == (const TMat34& m) const
+{
+    return x == m.x && y == m.y && z == m.z;
+}
+
+bool TMat34::operator != (const TMat34& m) const
+{
+    return x != m.x || y != m.y || z != m.z;
+}
+
+
+TMat34 TMat34::operator + (const TMat34& m) const
+{
+    TMat34 result;
+
+    result.x = x + m.x;
+    result.y = y + m.y;
+    result.z = z + m.z;
+
+    return result;
+}
+
+TMat34 TMat34::operator - (const TMat34& m) const
+{
+    TMat34 result;
+
+    result.x = x - m.x;
+    result.y = y - m.y;
+    result.z = z - m.z;
+
+    return result;
+}
+
+TMat34 TMat34::operator - () const
+{
+    TMat34 result;
+
+    result.x = -x;
+    result.y = -y;
+    result.z = -z;
+
+    return result;
+}
+
+TMat34 TMat34::operator * (const TMat34& m) const
+// As for Mat4, with the last rows [0 0 0 1] implied
+{
+    TMat34 result;
+
+    if (vl_mat34_multiply(Ref(), m.Ref(), result.Ref()))
+        return result;
+
+    result.x.x = x.x * m.x.x + x.y * m.y.x + x.z * m.z.x;
+    result.x.y = x.x * m.x.y + x.y * m.y.y + x.z * m.z.y;
+    result.x.z = x.x * m.x.z + x.y * m.y.z + x.z * m.z.z;
+    result.x.w = x.x * m.x.w + x.y * m.y.w + x.z * m.z.w + x.w;
+
+    result.y.x = y.x * m.x.x + y.y * m.y.x + y.z * m.z.x;
+    result.y.y = y.x * m.x.y + y.y * m.y.y + y.z * m.z.y;
+    result.y.z = y.x * m.x.z + y.y * m.y.z + y.z * m.z.z;
+    result.y.w = y.x * m.x.w + y.y * m.y.w + y.z * m.z.w + y.w;
+
+    result.z.x = z.x * m.x.x + z.y * m.y.x + z.z * m.z.x;
+    result.z.y = z.x * m.x.y + z.y * m.y.y + z.z * m.z.y;
+    result.z.z = z.x * m.x.z + z.y * m.y.z + z.z * m.z.z;
+    result.z.w = z.x * m.x.w + z.y * m.y.w + z.z * m.z.w + z.w;
+
+    return result;
+}
+
+TMat34 TMat34::operator * (TElt s) const
+{
+    TMat34 result;
+
+    result.x = x * s;
+    result.y = y * s;
+    result.z = z * s;
+
+    return result;
+}
+
+TMat34 TMat34::operator / (TElt s) const
+{
+    TMat34 result;
+
+    result.x = x / s;
+    result.y = y / s;
+    result.z = z / s;
+
+    return result;
+}
+
+
+TElt det(const TMat34& m)
+{
+    return det(m.AsMat3());
+}
+
+#ifndef VL_NO_REAL
+TMat34 inv(const TMat34& m)
+// inv([R t]) = [inv(R)  -inv(R) t]
+{
+    TMat3 r = inv(m.AsMat3());
+
+    return TMat34(r, -(r * m.Translation()));
+}
+
+TMat34 inv_rigid(const TMat34& m)
+// As above, with inv(R) = trans(R)
+{
+    TMat3 r = trans(m.AsMat3());
+
+    return TMat34(r, -(r * m.Translation()));
+}
+#endif
+
+TMat34 abs(const TMat34& m)
+{
+    return TMat34(abs(m.x), abs(m.y), abs(m.z));
+}
+
+
+void TMat34::MakeZero()
+{
+    x = vl_zero;
+    y = vl_zero;
+    z = vl_zero;
+}
+
+void TMat34::MakeIdentity()
+{
+    MakeDiag(vl_one);
+}
+
+void TMat34::MakeDiag(TElt k)
+{
+    x = TVec4(k, vl_zero, vl_zero, vl_zero);
+    y = TVec4(vl_zero, k, vl_zero, vl_zero);
+    z = TVec4(vl_zero, vl_zero, k, vl_zero);
+}
+
+void TMat34::MakeBlock(TElt k)
+{
+    x.MakeBlock(k);
+    y.MakeBlock(k);
+    z.MakeBlock(k);
+}
+
+TMat4 TMat34::AsMat4() const
+{
+    return TMat4(x, y, z, TVec4(vl_w));
+}
@@ -8,6 +8,7 @@
 
 
 #include "VL/Mat4.hpp"
+#include "Simd4.cpp"
 
 
 TMat4::TMat4(TElt a, TElt b, TElt c, TElt d,
@@ -61,6 +62,9 @@ TMat4& TMat4::operator -= (const TMat4& m)
 
 TMat4& TMat4::operator *= (const TMat4& m)
 {
+    if (vl_mat4_multiply(Ref(), m.Ref(), Ref()))
+        return *this;
+
     TVec4  t0, t1, t2;
 
     t0   = x.x * m.x + x.y * m.y + x.z * m.z + x.w * m.w;
@@ -146,6 +150,9 @@ TMat4 TMat4::operator * (const TMat4& m) const
 {
     TMat4 result;
 
+    if (vl_mat4_multiply(Ref(), m.Ref(), result.Ref()))
+        return result;
+
     result.x.x = x.x * m.x.x + x.y * m.y.x + x.z * m.z.x + x.w * m.w.x;
     result.x.y = x.x * m.x.y + x.y * m.y.y + x.z * m.z.y + x.w * m.w.y;
     result.x.z = x.x * m.x.z + x.y * m.y.z + x.z * m.z.z + x.w * m.w.z;
@@ -197,6 +204,9 @@ TVec4 operator * (const TMat4& m, const TVec4& v)         // m * v
 {
     TVec4 result;
 
+    if (vl_mat4_xform(m.Ref(), v.Ref(), result.Ref()))
+        return result;
+
     result.x = v.x * m.x.x + v.y * m.x.y + v.z * m.x.z + v.w * m.x.w;
     result.y = v.x * m.y.x + v.y * m.y.y + v.z * m.y.z + v.w * m.y.w;
     result.z = v.x * m.z.x + v.y * m.z.y + v.z * m.z.z + v.w * m.z.w;
@@ -209,6 +219,9 @@ TVec4 operator * (const TVec4& v, const TMat4& m)         // v * m
 {
     TVec4 result;
 
+    if (vl_mat4_xform_row(v.Ref(), m.Ref(), result.Ref()))
+        return result;
+
     result.x = v.x * m.x.x + v.y * m.y.x + v.z * m.z.x + v.w * m.w.x;
     result.y = v.x * m.x.y + v.y * m.y.y + v.z * m.z.y + v.w * m.w.y;
     result.z = v.x * m.x.z + v.y * m.y.z + v.z * m.z.z + v.w * m.w.z;
@@ -219,6 +232,9 @@ TVec4 operator * (const TVec4& v, const TMat4& m)         // v * m
 
 TVec4& operator *= (TVec4& v, const TMat4& m)             // v *= m
 {
+    if (vl_mat4_xform_row(v.Ref(), m.Ref(), v.Ref()))
+        return v;
+
     TElt  t0, t1, t2;
 
     t0   = v.x * m.x.x + v.y * m.y.x + v.z * m.z.x + v.w * m.w.x;
@@ -236,6 +252,9 @@ TMat4 trans(const TMat4& m)
 {
     TMat4 t;
 
+    if (vl_mat4_transpose(m.Ref(), t.Ref()))
+        return t;
+
     t.x.x = m.x.x; t.x.y = m.y.x; t.x.z = m.z.x; t.x.w = m.w.x;
     t.y.x = m.x.y; t.y.y = m.y.y; t.y.z = m.z.y; t.y.w = m.w.y;
     t.z.x = m.x.z; t.z.y = m.y.z; t.z.z = m.z.z; t.z.w = m.w.z;
@@ -273,6 +292,12 @@ TMat4 inv(const TMat4& m)
     TMat4 adjoint;
     TMat4 result;
 
+    if (vl_mat4_inverse(m.Ref(), result.Ref(), &det))
+    {
+        VL_ASSERT_MSG(det != 0, "(Mat4::inv) matrix is non-singular");
+        return result;
+    }
+
     adjoint = adj(m);               // Find the adjoint
     det = dot(adjoint.x, m.x);
 
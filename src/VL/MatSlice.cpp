@@ -10,6 +10,11 @@
 #include "VL/MatSlice.hpp"
 
 #include "VL/Mat.hpp"
+#include "Threads.cpp"
+
+VL_NS_END
+#include <cstddef>
+VL_NS_BEGIN
 
 
 // --- SliceMat Assignment Operators ------------------------------------------
@@ -169,6 +174,284 @@ bool operator == (TConstSliceMat m, TConstSliceMat n)
 }
 
 
+// --- SliceMat Multiplication -----------------------------------------------
+
+/*
+    NOTE
+
+    Large products are computed with the usual packed, cache-blocked
+    scheme: 'b' is split into KC x NC blocks and 'a' into MC x KC blocks,
+    each of which is copied ("packed") into a contiguous buffer in the
+    order the inner kernel will read it. The inner kernel then computes an
+    MR x NR tile of the result held entirely in registers, streaming
+    through KC columns of a packed 'a' panel and KC rows of a packed 'b'
+    panel.
+
+    The block sizes are chosen so that a packed KC x NR panel of 'b' stays
+    in L1, the MC x KC block of 'a' in L2, and the KC x NC block of 'b' in
+    L3. Packing also means the strides of the source matrices don't matter,
+    so the same path handles dense matrices, sub-matrices, and transposed
+    views.
+*/
+
+namespace
+{
+    const int kMulMR = 4;       // rows in a register tile
+    const int kMulNR = 8;       // cols in a register tile
+    const int kMulKC = 256;     // depth of packed panels
+    const int kMulMC = 96;      // rows of 'a' per packed block (multiple of MR)
+    const int kMulNC = 2048;    // cols of 'b' per packed block (multiple of NR)
+
+    const int kMulMinBlocked = 48 * 48 * 48;  // below this many madds, use simple loops
+    const int kMulMinThreadCols = 32 * kMulNR; // columns per thread task when splitting 'b'
+
+    void PackA(TConstSliceMat a, int i0, int k0, int mc, int kc, TElt s, TElt* pa)
+    // Packs s * a[i0 .. i0 + mc][k0 .. k0 + kc] into MR-row panels, each
+    // stored column by column. Partial panels are padded with zeroes.
+    {
+        for (int ip = 0; ip < mc; ip += kMulMR)
+        {
+            int mr = vl_min(kMulMR, mc - ip);
+            const TElt* ap = a.data + (i0 + ip) * a.rspan + k0 * a.cspan;
+
+            for (int p = 0; p < kc; p++, ap += a.cspan)
+            {
+                int i = 0;
+                for (; i < mr; i++)
+                    *pa++ = s * ap[i * a.rspan];
+                for (; i < kMulMR; i++)
+                    *pa++ = TElt(vl_zero);
+            }
+        }
+    }
+
+    void PackB(TConstSliceMat b, int k0, int j0, int kc, int nc, TElt* pb)
+    // Packs b[k0 .. k0 + kc][j0 .. j0 + nc] into NR-column panels, each
+    // stored row by row. Partial panels are padded with zeroes.
+    {
+        for (int jp = 0; jp < nc; jp += kMulNR)
+        {
+            int nr = vl_min(kMulNR, nc - jp);
+            const TElt* bp = b.data + k0 * b.rspan + (j0 + jp) * b.cspan;
+
+            for (int p = 0; p < kc; p++, bp += b.rspan)
+            {
+                int j = 0;
+                for (; j < nr; j++)
+                    *pb++ = bp[j * b.cspan];
+                for (; j < kMulNR; j++)
+                    *pb++ = TElt(vl_zero);
+            }
+        }
+    }
+
+    void MulKernel(int kc, const TElt* pa, const TElt* pb, TSliceMat r, int i0, int j0, int mr, int nr, bool accum)
+    // Computes the MR x NR tile r[i0..][j0..] (+)= pa * pb, writing only the
+    // leading mr x nr part.
+    {
+        TElt ab[kMulMR][kMulNR];
+
+        for (int i = 0; i < kMulMR; i++)
+            for (int j = 0; j < kMulNR; j++)
+                ab[i][j] = TElt(vl_zero);
+
+        for (int p = 0; p < kc; p++, pa += kMulMR, pb += kMulNR)
+            for (int i = 0; i < kMulMR; i++)
+            {
+                TElt ai = pa[i];
+
+                for (int j = 0; j < kMulNR; j++)
+                    ab[i][j] += ai * pb[j];
+            }
+
+        TElt* rp = r.data + i0 * r.rspan + j0 * r.cspan;
+
+        for (int i = 0; i < mr; i++, rp += r.rspan)
+            if (accum)
+                for (int j = 0; j < nr; j++)
+                    rp[j * r.cspan] += ab[i][j];
+            else
+                for (int j = 0; j < nr; j++)
+                    rp[j * r.cspan] = ab[i][j];
+    }
+
+    void MultiplyBlocked(TConstSliceMat a, TConstSliceMat b, TSliceMat r, TElt s, bool accum)
+    // r = s * a * b, or r += s * a * b if 'accum' is set
+    {
+        int kcMax = vl_min(kMulKC, a.cols);
+        int mcMax = vl_min(kMulMC, a.rows + kMulMR - 1) / kMulMR * kMulMR;
+        int ncMax = vl_min(kMulNC, b.cols + kMulNR - 1) / kMulNR * kMulNR;
+
+        TElt* pa = VL_NEW TElt[mcMax * kcMax];
+        TElt* pb = VL_NEW TElt[kcMax * ncMax];
+
+        for (int j0 = 0; j0 < b.cols; j0 += kMulNC)
+        {
+            int nc = vl_min(kMulNC, b.cols - j0);
+
+            for (int k0 = 0; k0 < a.cols; k0 += kMulKC)
+            {
+                int kc = vl_min(kMulKC, a.cols - k0);
+
+                PackB(b, k0, j0, kc, nc, pb);
+
+                for (int i0 = 0; i0 < a.rows; i0 += kMulMC)
+                {
+                    int mc = vl_min(kMulMC, a.rows - i0);
+
+                    PackA(a, i0, k0, mc, kc, s, pa);
+
+                    for (int jr = 0; jr < nc; jr += kMulNR)
+                        for (int ir = 0; ir < mc; ir += kMulMR)
+                            MulKernel
+                            (
+                                kc, pa + ir * kc, pb + jr * kc,
+                                r, i0 + ir, j0 + jr,
+                                vl_min(kMulMR, mc - ir), vl_min(kMulNR, nc - jr),
+                                accum || k0 > 0
+                            );
+                }
+            }
+        }
+
+        VL_DELETE[] pa;
+        VL_DELETE[] pb;
+    }
+
+    void MultiplySimple(TConstSliceMat a, TConstSliceMat b, TSliceMat r, TElt s, bool accum)
+    // Row-at-a-time product for small matrices, where packing isn't worth it
+    {
+        for (int i = 0; i < a.rows; i++)
+        {
+            TElt* ri = r.data + i * r.rspan;
+            const TElt* ai = a.data + i * a.rspan;
+            const TElt* bk = b.data;
+
+            TElt ai0 = s * ai[0];
+
+            if (accum)
+                for (int j = 0; j < b.cols; j++)
+                    ri[j * r.cspan] += ai0 * bk[j * b.cspan];
+            else
+                for (int j = 0; j < b.cols; j++)
+                    ri[j * r.cspan] = ai0 * bk[j * b.cspan];
+
+            for (int k = 1; k < a.cols; k++)
+            {
+                TElt aik = s * ai[k * a.cspan];
+                bk += b.rspan;
+
+                for (int j = 0; j < b.cols; j++)
+                    ri[j * r.cspan] += aik * bk[j * b.cspan];
+            }
+        }
+    }
+
+    void Extent(TConstSliceMat m, const TElt** lo, const TElt** hi)
+    // Returns the range of memory touched by 'm'
+    {
+        int rs = (m.rows - 1) * m.rspan;
+        int cs = (m.cols - 1) * m.cspan;
+
+        *lo = m.data + vl_min(rs, 0) + vl_min(cs, 0);
+        *hi = m.data + vl_max(rs, 0) + vl_max(cs, 0);
+    }
+
+    bool Overlaps(TConstSliceMat a, TConstSliceMat b)
+    {
+        const TElt* aLo; const TElt* aHi;
+        const TElt* bLo; const TElt* bHi;
+
+        Extent(a, &aLo, &aHi);
+        Extent(b, &bLo, &bHi);
+
+        if (aHi < bLo || bHi < aLo)
+            return false;
+
+        // Distinct blocks of the same row-major matrix share an extent
+        // without sharing elements, so check their rows/cols directly.
+        if (a.cspan == 1 && b.cspan == 1 && a.rspan == b.rspan && a.rspan >= a.cols)
+        {
+            std::ptrdiff_t rs = a.rspan;
+            std::ptrdiff_t d  = b.data - a.data;
+            std::ptrdiff_t di = d >= 0 ? d / rs : -((rs - 1 - d) / rs);
+            std::ptrdiff_t dj = d - di * rs;    // b's origin is at (di, dj) relative to a's
+
+            if (dj + b.cols <= rs)
+                return di < a.rows && 0 < di + b.rows
+                    && dj < a.cols && 0 < dj + b.cols;
+        }
+
+        return true;
+    }
+
+    void MultiplyGeneral(TConstSliceMat a, TConstSliceMat b, TElt s, bool accum, TSliceMat r)
+    // r = s * a * b, or r += s * a * b if 'accum' is set
+    {
+        if (r.rows == 0 || r.cols == 0)
+            return;
+
+        if (a.cols == 0)
+        {
+            if (!accum)
+                r.MakeZero();
+            return;
+        }
+
+        if (Overlaps(r, a) || Overlaps(r, b))
+        {
+            // The kernels write r while still reading a and b, so go via a temporary
+            TMat t(r.rows, r.cols);
+            MultiplyGeneral(a, b, s, false, t);
+
+            if (accum)
+                r += t;
+            else
+                r = t;
+            return;
+        }
+
+        double work = double(a.rows) * a.cols * b.cols;
+
+        if (work < kMulMinBlocked)
+            MultiplySimple(a, b, r, s, accum);
+        else if (a.rows >= b.cols)
+            // Threads take blocks of rows, with each packing its own 'b' blocks
+            vl_parallel_for(kVLThreadMultiply, work, a.rows, kMulMC,
+                [&](int begin, int end)
+                {
+                    MultiplyBlocked(sub(a, begin, 0, end - begin, a.cols), b, sub(r, begin, 0, end - begin, r.cols), s, accum);
+                }
+            );
+        else
+            vl_parallel_for(kVLThreadMultiply, work, b.cols, kMulMinThreadCols,
+                [&](int begin, int end)
+                {
+                    MultiplyBlocked(a, sub(b, 0, begin, b.rows, end - begin), sub(r, 0, begin, r.rows, end - begin), s, accum);
+                }
+            );
+    }
+}
+
+void Multiply(TConstSliceMat a, TConstSliceMat b, TSliceMat r)
+{
+    VL_ASSERT_MSG(a.cols == b.rows, "(SliceMat::*m) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.cols == b.cols, "(SliceMat::*m) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.rows == a.rows, "(SliceMat::*m) Matrix dimensions don't match");
+
+    MultiplyGeneral(a, b, TElt(vl_one), false, r);
+}
+
+void MultiplyAccum(TConstSliceMat a, TConstSliceMat b, TElt s, TSliceMat r)
+{
+    VL_ASSERT_MSG(a.cols == b.rows, "(SliceMat::MultiplyAccum) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.cols == b.cols, "(SliceMat::MultiplyAccum) Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.rows == a.rows, "(SliceMat::MultiplyAccum) Matrix dimensions don't match");
+
+    MultiplyGeneral(a, b, s, true, r);
+}
+
+
 // --- SliceMat Arithmetic Operators ------------------------------------------
 
 
@@ -193,10 +476,7 @@ TMat operator * (TConstSliceMat m, TConstSliceMat n)
     VL_ASSERT_MSG(m.cols == n.rows, "(SliceMat::*m) Matrix dimensions don't match");
 
     TMat result(m.rows, n.cols);
-
-    for (int i = 0; i < m.rows; i++)
-        result[i] = m[i] * n;
-
+    Multiply(m, n, result);
     return result;
 }
 
@@ -8,6 +8,8 @@
 
 
 #include "VL/Quat.hpp"
+#include "VL/Wide.hpp"
+#include "Threads.cpp"
 
 
 TQuat MakeQuat(const TVec3& v1, const TVec3& v2)
@@ -269,6 +271,85 @@ TQuat SLerp(const TQuat& q1, const TQuat& q2, TElt s)
     return ratio1 * q1 + ratio2 * q2;
 }
 
+/*
+    NOTE
+
+    SLerpFast follows Eberly, "A Fast and Accurate Algorithm for Computing
+    SLERP", 2011. The SLerp weights sin(t theta) / sin(theta) are expanded
+    as polynomials in cos(theta) - 1, which converge on [0, 1], i.e., for
+    arcs of up to 90 degrees. q2 is negated if needed to take the shorter
+    arc, which keeps cos(theta) in that range. Eight terms, with the last
+    coefficient adjusted to balance the truncation error, give a maximum
+    error of 4e-5 per component, at theta = 90 degrees, i.e., a half turn.
+    It is below 1e-6 for theta < 1 radian, and below float precision for
+    theta < 0.8. There are no transcendentals or branches, so the same code
+    runs on lanes.
+*/
+
+namespace
+{
+    const int    kSLerpTerms = 8;
+    const double kSLerpOnePlusMu = 1.90110745351730037;
+
+    // u_i = 1 / (i (2i + 1)), v_i = i / (2i + 1), with the last term scaled
+    const TElt kSLerpU[kSLerpTerms] =
+    {
+        TElt(1.0 / 3), TElt(1.0 / 10), TElt(1.0 / 21), TElt(1.0 / 36),
+        TElt(1.0 / 55), TElt(1.0 / 78), TElt(1.0 / 105), TElt(kSLerpOnePlusMu / 136)
+    };
+    const TElt kSLerpV[kSLerpTerms] =
+    {
+        TElt(1.0 / 3), TElt(2.0 / 5), TElt(3.0 / 7), TElt(4.0 / 9),
+        TElt(5.0 / 11), TElt(6.0 / 13), TElt(7.0 / 15), TElt(kSLerpOnePlusMu * 8 / 17)
+    };
+
+    struct SLerpFastWeights
+    // Per-s coefficients of the weight polynomials, shared across a batch
+    {
+        TElt t;
+        TElt d;
+        TElt aT[kSLerpTerms];
+        TElt aD[kSLerpTerms];
+
+        SLerpFastWeights(TElt s) : t(s), d(TElt(1) - s)
+        {
+            for (int i = 0; i < kSLerpTerms; i++)
+            {
+                aT[i] = kSLerpU[i] * t * t - kSLerpV[i];
+                aD[i] = kSLerpU[i] * d * d - kSLerpV[i];
+            }
+        }
+    };
+
+    template<class T_Q, class T_E> inline T_Q SLerpFastKernel(const T_Q& q1, const T_Q& q2, const SLerpFastWeights& w)
+    {
+        T_E c    = dot(q1, q2);
+        T_E sign = vl_if_less(c, T_E(TElt(0)), T_E(TElt(-1)), T_E(TElt(1)));
+        T_E xm1  = c * sign - TElt(1);
+
+        T_E cT = T_E(TElt(1));
+        T_E cD = T_E(TElt(1));
+
+        // Horner evaluation of 1 + b_0 (1 + b_1 (1 + ...)), innermost first
+        for (int i = kSLerpTerms - 1; i >= 0; i--)
+        {
+            cT = TElt(1) + xm1 * w.aT[i] * cT;
+            cD = TElt(1) + xm1 * w.aD[i] * cD;
+        }
+
+        return q1 * (cD * w.d) + q2 * (cT * sign * w.t);
+    }
+}
+
+TQuat SLerpFast(const TQuat& q1, const TQuat& q2, TElt s)
+{
+    VL_ASSERT(vl_is_unit(q1));
+    VL_ASSERT(vl_is_unit(q2));
+    VL_ASSERT(s >= TElt(0) && s <= TElt(1));
+
+    return SLerpFastKernel<TQuat, TElt>(q1, q2, SLerpFastWeights(s));
+}
+
 void DecomposeTwist
 (
     const TQuat& q,
@@ -380,3 +461,245 @@ TQuat SLerp(TQuat q, TVec3 n, TElt w, TElt t)
     result += q * c;
     return result;
 }
+
+
+// --- Batch operations -------------------------------------------------------
+
+/*
+    NOTE
+
+    The batch routines load a group of quaternions into wide vectors, one
+    lane per quaternion, and run the same arithmetic as the scalar versions
+    across the group. Exact SLerp needs per-lane atan2 and sin, so it
+    computes the two weights a lane at a time, and blends in SIMD. As with
+    the batch transforms, large batches are split across threads.
+*/
+
+namespace
+{
+    const int kQuatLanes = VLLaneGroup<TElt>::kLanes;
+
+    typedef TVec3x<kQuatLanes> TWideQuatVec3;
+    typedef TVec4x<kQuatLanes> TWideQuat;
+    typedef TWideQuat::Lanes   TWideQuatElt;
+
+    template<class T_FN> void QuatGroups(int count, double workPerQuat, const T_FN& fn)
+    // Calls fn(i, n) for each group [i, i + n) of count quaternions
+    {
+        const int N = kQuatLanes;
+
+        VL_ASSERT_MSG(count >= 0, "(Quat) negative count");
+
+        int groups = (count + N - 1) / N;
+
+        vl_parallel_for(kVLThreadTransform, workPerQuat * count, groups, vl_grain(workPerQuat * N),
+            [&](int begin, int end)
+            {
+                for (int g = begin; g < end; g++)
+                    fn(g * N, vl_min(N, count - g * N));
+            }
+        );
+    }
+
+    inline void CRotFromQuat(const TWideQuat& q, TWideQuatElt m[3][3])
+    {
+        TWideQuatElt i2 = TElt(2) * q.x;
+        TWideQuatElt j2 = TElt(2) * q.y;
+        TWideQuatElt k2 = TElt(2) * q.z;
+        TWideQuatElt ij = i2 * q.y;
+        TWideQuatElt ik = i2 * q.z;
+        TWideQuatElt jk = j2 * q.z;
+        TWideQuatElt ri = i2 * q.w;
+        TWideQuatElt rj = j2 * q.w;
+        TWideQuatElt rk = k2 * q.w;
+
+        i2 *= q.x;
+        j2 *= q.y;
+        k2 *= q.z;
+
+        m[0][0] = TElt(1) - j2 - k2;  m[0][1] = ij - rk;            m[0][2] = ik + rj;
+        m[1][0] = ij + rk;            m[1][1] = TElt(1) - i2 - k2;  m[1][2] = jk - ri;
+        m[2][0] = ik - rj;            m[2][1] = jk + ri;            m[2][2] = TElt(1) - i2 - j2;
+    }
+}
+
+void QuatApply(int count, const TVec3 p[], const TQuat q[], TVec3 r[])
+{
+    QuatGroups(count, 30,
+        [=](int i, int n)
+        {
+            TWideQuatVec3 wp;
+            TWideQuat     wq;
+
+            wp.Load(p + i, n);
+            wq.Load(q + i, n);
+            QuatApply(wp, wq).Store(r + i, n);
+        }
+    );
+}
+
+void QuatMult(int count, const TQuat a[], const TQuat b[], TQuat r[])
+{
+    QuatGroups(count, 28,
+        [=](int i, int n)
+        {
+            TWideQuat wa, wb;
+
+            wa.Load(a + i, n);
+            wb.Load(b + i, n);
+            QuatMult(wa, wb).Store(r + i, n);
+        }
+    );
+}
+
+void NLerp(int count, const TQuat q1[], const TQuat q2[], TElt s, TQuat r[])
+{
+    QuatGroups(count, 16,
+        [=](int i, int n)
+        {
+            TWideQuat w1, w2;
+
+            w1.Load(q1 + i, n);
+            w2.Load(q2 + i, n);
+            NLerp(w1, w2, s).Store(r + i, n);
+        }
+    );
+}
+
+void SLerp(int count, const TQuat q1[], const TQuat q2[], TElt s, TQuat r[])
+{
+    VL_ASSERT(s >= TElt(0) && s <= TElt(1));
+
+    QuatGroups(count, 80,
+        [=](int i, int n)
+        {
+            TWideQuat w1, w2;
+
+            w1.Load(q1 + i, n);
+            w2.Load(q2 + i, n);
+
+            TWideQuatElt c = dot(w1, w2);
+            TWideQuatElt ratio1, ratio2;
+
+            // Same special cases as the scalar version
+            for (int k = 0; k < kQuatLanes; k++)
+            {
+                TElt cosHalfTheta = c[k];
+                TElt sinHalfTheta = sqrt(vl_max(TElt(1) - cosHalfTheta * cosHalfTheta, TElt(0)));
+
+                if (abs(cosHalfTheta) >= TElt(0.99999))
+                {
+                    ratio1[k] = TElt(1);
+                    ratio2[k] = TElt(0);
+                }
+                else if (sinHalfTheta < TElt(1e-5))
+                {
+                    ratio1[k] = TElt(0.5);
+                    ratio2[k] = TElt(0.5);
+                }
+                else
+                {
+                    TElt halfTheta = std::atan2(sinHalfTheta, cosHalfTheta);
+
+                    ratio1[k] = std::sin((TElt(1) - s) * halfTheta) / sinHalfTheta;
+                    ratio2[k] = std::sin(s * halfTheta) / sinHalfTheta;
+                }
+            }
+
+            (w1 * ratio1 + w2 * ratio2).Store(r + i, n);
+        }
+    );
+}
+
+void SLerpFast(int count, const TQuat q1[], const TQuat q2[], TElt s, TQuat r[])
+{
+    VL_ASSERT(s >= TElt(0) && s <= TElt(1));
+
+    SLerpFastWeights weights(s);
+
+    QuatGroups(count, 60,
+        [=, &weights](int i, int n)
+        {
+            TWideQuat w1, w2;
+
+            w1.Load(q1 + i, n);
+            w2.Load(q2 + i, n);
+            SLerpFastKernel<TWideQuat, TWideQuatElt>(w1, w2, weights).Store(r + i, n);
+        }
+    );
+}
+
+void CRotFromQuat(int count, const TQuat q[], TMat3 r[])
+{
+    QuatGroups(count, 30,
+        [=](int i, int n)
+        {
+            TWideQuat    wq;
+            TWideQuatElt m[3][3];
+
+            wq.Load(q + i, n);
+            CRotFromQuat(wq, m);
+
+            for (int k = 0; k < n; k++)
+                for (int u = 0; u < 3; u++)
+                    for (int v = 0; v < 3; v++)
+                        r[i + k][u][v] = m[u][v][k];
+        }
+    );
+}
+
+void CRotFromQuat(int count, const TQuat q[], TMat4 r[], const TVec3 translations[])
+{
+    QuatGroups(count, 40,
+        [=](int i, int n)
+        {
+            TWideQuat    wq;
+            TWideQuatElt m[3][3];
+
+            wq.Load(q + i, n);
+            CRotFromQuat(wq, m);
+
+            for (int k = 0; k < n; k++)
+            {
+                TMat4& rk = r[i + k];
+
+                for (int u = 0; u < 3; u++)
+                {
+                    for (int v = 0; v < 3; v++)
+                        rk[u][v] = m[u][v][k];
+
+                    rk[u][3] = translations ? translations[i + k][u] : TElt(0);
+                }
+
+                rk[3] = TVec4(TElt(0), TElt(0), TElt(0), TElt(1));
+            }
+        }
+    );
+}
+
+void CRotFromQuat(int count, const TQuat q[], TMat34 r[], const TVec3 translations[])
+{
+    QuatGroups(count, 36,
+        [=](int i, int n)
+        {
+            TWideQuat    wq;
+            TWideQuatElt m[3][3];
+
+            wq.Load(q + i, n);
+            CRotFromQuat(wq, m);
+
+            for (int k = 0; k < n; k++)
+            {
+                TMat34& rk = r[i + k];
+
+                for (int u = 0; u < 3; u++)
+                {
+                    for (int v = 0; v < 3; v++)
+                        rk[u][v] = m[u][v][k];
+
+                    rk[u][3] = translations ? translations[i + k][u] : TElt(0);
+                }
+            }
+        }
+    );
+}
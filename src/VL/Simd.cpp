@@ -0,0 +1,566 @@
+/*
+    File:       Simd.cpp
+
+    Function:   SIMD kernels for the core Vec operations, selected at runtime
+                according to the instruction sets supported by the CPU.
+
+                Only float and double have vector versions, other element
+                types use the generic loops.
+
+    Copyright:  Andrew Willmott
+*/
+
+#ifndef VL_SIMD_IMPL
+#define VL_SIMD_IMPL
+
+#ifndef VL_NO_SIMD
+    #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define VL_SIMD_X86
+    #elif defined(__aarch64__) || defined(_M_ARM64)
+        #define VL_SIMD_NEON
+    #endif
+#endif
+
+#if defined(VL_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define VL_SIMD_AVX2_ATTR   __attribute__((target("avx2,fma")))
+    #define VL_SIMD_AVX512_ATTR __attribute__((target("avx512f")))
+#elif defined(VL_SIMD_X86) && defined(_MSC_VER)
+    #define VL_SIMD_AVX2_ATTR
+    #define VL_SIMD_AVX512_ATTR
+#endif
+
+VL_NS_END
+#if defined(VL_SIMD_X86)
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#elif defined(VL_SIMD_NEON)
+    #include <arm_neon.h>
+#endif
+VL_NS_BEGIN
+
+// --- Generic versions -------------------------------------------------------
+
+namespace
+{
+    template<class T> inline T vl_dot(const T* a, const T* b, int n)
+    {
+        T sum = T(vl_zero);
+
+        for (int i = 0; i < n; i++)
+            sum += a[i] * b[i];
+
+        return sum;
+    }
+
+    template<class T> inline T vl_sum(const T* a, int n)
+    {
+        T s = T(vl_0);
+
+        for (int i = 0; i < n; i++)
+            s += a[i];
+
+        return s;
+    }
+
+    template<class T> inline void vl_add(const T* a, const T* b, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] = a[i] + b[i];
+    }
+
+    template<class T> inline void vl_subtract(const T* a, const T* b, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] = a[i] - b[i];
+    }
+
+    template<class T> inline void vl_multiply(const T* a, const T* b, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] = a[i] * b[i];
+    }
+
+    template<class T> inline void vl_divide(const T* a, const T* b, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] = a[i] / b[i];
+    }
+
+    template<class T> inline void vl_scale(const T* a, T s, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] = a[i] * s;
+    }
+
+    template<class T> inline void vl_scale_accum(const T* a, T s, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] += s * a[i];
+    }
+
+    template<class T> inline void vl_negate(const T* a, T* r, int n)
+    {
+        for (int i = 0; i < n; i++)
+            r[i] = - a[i];
+    }
+
+    template<class T> inline void vl_transpose(const T* a, int aStride, T* r, int rStride, int rows, int cols)
+    // Sets r[j][i] = a[i][j] for a rows x cols block
+    {
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                r[j * rStride + i] = a[i * aStride + j];
+    }
+}
+
+
+// --- SIMD versions ----------------------------------------------------------
+
+#if defined(VL_SIMD_X86) || defined(VL_SIMD_NEON)
+
+namespace
+{
+    template<class T> struct VLSimdOps
+    {
+        T    (*dot)        (const T* a, const T* b, int n);
+        T    (*sum)        (const T* a, int n);
+        void (*add)        (const T* a, const T* b, T* r, int n);
+        void (*subtract)   (const T* a, const T* b, T* r, int n);
+        void (*multiply)   (const T* a, const T* b, T* r, int n);
+        void (*divide)     (const T* a, const T* b, T* r, int n);
+        void (*scale)      (const T* a, T s, T* r, int n);
+        void (*scale_accum)(const T* a, T s, T* r, int n);
+        void (*negate)     (const T* a, T* r, int n);
+    };
+
+    template<class T> void InitGenericOps(VLSimdOps<T>* ops)
+    {
+        ops->dot         = vl_dot<T>;
+        ops->sum         = vl_sum<T>;
+        ops->add         = vl_add<T>;
+        ops->subtract    = vl_subtract<T>;
+        ops->multiply    = vl_multiply<T>;
+        ops->divide      = vl_divide<T>;
+        ops->scale       = vl_scale<T>;
+        ops->scale_accum = vl_scale_accum<T>;
+        ops->negate      = vl_negate<T>;
+    }
+
+    enum VLSimdLevel
+    {
+        kSimdNone,
+        kSimdSSE2,
+        kSimdNEON,
+        kSimdAVX2,
+        kSimdAVX512
+    };
+
+    VLSimdLevel FindSimdLevel()
+    {
+    #if defined(VL_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+            return kSimdAVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return kSimdAVX2;
+        return kSimdSSE2;
+
+    #elif defined(VL_SIMD_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool fma     = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+
+        if (!osxsave || maxLeaf < 7)
+            return kSimdSSE2;
+
+        unsigned long long xcr0 = _xgetbv(0);
+        bool osAVX    = (xcr0 & 0x06) == 0x06;  // XMM + YMM state
+        bool osAVX512 = (xcr0 & 0xE6) == 0xE6;  // ... + opmask/ZMM state
+
+        __cpuidex(info, 7, 0);
+        bool avx2    = (info[1] & (1 <<  5)) != 0;
+        bool avx512f = (info[1] & (1 << 16)) != 0;
+
+        if (avx512f && osAVX512)
+            return kSimdAVX512;
+        if (avx2 && fma && osAVX)
+            return kSimdAVX2;
+        return kSimdSSE2;
+
+    #else
+        return kSimdNEON;
+    #endif
+    }
+
+    // Generate the kernels for each instruction set via SimdKernels.cpp
+
+#if defined(VL_SIMD_X86)
+
+    // SSE2
+    #define VL_SK_ATTR
+    #define VL_SK_W 4
+    #define VL_SK_T float
+    #define VL_SK_V __m128
+    #define VL_SK_FN(NAME) NAME ## SSE2f
+    #define VL_SK_LOAD(P)       _mm_loadu_ps(P)
+    #define VL_SK_STORE(P, V)   _mm_storeu_ps(P, V)
+    #define VL_SK_SET1(S)       _mm_set1_ps(S)
+    #define VL_SK_ZERO()        _mm_setzero_ps()
+    #define VL_SK_ADD(A, B)     _mm_add_ps(A, B)
+    #define VL_SK_SUB(A, B)     _mm_sub_ps(A, B)
+    #define VL_SK_MUL(A, B)     _mm_mul_ps(A, B)
+    #define VL_SK_DIV(A, B)     _mm_div_ps(A, B)
+    #define VL_SK_MADD(A, B, C) _mm_add_ps(_mm_mul_ps(A, B), C)
+    #define VL_SK_HSUM(V)       HSumSSE2(V)
+
+    inline float HSumSSE2(__m128 v)
+    {
+        __m128 h = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+        return _mm_cvtss_f32(h);
+    }
+
+    #include "SimdKernels.cpp"
+
+    #define VL_SK_ATTR
+    #define VL_SK_W 2
+    #define VL_SK_T double
+    #define VL_SK_V __m128d
+    #define VL_SK_FN(NAME) NAME ## SSE2d
+    #define VL_SK_LOAD(P)       _mm_loadu_pd(P)
+    #define VL_SK_STORE(P, V)   _mm_storeu_pd(P, V)
+    #define VL_SK_SET1(S)       _mm_set1_pd(S)
+    #define VL_SK_ZERO()        _mm_setzero_pd()
+    #define VL_SK_ADD(A, B)     _mm_add_pd(A, B)
+    #define VL_SK_SUB(A, B)     _mm_sub_pd(A, B)
+    #define VL_SK_MUL(A, B)     _mm_mul_pd(A, B)
+    #define VL_SK_DIV(A, B)     _mm_div_pd(A, B)
+    #define VL_SK_MADD(A, B, C) _mm_add_pd(_mm_mul_pd(A, B), C)
+    #define VL_SK_HSUM(V)       HSumSSE2(V)
+
+    inline double HSumSSE2(__m128d v)
+    {
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+    }
+
+    #include "SimdKernels.cpp"
+
+    // AVX2 + FMA
+    #define VL_SK_ATTR VL_SIMD_AVX2_ATTR
+    #define VL_SK_W 8
+    #define VL_SK_T float
+    #define VL_SK_V __m256
+    #define VL_SK_FN(NAME) NAME ## AVX2f
+    #define VL_SK_LOAD(P)       _mm256_loadu_ps(P)
+    #define VL_SK_STORE(P, V)   _mm256_storeu_ps(P, V)
+    #define VL_SK_SET1(S)       _mm256_set1_ps(S)
+    #define VL_SK_ZERO()        _mm256_setzero_ps()
+    #define VL_SK_ADD(A, B)     _mm256_add_ps(A, B)
+    #define VL_SK_SUB(A, B)     _mm256_sub_ps(A, B)
+    #define VL_SK_MUL(A, B)     _mm256_mul_ps(A, B)
+    #define VL_SK_DIV(A, B)     _mm256_div_ps(A, B)
+    #define VL_SK_MADD(A, B, C) _mm256_fmadd_ps(A, B, C)
+    #define VL_SK_HSUM(V)       HSumAVX2(V)
+
+    VL_SIMD_AVX2_ATTR inline float HSumAVX2(__m256 v)
+    {
+        return HSumSSE2(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+    }
+
+    #include "SimdKernels.cpp"
+
+    #define VL_SK_ATTR VL_SIMD_AVX2_ATTR
+    #define VL_SK_W 4
+    #define VL_SK_T double
+    #define VL_SK_V __m256d
+    #define VL_SK_FN(NAME) NAME ## AVX2d
+    #define VL_SK_LOAD(P)       _mm256_loadu_pd(P)
+    #define VL_SK_STORE(P, V)   _mm256_storeu_pd(P, V)
+    #define VL_SK_SET1(S)       _mm256_set1_pd(S)
+    #define VL_SK_ZERO()        _mm256_setzero_pd()
+    #define VL_SK_ADD(A, B)     _mm256_add_pd(A, B)
+    #define VL_SK_SUB(A, B)     _mm256_sub_pd(A, B)
+    #define VL_SK_MUL(A, B)     _mm256_mul_pd(A, B)
+    #define VL_SK_DIV(A, B)     _mm256_div_pd(A, B)
+    #define VL_SK_MADD(A, B, C) _mm256_fmadd_pd(A, B, C)
+    #define VL_SK_HSUM(V)       HSumAVX2(V)
+
+    VL_SIMD_AVX2_ATTR inline double HSumAVX2(__m256d v)
+    {
+        return HSumSSE2(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+    }
+
+    #include "SimdKernels.cpp"
+
+    // AVX-512
+    #if defined(__GNUC__) && !defined(__clang__)
+        // gcc's intrinsic headers initialise their masked-off operands with
+        // self-assignment, which -Wuninitialized then flags once inlined.
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wuninitialized"
+    #endif
+
+    #define VL_SK_ATTR VL_SIMD_AVX512_ATTR
+    #define VL_SK_W 16
+    #define VL_SK_T float
+    #define VL_SK_V __m512
+    #define VL_SK_FN(NAME) NAME ## AVX512f
+    #define VL_SK_LOAD(P)       _mm512_loadu_ps(P)
+    #define VL_SK_STORE(P, V)   _mm512_storeu_ps(P, V)
+    #define VL_SK_SET1(S)       _mm512_set1_ps(S)
+    #define VL_SK_ZERO()        _mm512_setzero_ps()
+    #define VL_SK_ADD(A, B)     _mm512_add_ps(A, B)
+    #define VL_SK_SUB(A, B)     _mm512_sub_ps(A, B)
+    #define VL_SK_MUL(A, B)     _mm512_mul_ps(A, B)
+    #define VL_SK_DIV(A, B)     _mm512_div_ps(A, B)
+    #define VL_SK_MADD(A, B, C) _mm512_fmadd_ps(A, B, C)
+    #define VL_SK_HSUM(V)       _mm512_reduce_add_ps(V)
+
+    #include "SimdKernels.cpp"
+
+    #define VL_SK_ATTR VL_SIMD_AVX512_ATTR
+    #define VL_SK_W 8
+    #define VL_SK_T double
+    #define VL_SK_V __m512d
+    #define VL_SK_FN(NAME) NAME ## AVX512d
+    #define VL_SK_LOAD(P)       _mm512_loadu_pd(P)
+    #define VL_SK_STORE(P, V)   _mm512_storeu_pd(P, V)
+    #define VL_SK_SET1(S)       _mm512_set1_pd(S)
+    #define VL_SK_ZERO()        _mm512_setzero_pd()
+    #define VL_SK_ADD(A, B)     _mm512_add_pd(A, B)
+    #define VL_SK_SUB(A, B)     _mm512_sub_pd(A, B)
+    #define VL_SK_MUL(A, B)     _mm512_mul_pd(A, B)
+    #define VL_SK_DIV(A, B)     _mm512_div_pd(A, B)
+    #define VL_SK_MADD(A, B, C) _mm512_fmadd_pd(A, B, C)
+    #define VL_SK_HSUM(V)       _mm512_reduce_add_pd(V)
+
+    #include "SimdKernels.cpp"
+
+    #if defined(__GNUC__) && !defined(__clang__)
+        #pragma GCC diagnostic pop
+    #endif
+
+#elif defined(VL_SIMD_NEON)
+
+    #define VL_SK_ATTR
+    #define VL_SK_W 4
+    #define VL_SK_T float
+    #define VL_SK_V float32x4_t
+    #define VL_SK_FN(NAME) NAME ## NEONf
+    #define VL_SK_LOAD(P)       vld1q_f32(P)
+    #define VL_SK_STORE(P, V)   vst1q_f32(P, V)
+    #define VL_SK_SET1(S)       vdupq_n_f32(S)
+    #define VL_SK_ZERO()        vdupq_n_f32(0.0f)
+    #define VL_SK_ADD(A, B)     vaddq_f32(A, B)
+    #define VL_SK_SUB(A, B)     vsubq_f32(A, B)
+    #define VL_SK_MUL(A, B)     vmulq_f32(A, B)
+    #define VL_SK_DIV(A, B)     vdivq_f32(A, B)
+    #define VL_SK_MADD(A, B, C) vfmaq_f32(C, A, B)
+    #define VL_SK_HSUM(V)       vaddvq_f32(V)
+
+    #include "SimdKernels.cpp"
+
+    #define VL_SK_ATTR
+    #define VL_SK_W 2
+    #define VL_SK_T double
+    #define VL_SK_V float64x2_t
+    #define VL_SK_FN(NAME) NAME ## NEONd
+    #define VL_SK_LOAD(P)       vld1q_f64(P)
+    #define VL_SK_STORE(P, V)   vst1q_f64(P, V)
+    #define VL_SK_SET1(S)       vdupq_n_f64(S)
+    #define VL_SK_ZERO()        vdupq_n_f64(0.0)
+    #define VL_SK_ADD(A, B)     vaddq_f64(A, B)
+    #define VL_SK_SUB(A, B)     vsubq_f64(A, B)
+    #define VL_SK_MUL(A, B)     vmulq_f64(A, B)
+    #define VL_SK_DIV(A, B)     vdivq_f64(A, B)
+    #define VL_SK_MADD(A, B, C) vfmaq_f64(C, A, B)
+    #define VL_SK_HSUM(V)       vaddvq_f64(V)
+
+    #include "SimdKernels.cpp"
+
+#endif
+
+    template<class T> VLSimdOps<T> FindSimdOps()
+    {
+        VLSimdOps<T> ops;
+        InitGenericOps(&ops);
+        return ops;
+    }
+
+    template<> VLSimdOps<float> FindSimdOps<float>()
+    {
+        VLSimdOps<float> ops;
+        InitGenericOps(&ops);
+
+        switch (FindSimdLevel())
+        {
+    #if defined(VL_SIMD_X86)
+        case kSimdSSE2:   InitOpsSSE2f  (&ops); break;
+        case kSimdAVX2:   InitOpsAVX2f  (&ops); break;
+        case kSimdAVX512: InitOpsAVX512f(&ops); break;
+    #elif defined(VL_SIMD_NEON)
+        case kSimdNEON:   InitOpsNEONf  (&ops); break;
+    #endif
+        default: break;
+        }
+
+        return ops;
+    }
+
+    template<> VLSimdOps<double> FindSimdOps<double>()
+    {
+        VLSimdOps<double> ops;
+        InitGenericOps(&ops);
+
+        switch (FindSimdLevel())
+        {
+    #if defined(VL_SIMD_X86)
+        case kSimdSSE2:   InitOpsSSE2d  (&ops); break;
+        case kSimdAVX2:   InitOpsAVX2d  (&ops); break;
+        case kSimdAVX512: InitOpsAVX512d(&ops); break;
+    #elif defined(VL_SIMD_NEON)
+        case kSimdNEON:   InitOpsNEONd  (&ops); break;
+    #endif
+        default: break;
+        }
+
+        return ops;
+    }
+
+    template<class T> const VLSimdOps<T>& SimdOps()
+    {
+        static const VLSimdOps<T> sOps = FindSimdOps<T>();
+        return sOps;
+    }
+
+#define VL_SIMD_DISPATCH(T)                                                                                           \
+    inline T    vl_dot        (const T* a, const T* b, int n)       { return SimdOps<T>().dot(a, b, n); }          \
+    inline T    vl_sum        (const T* a, int n)                   { return SimdOps<T>().sum(a, n); }             \
+    inline void vl_add        (const T* a, const T* b, T* r, int n) { SimdOps<T>().add(a, b, r, n); }              \
+    inline void vl_subtract   (const T* a, const T* b, T* r, int n) { SimdOps<T>().subtract(a, b, r, n); }         \
+    inline void vl_multiply   (const T* a, const T* b, T* r, int n) { SimdOps<T>().multiply(a, b, r, n); }         \
+    inline void vl_divide     (const T* a, const T* b, T* r, int n) { SimdOps<T>().divide(a, b, r, n); }           \
+    inline void vl_scale      (const T* a, T s, T* r, int n)        { SimdOps<T>().scale(a, s, r, n); }            \
+    inline void vl_scale_accum(const T* a, T s, T* r, int n)        { SimdOps<T>().scale_accum(a, s, r, n); }      \
+    inline void vl_negate     (const T* a, T* r, int n)             { SimdOps<T>().negate(a, r, n); }
+
+    VL_SIMD_DISPATCH(float)
+    VL_SIMD_DISPATCH(double)
+
+#undef VL_SIMD_DISPATCH
+}
+
+#endif
+
+// --- Transpose micro-kernels ------------------------------------------------
+
+// Register transposes of 4 x 4 (float) or 2 x 2 (double) tiles, which
+// replace strided scalar stores with full-width ones. These only need the
+// base instruction set, so aren't dispatched.
+
+#if defined(VL_SIMD_X86)
+
+namespace
+{
+    inline void vl_transpose(const float* a, int aStride, float* r, int rStride, int rows, int cols)
+    {
+        int i = 0;
+
+        for ( ; i + 4 <= rows; i += 4)
+        {
+            const float* ai = a + i * aStride;
+            int j = 0;
+
+            for ( ; j + 4 <= cols; j += 4)
+            {
+                __m128 r0 = _mm_loadu_ps(ai + j);
+                __m128 r1 = _mm_loadu_ps(ai + j + aStride);
+                __m128 r2 = _mm_loadu_ps(ai + j + aStride * 2);
+                __m128 r3 = _mm_loadu_ps(ai + j + aStride * 3);
+
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+                float* rj = r + j * rStride + i;
+
+                _mm_storeu_ps(rj,               r0);
+                _mm_storeu_ps(rj + rStride,     r1);
+                _mm_storeu_ps(rj + rStride * 2, r2);
+                _mm_storeu_ps(rj + rStride * 3, r3);
+            }
+
+            vl_transpose<float>(ai + j, aStride, r + j * rStride + i, rStride, 4, cols - j);
+        }
+
+        vl_transpose<float>(a + i * aStride, aStride, r + i, rStride, rows - i, cols);
+    }
+
+    inline void vl_transpose(const double* a, int aStride, double* r, int rStride, int rows, int cols)
+    {
+        int i = 0;
+
+        for ( ; i + 2 <= rows; i += 2)
+        {
+            const double* ai = a + i * aStride;
+            int j = 0;
+
+            for ( ; j + 2 <= cols; j += 2)
+            {
+                __m128d r0 = _mm_loadu_pd(ai + j);
+                __m128d r1 = _mm_loadu_pd(ai + j + aStride);
+
+                double* rj = r + j * rStride + i;
+
+                _mm_storeu_pd(rj,           _mm_unpacklo_pd(r0, r1));
+                _mm_storeu_pd(rj + rStride, _mm_unpackhi_pd(r0, r1));
+            }
+
+            vl_transpose<double>(ai + j, aStride, r + j * rStride + i, rStride, 2, cols - j);
+        }
+
+        vl_transpose<double>(a + i * aStride, aStride, r + i, rStride, rows - i, cols);
+    }
+}
+
+#elif defined(VL_SIMD_NEON)
+
+namespace
+{
+    inline void vl_transpose(const float* a, int aStride, float* r, int rStride, int rows, int cols)
+    {
+        int i = 0;
+
+        for ( ; i + 4 <= rows; i += 4)
+        {
+            const float* ai = a + i * aStride;
+            int j = 0;
+
+            for ( ; j + 4 <= cols; j += 4)
+            {
+                float32x4x2_t t01 = vtrnq_f32(vld1q_f32(ai + j),               vld1q_f32(ai + j + aStride));
+                float32x4x2_t t23 = vtrnq_f32(vld1q_f32(ai + j + aStride * 2), vld1q_f32(ai + j + aStride * 3));
+
+                float* rj = r + j * rStride + i;
+
+                vst1q_f32(rj,               vcombine_f32(vget_low_f32 (t01.val[0]), vget_low_f32 (t23.val[0])));
+                vst1q_f32(rj + rStride,     vcombine_f32(vget_low_f32 (t01.val[1]), vget_low_f32 (t23.val[1])));
+                vst1q_f32(rj + rStride * 2, vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+                vst1q_f32(rj + rStride * 3, vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+            }
+
+            vl_transpose<float>(ai + j, aStride, r + j * rStride + i, rStride, 4, cols - j);
+        }
+
+        vl_transpose<float>(a + i * aStride, aStride, r + i, rStride, rows - i, cols);
+    }
+}
+
+#endif
+
+#endif
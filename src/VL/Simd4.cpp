@@ -0,0 +1,314 @@
+/*
+    File:       Simd4.cpp
+
+    Function:   SSE and NEON versions of the Mat4f products, transpose and
+                inverse, and the Mat34f product, used when VL_SIMD is
+                defined.
+
+                Each kernel returns false for element types without a vector
+                version, in which case the caller falls back to its scalar
+                code.
+
+    Copyright:  Andrew Willmott
+*/
+
+#ifndef VL_SIMD4_IMPL
+#define VL_SIMD4_IMPL
+
+/*
+    NOTE
+
+    The kernels are written in terms of a handful of four-float register
+    operations, with SSE and NEON versions, so there is one copy of each
+    algorithm. Matrices are rows of four floats, which are a single
+    register each.
+
+    The inverse follows Eric Zhang's block method: the matrix is split into
+    2x2 blocks A, B, C, D, and the inverse assembled from 2x2 adjugates of
+    those, with det(M) = |A||D| + |B||C| - tr((A#B)(D#C)). This takes about
+    a third of the operations of the scalar adjoint, and gives the same
+    results to within rounding.
+
+    Vec4f is 16-byte aligned under VL_SIMD, so rows never straddle cache
+    lines, but the loads are unaligned ones, which cost the same on current
+    hardware, so pointers from elsewhere are still safe.
+*/
+
+// --- Generic versions -------------------------------------------------------
+
+namespace
+{
+    template<class T> inline bool vl_mat4_multiply(const T*, const T*, T*)
+    { return false; }
+    template<class T> inline bool vl_mat34_multiply(const T*, const T*, T*)
+    { return false; }
+    template<class T> inline bool vl_mat4_xform(const T*, const T*, T*)
+    { return false; }
+    template<class T> inline bool vl_mat4_xform_row(const T*, const T*, T*)
+    { return false; }
+    template<class T> inline bool vl_mat4_transpose(const T*, T*)
+    { return false; }
+    template<class T> inline bool vl_mat4_inverse(const T*, T*, T*)
+    { return false; }
+}
+
+
+// --- SIMD versions ----------------------------------------------------------
+
+#ifdef VL_SIMD4
+
+namespace
+{
+#if defined(VL_LANES_SSE2)
+    typedef __m128 VLFloat4;
+
+    inline VLFloat4 vl_load4 (const float* p)           { return _mm_loadu_ps(p); }
+    inline void     vl_store4(float* p, VLFloat4 a)     { _mm_storeu_ps(p, a); }
+    inline VLFloat4 vl_set4(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+
+    inline VLFloat4 vl_add4(VLFloat4 a, VLFloat4 b)     { return _mm_add_ps(a, b); }
+    inline VLFloat4 vl_sub4(VLFloat4 a, VLFloat4 b)     { return _mm_sub_ps(a, b); }
+    inline VLFloat4 vl_mul4(VLFloat4 a, VLFloat4 b)     { return _mm_mul_ps(a, b); }
+    inline VLFloat4 vl_div4(VLFloat4 a, VLFloat4 b)     { return _mm_div_ps(a, b); }
+    inline float    vl_first4(VLFloat4 a)               { return _mm_cvtss_f32(a); }
+
+    inline VLFloat4 vl_madd4(VLFloat4 a, VLFloat4 b, VLFloat4 c)
+    // a * b + c
+    {
+    #ifdef __FMA__
+        return _mm_fmadd_ps(a, b, c);
+    #else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    #endif
+    }
+
+    template<int I0, int I1, int I2, int I3> inline VLFloat4 vl_shuffle4(VLFloat4 a, VLFloat4 b)
+    // Returns [a[I0], a[I1], b[I2], b[I3]]
+    { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0)); }
+
+#elif defined(VL_LANES_NEON)
+    typedef float32x4_t VLFloat4;
+
+    inline VLFloat4 vl_load4 (const float* p)           { return vld1q_f32(p); }
+    inline void     vl_store4(float* p, VLFloat4 a)     { vst1q_f32(p, a); }
+    inline VLFloat4 vl_set4(float x, float y, float z, float w) { const float v[4] = { x, y, z, w }; return vld1q_f32(v); }
+
+    inline VLFloat4 vl_add4(VLFloat4 a, VLFloat4 b)     { return vaddq_f32(a, b); }
+    inline VLFloat4 vl_sub4(VLFloat4 a, VLFloat4 b)     { return vsubq_f32(a, b); }
+    inline VLFloat4 vl_mul4(VLFloat4 a, VLFloat4 b)     { return vmulq_f32(a, b); }
+    inline VLFloat4 vl_div4(VLFloat4 a, VLFloat4 b)     { return vdivq_f32(a, b); }
+    inline float    vl_first4(VLFloat4 a)               { return vgetq_lane_f32(a, 0); }
+
+    inline VLFloat4 vl_madd4(VLFloat4 a, VLFloat4 b, VLFloat4 c)
+    // a * b + c
+    { return vfmaq_f32(c, a, b); }
+
+    template<int I0, int I1, int I2, int I3> inline VLFloat4 vl_shuffle4(VLFloat4 a, VLFloat4 b)
+    // Returns [a[I0], a[I1], b[I2], b[I3]]
+    {
+        VLFloat4 r = vdupq_n_f32(vgetq_lane_f32(a, I0));
+        r = vsetq_lane_f32(vgetq_lane_f32(a, I1), r, 1);
+        r = vsetq_lane_f32(vgetq_lane_f32(b, I2), r, 2);
+        r = vsetq_lane_f32(vgetq_lane_f32(b, I3), r, 3);
+        return r;
+    }
+#endif
+
+    template<int I> inline VLFloat4 vl_splat4(VLFloat4 a)
+    // Returns a[I] in all lanes
+    { return vl_shuffle4<I, I, I, I>(a, a); }
+
+    template<int I0, int I1, int I2, int I3> inline VLFloat4 vl_swizzle4(VLFloat4 a)
+    { return vl_shuffle4<I0, I1, I2, I3>(a, a); }
+
+    inline void vl_transpose4(VLFloat4& r0, VLFloat4& r1, VLFloat4& r2, VLFloat4& r3)
+    {
+        VLFloat4 t0 = vl_shuffle4<0, 1, 0, 1>(r0, r1);
+        VLFloat4 t1 = vl_shuffle4<2, 3, 2, 3>(r0, r1);
+        VLFloat4 t2 = vl_shuffle4<0, 1, 0, 1>(r2, r3);
+        VLFloat4 t3 = vl_shuffle4<2, 3, 2, 3>(r2, r3);
+
+        r0 = vl_shuffle4<0, 2, 0, 2>(t0, t2);
+        r1 = vl_shuffle4<1, 3, 1, 3>(t0, t2);
+        r2 = vl_shuffle4<0, 2, 0, 2>(t1, t3);
+        r3 = vl_shuffle4<1, 3, 1, 3>(t1, t3);
+    }
+
+    inline VLFloat4 vl_combine4(VLFloat4 v, VLFloat4 r0, VLFloat4 r1, VLFloat4 r2, VLFloat4 r3)
+    // Returns v.x * r0 + v.y * r1 + v.z * r2 + v.w * r3
+    {
+        VLFloat4 r = vl_mul4(vl_splat4<0>(v), r0);
+        r = vl_madd4(vl_splat4<1>(v), r1, r);
+        r = vl_madd4(vl_splat4<2>(v), r2, r);
+        return vl_madd4(vl_splat4<3>(v), r3, r);
+    }
+
+    inline bool vl_mat4_multiply(const float* a, const float* b, float* r)
+    // r = a * b, safe for r == a or r == b
+    {
+        VLFloat4 b0 = vl_load4(b);
+        VLFloat4 b1 = vl_load4(b + 4);
+        VLFloat4 b2 = vl_load4(b + 8);
+        VLFloat4 b3 = vl_load4(b + 12);
+
+        VLFloat4 r0 = vl_combine4(vl_load4(a),      b0, b1, b2, b3);
+        VLFloat4 r1 = vl_combine4(vl_load4(a + 4),  b0, b1, b2, b3);
+        VLFloat4 r2 = vl_combine4(vl_load4(a + 8),  b0, b1, b2, b3);
+        VLFloat4 r3 = vl_combine4(vl_load4(a + 12), b0, b1, b2, b3);
+
+        vl_store4(r,      r0);
+        vl_store4(r + 4,  r1);
+        vl_store4(r + 8,  r2);
+        vl_store4(r + 12, r3);
+        return true;
+    }
+
+    inline bool vl_mat34_multiply(const float* a, const float* b, float* r)
+    // As above, with the last rows [0 0 0 1] implied
+    {
+        VLFloat4 b0 = vl_load4(b);
+        VLFloat4 b1 = vl_load4(b + 4);
+        VLFloat4 b2 = vl_load4(b + 8);
+        VLFloat4 b3 = vl_set4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        VLFloat4 r0 = vl_combine4(vl_load4(a),     b0, b1, b2, b3);
+        VLFloat4 r1 = vl_combine4(vl_load4(a + 4), b0, b1, b2, b3);
+        VLFloat4 r2 = vl_combine4(vl_load4(a + 8), b0, b1, b2, b3);
+
+        vl_store4(r,     r0);
+        vl_store4(r + 4, r1);
+        vl_store4(r + 8, r2);
+        return true;
+    }
+
+    inline bool vl_mat4_xform(const float* m, const float* v, float* r)
+    // r = m * v
+    {
+        VLFloat4 c0 = vl_load4(m);
+        VLFloat4 c1 = vl_load4(m + 4);
+        VLFloat4 c2 = vl_load4(m + 8);
+        VLFloat4 c3 = vl_load4(m + 12);
+
+        vl_transpose4(c0, c1, c2, c3);
+        vl_store4(r, vl_combine4(vl_load4(v), c0, c1, c2, c3));
+        return true;
+    }
+
+    inline bool vl_mat4_xform_row(const float* v, const float* m, float* r)
+    // r = v * m
+    {
+        vl_store4(r, vl_combine4(vl_load4(v), vl_load4(m), vl_load4(m + 4), vl_load4(m + 8), vl_load4(m + 12)));
+        return true;
+    }
+
+    inline bool vl_mat4_transpose(const float* m, float* r)
+    {
+        VLFloat4 r0 = vl_load4(m);
+        VLFloat4 r1 = vl_load4(m + 4);
+        VLFloat4 r2 = vl_load4(m + 8);
+        VLFloat4 r3 = vl_load4(m + 12);
+
+        vl_transpose4(r0, r1, r2, r3);
+
+        vl_store4(r,      r0);
+        vl_store4(r + 4,  r1);
+        vl_store4(r + 8,  r2);
+        vl_store4(r + 12, r3);
+        return true;
+    }
+
+    // 2x2 matrices, stored as [m00, m01, m10, m11]
+
+    inline VLFloat4 vl_mat2_mul(VLFloat4 a, VLFloat4 b)
+    // a * b
+    {
+        return vl_add4
+        (
+            vl_mul4(a, vl_swizzle4<0, 3, 0, 3>(b)),
+            vl_mul4(vl_swizzle4<1, 0, 3, 2>(a), vl_swizzle4<2, 1, 2, 1>(b))
+        );
+    }
+
+    inline VLFloat4 vl_mat2_adj_mul(VLFloat4 a, VLFloat4 b)
+    // adj(a) * b
+    {
+        return vl_sub4
+        (
+            vl_mul4(vl_swizzle4<3, 3, 0, 0>(a), b),
+            vl_mul4(vl_swizzle4<1, 1, 2, 2>(a), vl_swizzle4<2, 3, 0, 1>(b))
+        );
+    }
+
+    inline VLFloat4 vl_mat2_mul_adj(VLFloat4 a, VLFloat4 b)
+    // a * adj(b)
+    {
+        return vl_sub4
+        (
+            vl_mul4(a, vl_swizzle4<3, 0, 3, 0>(b)),
+            vl_mul4(vl_swizzle4<1, 0, 3, 2>(a), vl_swizzle4<2, 1, 2, 1>(b))
+        );
+    }
+
+    inline bool vl_mat4_inverse(const float* m, float* r, float* det)
+    // Sets r = inv(m) and *det = det(m)
+    {
+        VLFloat4 r0 = vl_load4(m);
+        VLFloat4 r1 = vl_load4(m + 4);
+        VLFloat4 r2 = vl_load4(m + 8);
+        VLFloat4 r3 = vl_load4(m + 12);
+
+        // 2x2 blocks
+        VLFloat4 a = vl_shuffle4<0, 1, 0, 1>(r0, r1);
+        VLFloat4 b = vl_shuffle4<2, 3, 2, 3>(r0, r1);
+        VLFloat4 c = vl_shuffle4<0, 1, 0, 1>(r2, r3);
+        VLFloat4 d = vl_shuffle4<2, 3, 2, 3>(r2, r3);
+
+        // [|A|, |B|, |C|, |D|]
+        VLFloat4 detSub = vl_sub4
+        (
+            vl_mul4(vl_shuffle4<0, 2, 0, 2>(r0, r2), vl_shuffle4<1, 3, 1, 3>(r1, r3)),
+            vl_mul4(vl_shuffle4<1, 3, 1, 3>(r0, r2), vl_shuffle4<0, 2, 0, 2>(r1, r3))
+        );
+
+        VLFloat4 detA = vl_splat4<0>(detSub);
+        VLFloat4 detB = vl_splat4<1>(detSub);
+        VLFloat4 detC = vl_splat4<2>(detSub);
+        VLFloat4 detD = vl_splat4<3>(detSub);
+
+        VLFloat4 dc = vl_mat2_adj_mul(d, c);
+        VLFloat4 ab = vl_mat2_adj_mul(a, b);
+
+        // inv(M) = 1/|M| [X Y; Z W], where these are the adjugates of:
+        VLFloat4 x = vl_sub4(vl_mul4(detD, a), vl_mat2_mul(b, dc));
+        VLFloat4 w = vl_sub4(vl_mul4(detA, d), vl_mat2_mul(c, ab));
+        VLFloat4 y = vl_sub4(vl_mul4(detB, c), vl_mat2_mul_adj(d, ab));
+        VLFloat4 z = vl_sub4(vl_mul4(detC, b), vl_mat2_mul_adj(a, dc));
+
+        // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+        VLFloat4 tr = vl_mul4(ab, vl_swizzle4<0, 2, 1, 3>(dc));
+        tr = vl_add4(tr, vl_swizzle4<1, 0, 3, 2>(tr));
+        tr = vl_add4(tr, vl_swizzle4<2, 3, 0, 1>(tr));
+
+        VLFloat4 detM = vl_sub4(vl_madd4(detA, detD, vl_mul4(detB, detC)), tr);
+        *det = vl_first4(detM);
+
+        // Fold the adjugate signs into 1/|M|
+        VLFloat4 rDetM = vl_div4(vl_set4(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+        x = vl_mul4(x, rDetM);
+        y = vl_mul4(y, rDetM);
+        z = vl_mul4(z, rDetM);
+        w = vl_mul4(w, rDetM);
+
+        // Take the adjugates while reassembling the rows
+        vl_store4(r,      vl_shuffle4<3, 1, 3, 1>(x, y));
+        vl_store4(r + 4,  vl_shuffle4<2, 0, 2, 0>(x, y));
+        vl_store4(r + 8,  vl_shuffle4<3, 1, 3, 1>(z, w));
+        vl_store4(r + 12, vl_shuffle4<2, 0, 2, 0>(z, w));
+        return true;
+    }
+}
+
+#endif
+
+#endif
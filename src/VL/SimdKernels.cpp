@@ -0,0 +1,184 @@
+/*
+    File:       SimdKernels.cpp
+
+    Function:   Bodies of the SIMD Vec kernels. This file is included
+                multiple times by Simd.cpp, once per element type and
+                instruction set, in the same way that Begin.hpp is used to
+                compile the library for multiple element types.
+
+                Expects the following to be defined:
+
+                VL_SK_T             element type
+                VL_SK_V             vector register type
+                VL_SK_W             elements per register
+                VL_SK_FN(NAME)      adds a type/instruction set suffix to NAME
+                VL_SK_ATTR          function attribute to enable the instruction set
+
+                VL_SK_LOAD(P), VL_SK_STORE(P, V), VL_SK_SET1(S), VL_SK_ZERO()
+                VL_SK_ADD(A, B), VL_SK_SUB(A, B), VL_SK_MUL(A, B), VL_SK_DIV(A, B)
+                VL_SK_MADD(A, B, C) -- A * B + C
+                VL_SK_HSUM(V)       -- horizontal sum of the elements of V
+
+                These are all undefined again at the end of the file.
+
+    Copyright:  Andrew Willmott
+*/
+
+VL_SK_ATTR VL_SK_T VL_SK_FN(Dot)(const VL_SK_T* a, const VL_SK_T* b, int n)
+{
+    // Four independent accumulators to hide the add latency
+    VL_SK_V s0 = VL_SK_ZERO();
+    VL_SK_V s1 = VL_SK_ZERO();
+    VL_SK_V s2 = VL_SK_ZERO();
+    VL_SK_V s3 = VL_SK_ZERO();
+
+    int i = 0;
+
+    for (; i + 4 * VL_SK_W <= n; i += 4 * VL_SK_W)
+    {
+        s0 = VL_SK_MADD(VL_SK_LOAD(a + i              ), VL_SK_LOAD(b + i              ), s0);
+        s1 = VL_SK_MADD(VL_SK_LOAD(a + i +     VL_SK_W), VL_SK_LOAD(b + i +     VL_SK_W), s1);
+        s2 = VL_SK_MADD(VL_SK_LOAD(a + i + 2 * VL_SK_W), VL_SK_LOAD(b + i + 2 * VL_SK_W), s2);
+        s3 = VL_SK_MADD(VL_SK_LOAD(a + i + 3 * VL_SK_W), VL_SK_LOAD(b + i + 3 * VL_SK_W), s3);
+    }
+
+    for (; i + VL_SK_W <= n; i += VL_SK_W)
+        s0 = VL_SK_MADD(VL_SK_LOAD(a + i), VL_SK_LOAD(b + i), s0);
+
+    VL_SK_T sum = VL_SK_HSUM(VL_SK_ADD(VL_SK_ADD(s0, s1), VL_SK_ADD(s2, s3)));
+
+    for (; i < n; i++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+VL_SK_ATTR VL_SK_T VL_SK_FN(Sum)(const VL_SK_T* a, int n)
+{
+    VL_SK_V s0 = VL_SK_ZERO();
+    VL_SK_V s1 = VL_SK_ZERO();
+    VL_SK_V s2 = VL_SK_ZERO();
+    VL_SK_V s3 = VL_SK_ZERO();
+
+    int i = 0;
+
+    for (; i + 4 * VL_SK_W <= n; i += 4 * VL_SK_W)
+    {
+        s0 = VL_SK_ADD(VL_SK_LOAD(a + i              ), s0);
+        s1 = VL_SK_ADD(VL_SK_LOAD(a + i +     VL_SK_W), s1);
+        s2 = VL_SK_ADD(VL_SK_LOAD(a + i + 2 * VL_SK_W), s2);
+        s3 = VL_SK_ADD(VL_SK_LOAD(a + i + 3 * VL_SK_W), s3);
+    }
+
+    for (; i + VL_SK_W <= n; i += VL_SK_W)
+        s0 = VL_SK_ADD(VL_SK_LOAD(a + i), s0);
+
+    VL_SK_T sum = VL_SK_HSUM(VL_SK_ADD(VL_SK_ADD(s0, s1), VL_SK_ADD(s2, s3)));
+
+    for (; i < n; i++)
+        sum += a[i];
+
+    return sum;
+}
+
+#define VL_SK_BINARY_OP(NAME, OP, SCALAR_OP)                                    \
+VL_SK_ATTR void VL_SK_FN(NAME)(const VL_SK_T* a, const VL_SK_T* b, VL_SK_T* r, int n) \
+{                                                                               \
+    int i = 0;                                                                  \
+                                                                                \
+    for (; i + 2 * VL_SK_W <= n; i += 2 * VL_SK_W)                              \
+    {                                                                           \
+        VL_SK_V r0 = OP(VL_SK_LOAD(a + i          ), VL_SK_LOAD(b + i          )); \
+        VL_SK_V r1 = OP(VL_SK_LOAD(a + i + VL_SK_W), VL_SK_LOAD(b + i + VL_SK_W)); \
+        VL_SK_STORE(r + i          , r0);                                       \
+        VL_SK_STORE(r + i + VL_SK_W, r1);                                       \
+    }                                                                           \
+                                                                                \
+    for (; i + VL_SK_W <= n; i += VL_SK_W)                                      \
+        VL_SK_STORE(r + i, OP(VL_SK_LOAD(a + i), VL_SK_LOAD(b + i)));           \
+                                                                                \
+    for (; i < n; i++)                                                          \
+        r[i] = a[i] SCALAR_OP b[i];                                             \
+}
+
+VL_SK_BINARY_OP(Add,      VL_SK_ADD, +)
+VL_SK_BINARY_OP(Subtract, VL_SK_SUB, -)
+VL_SK_BINARY_OP(Multiply, VL_SK_MUL, *)
+VL_SK_BINARY_OP(Divide,   VL_SK_DIV, /)
+
+#undef VL_SK_BINARY_OP
+
+VL_SK_ATTR void VL_SK_FN(Scale)(const VL_SK_T* a, VL_SK_T s, VL_SK_T* r, int n)
+{
+    VL_SK_V sv = VL_SK_SET1(s);
+    int i = 0;
+
+    for (; i + 2 * VL_SK_W <= n; i += 2 * VL_SK_W)
+    {
+        VL_SK_V r0 = VL_SK_MUL(VL_SK_LOAD(a + i          ), sv);
+        VL_SK_V r1 = VL_SK_MUL(VL_SK_LOAD(a + i + VL_SK_W), sv);
+        VL_SK_STORE(r + i          , r0);
+        VL_SK_STORE(r + i + VL_SK_W, r1);
+    }
+
+    for (; i + VL_SK_W <= n; i += VL_SK_W)
+        VL_SK_STORE(r + i, VL_SK_MUL(VL_SK_LOAD(a + i), sv));
+
+    for (; i < n; i++)
+        r[i] = a[i] * s;
+}
+
+VL_SK_ATTR void VL_SK_FN(ScaleAccum)(const VL_SK_T* a, VL_SK_T s, VL_SK_T* r, int n)
+{
+    VL_SK_V sv = VL_SK_SET1(s);
+    int i = 0;
+
+    for (; i + 2 * VL_SK_W <= n; i += 2 * VL_SK_W)
+    {
+        VL_SK_V r0 = VL_SK_MADD(sv, VL_SK_LOAD(a + i          ), VL_SK_LOAD(r + i          ));
+        VL_SK_V r1 = VL_SK_MADD(sv, VL_SK_LOAD(a + i + VL_SK_W), VL_SK_LOAD(r + i + VL_SK_W));
+        VL_SK_STORE(r + i          , r0);
+        VL_SK_STORE(r + i + VL_SK_W, r1);
+    }
+
+    for (; i + VL_SK_W <= n; i += VL_SK_W)
+        VL_SK_STORE(r + i, VL_SK_MADD(sv, VL_SK_LOAD(a + i), VL_SK_LOAD(r + i)));
+
+    for (; i < n; i++)
+        r[i] += s * a[i];
+}
+
+VL_SK_ATTR void VL_SK_FN(Negate)(const VL_SK_T* a, VL_SK_T* r, int n)
+{
+    // Multiply rather than subtract from zero so that -(0) = -0, as for scalars
+    VL_SK_FN(Scale)(a, VL_SK_T(-1), r, n);
+}
+
+void VL_SK_FN(InitOps)(VLSimdOps<VL_SK_T>* ops)
+{
+    ops->dot         = VL_SK_FN(Dot);
+    ops->sum         = VL_SK_FN(Sum);
+    ops->add         = VL_SK_FN(Add);
+    ops->subtract    = VL_SK_FN(Subtract);
+    ops->multiply    = VL_SK_FN(Multiply);
+    ops->divide      = VL_SK_FN(Divide);
+    ops->scale       = VL_SK_FN(Scale);
+    ops->scale_accum = VL_SK_FN(ScaleAccum);
+    ops->negate      = VL_SK_FN(Negate);
+}
+
+#undef VL_SK_T
+#undef VL_SK_V
+#undef VL_SK_W
+#undef VL_SK_FN
+#undef VL_SK_ATTR
+#undef VL_SK_LOAD
+#undef VL_SK_STORE
+#undef VL_SK_SET1
+#undef VL_SK_ZERO
+#undef VL_SK_ADD
+#undef VL_SK_SUB
+#undef VL_SK_MUL
+#undef VL_SK_DIV
+#undef VL_SK_MADD
+#undef VL_SK_HSUM
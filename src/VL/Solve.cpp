@@ -12,118 +12,613 @@
 namespace
 {
     const int kMaxSolveSteps = 10000;
-}
 
+    // Number of n-vectors of scratch space used by each solver
+    const int kConjGradVecs         = 3;
+    const int kPrecondConjGradVecs  = 4;
+    const int kBiCGStabVecs         = 6;
 
-/** Solves Ax = b via gaussian elimination.
+    template<class T_MAT> inline int ConjGradAtAScratch(const T_MAT& A)
+    {
+        return 3 * A.Cols() + A.Rows();
+    }
 
-    Each iteration modifies the current approximate solution x.
-    Omega controls overrelaxation: omega = 1 gives Gauss-Seidel,
-    omega somewhere beteen 1 and 2 gives the fastest convergence.
+#ifndef VL_MIXED
+    inline int ConjGradAtAScratch(TConstRefMat A)
+    // The temp for A x doubles as MultiplyAtAx's scratch
+    {
+        return 3 * A.Cols() + vl_max(A.Rows(), MultiplyAtAxScratch(A));
+    }
+#endif
 
-    x is the initial guess on input, and solution vector on output.
+    inline int GMRESScratch(int n, int m)
+    {
+        m = vl_max(vl_min(m, n), 1);
+        return n + (m + 1) * n + (m + 1) * m + 4 * m + 1;
+    }
 
-    If steps is zero, the routine iterates until the residual is
-    less than epsilon. Otherwise, it performs at most *steps
-    iterations, and returns the actual number of iterations performed
-    in *steps.
+    inline TElt* ScratchSpace(TElt* scratch, TVec& local, int elts)
+    // Returns 'scratch' if given, and otherwise 'elts' elements of local
+    // storage.
+    {
+        if (scratch)
+            return scratch;
 
-    Returns approximate squared length of residual vector: |Ax-b|^2.
+        local.SetSize(elts);
+        return local.data;
+    }
 
-    [Strang, "Introduction to Applied Mathematics", 1986, p. 407]
-*/
+    template<class T_MAT> inline void ApplyAtA(const T_MAT& A, TConstRefVec x, TRefVec r, TRefVec t)
+    // r = At A x, using t for A x
+    {
+        Multiply(A, x, t);
+        Multiply(t, A, r);      // t_t A = trans(A_t t)
+    }
 
-TMElt SolveOverRelax
-(
-    TConstRefMat A,
-    TRefVec      x,
-    TConstRefVec b,
-    TMElt        epsilon,
-    TMElt        omega,
-    int*         steps
-)
-{
-    VL_ASSERT_MSG(is_square(A), "(SolveOverRelax) Matrix not square");
-    int jMax;
+#ifndef VL_MIXED
+    inline void ApplyAtA(TConstRefMat A, TConstRefVec x, TRefVec r, TRefVec t)
+    // As above, reading A once, with t.data having room for
+    // MultiplyAtAxScratch() elements
+    {
+        MultiplyAtAx(A, x, r, t.data);
+    }
+#endif
+
+    inline TMElt RowDot(TConstRefMat A, int i, TConstRefVec x)
+    {
+        return dot(A[i], x);
+    }
+
+#ifndef VL_MIXED
+    inline TMElt RowDot(const TSparseMat& A, int i, TConstRefVec x)
+    {
+        const int*  indices = A.RowIndices(i);
+        const TElt* elts    = A.RowData(i);
+        TElt        sum     = TElt(vl_zero);
+
+        for (int k = 0, n = A.RowElts(i); k < n; k++)
+            sum += elts[k] * x[indices[k]];
+
+        return sum;
+    }
+#endif
+
+    /** Solves Ax = b via gaussian elimination.
+
+        Each iteration modifies the current approximate solution x.
+        Omega controls overrelaxation: omega = 1 gives Gauss-Seidel,
+        omega somewhere beteen 1 and 2 gives the fastest convergence.
+
+        x is the initial guess on input, and solution vector on output.
 
-    if (steps)
-        jMax = *steps;
-    else
-        jMax = kMaxSolveSteps;
+        If steps is zero, the routine iterates until the residual is
+        less than epsilon. Otherwise, it performs at most *steps
+        iterations, and returns the actual number of iterations performed
+        in *steps.
 
-    int j = 0;
-    TMElt error;
+        Returns approximate squared length of residual vector: |Ax-b|^2.
 
-    do
+        [Strang, "Introduction to Applied Mathematics", 1986, p. 407]
+    */
+
+    template<class T_MAT> TMElt OverRelax
+    (
+        const T_MAT& A,
+        TRefVec      x,
+        TConstRefVec b,
+        TMElt        epsilon,
+        TMElt        omega,
+        int*         steps
+    )
     {
-        error = 0.0;
+        VL_ASSERT_MSG(is_square(A), "(SolveOverRelax) Matrix not square");
+        int jMax;
+
+        if (steps)
+            jMax = *steps;
+        else
+            jMax = kMaxSolveSteps;
 
-        for (int i = 0; i < A.Rows(); i++)
+        int j = 0;
+        TMElt error;
+
+        do
         {
-            TMElt sum = b[i] - dot(A[i], x);
-            TMElt diagonal = A(i, i);
-            sum += diagonal * x[i];
-            // I.e., sum = b[i] - (A[i] * x - A[i,i])
-            TMElt xOld = x[i];
-
-            if (diagonal == TMElt(0))
-                VL_WARNING("(SolveOverRelax) diagonal element = 0");
-            else if (omega == TMElt(1.0))  // Gauss-Seidel
-                x[i] = TElt(sum / diagonal);
-            else                    // Overrelax
-                x[i] = TElt(lerp(xOld, sum / diagonal, omega));
-
-            sum -= diagonal * xOld;
-            error += sqr(sum);
+            error = 0.0;
+
+            for (int i = 0; i < A.Rows(); i++)
+            {
+                TMElt sum = b[i] - RowDot(A, i, x);
+                TMElt diagonal = A(i, i);
+                sum += diagonal * x[i];
+                // I.e., sum = b[i] - (A[i] * x - A[i,i])
+                TMElt xOld = x[i];
+
+                if (diagonal == TMElt(0))
+                    VL_WARNING("(SolveOverRelax) diagonal element = 0");
+                else if (omega == TMElt(1.0))  // Gauss-Seidel
+                    x[i] = TElt(sum / diagonal);
+                else                    // Overrelax
+                    x[i] = TElt(lerp(xOld, sum / diagonal, omega));
+
+                sum -= diagonal * xOld;
+                error += sqr(sum);
+            }
+            j++;
         }
-        j++;
+        while (error > epsilon && j < jMax);
+
+        if (steps)
+            *steps = j;
+
+        return error;
     }
-    while (error > epsilon && j < jMax);
 
-    if (steps)
-        *steps = j;
 
-    return error;
-}
+    /**
+        Solve Ax = b by conjugate gradient method, for symmetric, positive
+        definite A.
 
+        x is the initial guess on input, and solution vector on output.
 
-/**
-    Solve Ax = b by conjugate gradient method, for symmetric, positive
-    definite A.
+        Returns squared length of residual vector.
 
-    x is the initial guess on input, and solution vector on output.
+        If A is not symmetric, this will solve the system (A + At)x/2 = b
 
-    Returns squared length of residual vector.
+        [Strang, "Introduction to Applied Mathematics", 1986, p. 422]
+    */
 
-    If A is not symmetric, this will solve the system (A + At)x/2 = b
+    template<class T_MAT> TMElt ConjGrad
+    (
+        const T_MAT& A,         // Solve Ax = b.
+        TRefVec      x,
+        TConstRefVec b,
+        TElt         epsilon,   // how low should we go?
+        int*         steps,     // iterations to converge.
+        TElt*        scratch    // kConjGradVecs * n elements, or 0
+    )
+    {
+        VL_ASSERT_MSG(is_square(A), "(SolveConjGrad) Matrix not square");
 
-    [Strang, "Introduction to Applied Mathematics", 1986, p. 422]
-*/
+        const int n = A.Rows();
+        TVec  local;
+        TElt* p = ScratchSpace(scratch, local, kConjGradVecs * n);
 
-TMElt SolveConjGrad
-(
-    TConstRefMat A,         // Solve Ax = b.
-    TRefVec      x,
-    TConstRefVec b,
-    TElt         epsilon,   // how low should we go?
-    int*         steps      // iterations to converge.
-)
-{
-    VL_ASSERT_MSG(is_square(A), "(SolveConjGrad) Matrix not square");
+        TRefVec r(n, p);        // Residual vector, b - Ax
+        TRefVec t(n, p + n);    // temp!
+        TRefVec d(n, p + 2 * n);
+
+        // r = b - A * x;
+        Multiply(A, x, t);
+        Subtract(b, t, r);
+
+        TElt rSqrLen = sqrlen(r);
+        int i = 0;
+
+        if (rSqrLen > epsilon)
+        {
+            d = r;
+
+            int iMax;
+            if (steps)
+                iMax = *steps;
+            else
+                iMax = kMaxSolveSteps;
+
+            while (i < iMax)
+            {
+                i++;
+                // t = A * d;
+                Multiply(A, d, t);
+                TElt u = dot(d, t);
 
-    TVec r(A.Rows());       // Residual vector, b - Ax
-    TVec t(A.Rows());       // temp!
+                if (len(u) < TElt(1e-12))
+                {
+                    VL_WARNING("(SolveConjGrad) d'Ad = 0");
+                    break;
+                }
 
-    // r = b - A * x;
-    Multiply(A, x, t);
-    Subtract(b, t, r);
+                TElt alpha = rSqrLen / u;  // How far should we go?
+                // x += alpha * d;         // Take a step along direction d
+                MultiplyAccum(d,  alpha, x);
 
-    TElt rSqrLen = sqrlen(r);
-    int i = 0;
+                if (i & 0x3F)
+                    // r -= alpha * t;
+                    MultiplyAccum(t, -alpha, r);
+                else
+                {
+                    // For stability, correct r every 64th iteration
+                    // r = b - A * x;
+                    Multiply(A, x, t);
+                    Subtract(b, t, r);
+                }
 
-    if (rSqrLen > epsilon)
+                TElt rSqrLenOld = rSqrLen;
+                rSqrLen = sqrlen(r);
+
+                if (rSqrLen <= epsilon)
+                    break;                  // Converged! Let's get out of here
+
+                TElt beta = rSqrLen / rSqrLenOld;
+                // d = r + beta * d;        //  Change direction
+                d *= beta;
+                d += r;
+            }
+        }
+
+        if (steps)
+            *steps = i;
+
+        return rSqrLen;
+    }
+
+    template<class T_MAT> TMElt ConjGrad_AtA
+    (
+        const T_MAT& A,         // Solve AtA x = At b.
+        TRefVec      x,
+        TConstRefVec b,
+        TElt         epsilon,   // how low should we go?
+        int*         steps,     // iterations to converge.
+        TElt*        scratch    // ConjGradAtAScratch(A) elements, or 0
+    )
+    {
+        const int m = A.Rows();
+        const int n = A.Cols();
+        TVec  local;
+        TElt* p = ScratchSpace(scratch, local, ConjGradAtAScratch(A));
+
+        TRefVec r (n, p);           // Residual vector, Atb - AtAx
+        TRefVec t (n, p + n);       // temp
+        TRefVec d (n, p + 2 * n);
+        TRefVec t2(m, p + 3 * n);   // temp
+
+        // r = Atb;
+        Multiply(b, A, r);
+        // r -= At A * x;
+        ApplyAtA(A, x, t, t2);
+        Subtract(r, t, r);
+
+        TElt rSqrLen = sqrlen(r);
+
+        int i = 0;
+
+        if (rSqrLen > epsilon)  // If we haven't already converged...
+        {
+            d = r;
+
+            int iMax;
+            if (steps)
+                iMax = *steps;
+            else
+                iMax = kMaxSolveSteps;
+
+            while (i < iMax)
+            {
+                i++;
+                // t = AtA * d;
+                ApplyAtA(A, d, t, t2);
+                TElt u = dot(d, t);
+
+                if (u == 0.0)
+                {
+                    VL_WARNING("(SolveConjGrad) d'Ad = 0");
+                    break;
+                }
+
+                TElt alpha = rSqrLen / u;  // How far should we go?
+                // x += alpha * d;         // Take a step along direction d
+                // r -= alpha * t;
+                MultiplyAccum(d,  alpha, x);
+                MultiplyAccum(t, -alpha, r);
+
+                TElt rSqrLenOld = rSqrLen;
+                rSqrLen = sqrlen(r);
+
+                if (rSqrLen <= epsilon)
+                    break;                  // Converged! Let's get out of here
+
+                TElt beta = rSqrLen / rSqrLenOld;
+                // d = r + beta * d;        //  Change direction
+                Multiply(d, beta, d);
+                Add(d, r, d);
+            }
+        }
+
+        if (steps)
+            *steps = i;
+
+        return rSqrLen;
+    }
+
+#ifndef VL_MIXED
+    /**
+        Preconditioned conjugate gradient. The iteration is as for ConjGrad,
+        but with search directions built from z = M^-1 r rather than r,
+        which, for a good M, clusters the eigenvalues of the system and cuts
+        the number of iterations needed.
+
+        Returns squared length of the (unpreconditioned) residual vector.
+
+        [Saad, "Iterative Methods for Sparse Linear Systems", 2003, p. 277]
+    */
+
+    template<class T_MAT> TMElt PrecondConjGrad
+    (
+        const T_MAT&           A,
+        TRefVec                x,
+        TConstRefVec           b,
+        const TPreconditioner& M,
+        TElt                   epsilon,
+        int*                   steps,
+        TElt*                  scratch
+    )
     {
-        TVec d(r);
+        VL_ASSERT_MSG(is_square(A), "(SolveConjGrad) Matrix not square");
+
+        const int n = A.Rows();
+        TVec  local;
+        TElt* p = ScratchSpace(scratch, local, kPrecondConjGradVecs * n);
+
+        TRefVec r(n, p);            // Residual vector, b - Ax
+        TRefVec z(n, p + n);        // Preconditioned residual, M^-1 r
+        TRefVec t(n, p + 2 * n);    // temp
+        TRefVec d(n, p + 3 * n);
+
+        // r = b - A * x;
+        Multiply(A, x, t);
+        Subtract(b, t, r);
+
+        TElt rSqrLen = sqrlen(r);
+        int i = 0;
+
+        if (rSqrLen > epsilon)
+        {
+            M.Apply(r, z);
+
+            d = z;
+            TElt rz = dot(r, z);
+
+            int iMax;
+            if (steps)
+                iMax = *steps;
+            else
+                iMax = kMaxSolveSteps;
+
+            while (i < iMax)
+            {
+                i++;
+                // t = A * d;
+                Multiply(A, d, t);
+                TElt u = dot(d, t);
+
+                if (u <= TElt(0))
+                {
+                    VL_WARNING("(SolveConjGrad) d'Ad <= 0");
+                    break;
+                }
+
+                TElt alpha = rz / u;
+                // x += alpha * d;
+                MultiplyAccum(d, alpha, x);
+
+                if (i & 0x3F)
+                    // r -= alpha * t;
+                    MultiplyAccum(t, -alpha, r);
+                else
+                {
+                    // For stability, correct r every 64th iteration
+                    Multiply(A, x, t);
+                    Subtract(b, t, r);
+                }
+
+                rSqrLen = sqrlen(r);
+
+                if (rSqrLen <= epsilon)
+                    break;
+
+                M.Apply(r, z);
+
+                TElt rzOld = rz;
+                rz = dot(r, z);
+
+                TElt beta = rz / rzOld;
+                // d = z + beta * d;
+                d *= beta;
+                d += z;
+            }
+        }
+
+        if (steps)
+            *steps = i;
+
+        return rSqrLen;
+    }
+
+    /**
+        Solve Ax = b by the stabilised bi-conjugate gradient method, for
+        general square A.
+
+        Returns squared length of residual vector.
+
+        [van der Vorst, "Bi-CGSTAB: A Fast and Smoothly Converging Variant
+        of Bi-CG for the Solution of Nonsymmetric Linear Systems", 1992]
+    */
+
+    template<class T_MAT> TMElt BiCGStab
+    (
+        const T_MAT& A,
+        TRefVec      x,
+        TConstRefVec b,
+        TElt         epsilon,
+        int*         steps,
+        TElt*        scratch
+    )
+    {
+        VL_ASSERT_MSG(is_square(A), "(SolveBiCGStab) Matrix not square");
+
+        const int n = A.Rows();
+        TVec  local;
+        TElt* sp = ScratchSpace(scratch, local, kBiCGStabVecs * n);
+
+        TRefVec r (n, sp);          // Residual vector, b - Ax
+        TRefVec t (n, sp + n);      // temp
+        TRefVec r0(n, sp + 2 * n);  // Shadow residual
+        TRefVec p (n, sp + 3 * n);
+        TRefVec v (n, sp + 4 * n);
+        TRefVec s (n, sp + 5 * n);
+
+        // r = b - A * x;
+        Multiply(A, x, t);
+        Subtract(b, t, r);
+
+        TElt rSqrLen = sqrlen(r);
+        int i = 0;
+
+        if (rSqrLen > epsilon)
+        {
+            r0 = r;
+            p.MakeZero();
+            v.MakeZero();
+
+            TElt rho   = TElt(1);
+            TElt alpha = TElt(1);
+            TElt omega = TElt(1);
+
+            int iMax;
+            if (steps)
+                iMax = *steps;
+            else
+                iMax = kMaxSolveSteps;
+
+            while (i < iMax)
+            {
+                i++;
+
+                TElt rhoOld = rho;
+                rho = dot(r0, r);
+
+                if (rho == TElt(0))
+                {
+                    VL_WARNING("(SolveBiCGStab) breakdown, r0'r = 0");
+                    break;
+                }
+
+                // p = r + beta * (p - omega * v);
+                TElt beta = (rho / rhoOld) * (alpha / omega);
+                MultiplyAccum(v, -omega, p);
+                p *= beta;
+                p += r;
+
+                // v = A * p;
+                Multiply(A, p, v);
+                TElt r0v = dot(r0, v);
+
+                if (r0v == TElt(0))
+                {
+                    VL_WARNING("(SolveBiCGStab) breakdown, r0'v = 0");
+                    break;
+                }
+
+                alpha = rho / r0v;
+
+                // s = r - alpha * v;
+                s = r;
+                MultiplyAccum(v, -alpha, s);
+
+                // x += alpha * p;
+                MultiplyAccum(p, alpha, x);
+
+                rSqrLen = sqrlen(s);
+
+                if (rSqrLen <= epsilon)
+                {
+                    r = s;
+                    break;
+                }
+
+                // t = A * s;
+                Multiply(A, s, t);
+                TElt tt = sqrlen(t);
+
+                if (tt == TElt(0))
+                {
+                    VL_WARNING("(SolveBiCGStab) breakdown, t't = 0");
+                    break;
+                }
+
+                omega = dot(t, s) / tt;
+
+                // x += omega * s;
+                // r = s - omega * t;
+                MultiplyAccum(s, omega, x);
+                r = s;
+                MultiplyAccum(t, -omega, r);
+
+                rSqrLen = sqrlen(r);
+
+                if (rSqrLen <= epsilon)
+                    break;
+
+                if (omega == TElt(0))
+                {
+                    VL_WARNING("(SolveBiCGStab) breakdown, omega = 0");
+                    break;
+                }
+            }
+        }
+
+        if (steps)
+            *steps = i;
+
+        return rSqrLen;
+    }
+
+    /**
+        Solve Ax = b by the restarted generalised minimal residual method,
+        GMRES(m), for general square A.
+
+        Each cycle builds an orthonormal basis for the Krylov space
+        {r, Ar, A^2r, ...} of up to m vectors, via Arnoldi iteration with
+        modified Gram-Schmidt, and picks the x in that space minimising
+        |Ax - b|. The small least squares problem is kept in triangular form
+        with Givens rotations, so the residual is known at every step
+        without forming x.
+
+        Returns squared length of residual vector.
+
+        [Saad and Schultz, "GMRES: A Generalized Minimal Residual Algorithm
+        for Solving Nonsymmetric Linear Systems", 1986]
+    */
+
+    template<class T_MAT> TMElt GMRES
+    (
+        const T_MAT& A,
+        TRefVec      x,
+        TConstRefVec b,
+        TElt         epsilon,
+        int*         steps,
+        int          m,
+        TElt*        scratch    // GMRESScratch() elements, or 0
+    )
+    {
+        VL_ASSERT_MSG(is_square(A), "(SolveGMRES) Matrix not square");
+        VL_ASSERT_MSG(m > 0, "(SolveGMRES) restart must be positive");
+
+        const int n = A.Rows();
+        TVec  local;
+        TElt* p = ScratchSpace(scratch, local, GMRESScratch(n, m));
+
+        m = vl_max(vl_min(m, n), 1);
+
+        TRefVec r(n, p);                // Residual vector, b - Ax
+        p += n;
+        TRefMat V(m + 1, n, p);         // Krylov basis, one vector per row
+        p += (m + 1) * n;
+        TRefMat H(m + 1, m, p);         // Hessenberg matrix, reduced to triangular
+        p += (m + 1) * m;
+        TRefVec cs(m, p), sn(m, p + m); // Givens rotations
+        TRefVec g(m + 1, p + 2 * m);    // Rotated residual
+        TRefVec y(m, p + 3 * m + 1);
 
         int iMax;
         if (steps)
@@ -131,122 +626,580 @@ TMElt SolveConjGrad
         else
             iMax = kMaxSolveSteps;
 
-        while (i < iMax)
+        int  i = 0;
+        TElt rSqrLen;
+
+        while (true)
         {
-            i++;
-            // t = A * d;
-            Multiply(A, d, t);
-            TElt u = dot(d, t);
+            // r = b - A * x;
+            Multiply(A, x, r);
+            Subtract(b, r, r);
 
-            if (len(u) < TElt(1e-12))
-            {
-                VL_WARNING("(SolveConjGrad) d'Ad = 0");
+            rSqrLen = sqrlen(r);
+
+            if (rSqrLen <= epsilon || i >= iMax)
                 break;
-            }
 
-            TElt alpha = rSqrLen / u;  // How far should we go?
-            // x += alpha * d;         // Take a step along direction d
-            MultiplyAccum(d,  alpha, x);
+            TElt beta = sqrt(rSqrLen);
 
-            if (i & 0x3F)
-                // r -= alpha * t;
-                MultiplyAccum(t, -alpha, r);
-            else
+            Multiply(r, TElt(1) / beta, V[0]);
+            g.MakeZero();
+            g[0] = beta;
+
+            int k = 0;
+
+            while (k < m && i < iMax)
             {
-                // For stability, correct r every 64th iteration
-                // r = b - A * x;
-                Multiply(A, x, t);
-                Subtract(b, t, r);
+                i++;
+
+                // w = A v_k, orthogonalised against v_0 .. v_k
+                TRefVec w(V[k + 1]);
+                Multiply(A, V[k], w);
+
+                for (int j = 0; j <= k; j++)
+                {
+                    H(j, k) = dot(w, V[j]);
+                    MultiplyAccum(V[j], -H(j, k), w);
+                }
+
+                TElt hNext = len(w);
+
+                if (hNext != TElt(0))
+                    w /= hNext;
+
+                // Apply previous rotations to the new column, then zero
+                // its subdiagonal element with a new one.
+                for (int j = 0; j < k; j++)
+                {
+                    TElt h0 = H(j, k);
+                    TElt h1 = H(j + 1, k);
+
+                    H(j,     k) =  cs[j] * h0 + sn[j] * h1;
+                    H(j + 1, k) = -sn[j] * h0 + cs[j] * h1;
+                }
+
+                TElt hkk = H(k, k);
+                TElt d = sqrt(sqr(hkk) + sqr(hNext));
+
+                if (d == TElt(0))
+                {
+                    cs[k] = TElt(1);
+                    sn[k] = TElt(0);
+                }
+                else
+                {
+                    cs[k] = hkk / d;
+                    sn[k] = hNext / d;
+                }
+
+                H(k, k) = d;
+                g[k + 1] = -sn[k] * g[k];
+                g[k]     =  cs[k] * g[k];
+
+                k++;
+
+                rSqrLen = sqr(g[k]);
+
+                if (rSqrLen <= epsilon || hNext == TElt(0))
+                    break;  // converged, or the Krylov space is exhausted
             }
 
-            TElt rSqrLenOld = rSqrLen;
-            rSqrLen = sqrlen(r);
+            // Solve H y = g, and update x with the basis vectors
+            for (int j = k - 1; j >= 0; j--)
+            {
+                TElt s = g[j];
+
+                for (int l = j + 1; l < k; l++)
+                    s -= H(j, l) * y[l];
 
-            if (rSqrLen <= epsilon)
-                break;                  // Converged! Let's get out of here
+                if (H(j, j) == TElt(0))
+                {
+                    VL_WARNING("(SolveGMRES) singular Hessenberg matrix");
+                    y[j] = TElt(0);
+                }
+                else
+                    y[j] = s / H(j, j);
+            }
 
-            TElt beta = rSqrLen / rSqrLenOld;
-            // d = r + beta * d;        //  Change direction
-            d *= beta;
-            d += r;
+            for (int j = 0; j < k; j++)
+                MultiplyAccum(V[j], y[j], x);
         }
+
+        if (steps)
+            *steps = i;
+
+        return rSqrLen;
     }
+#endif
+}
+
+
+// --- Public entry points ----------------------------------------------------
+
+TMElt SolveOverRelax(TConstRefMat A, TRefVec x, TConstRefVec b, TMElt epsilon, TMElt omega, int* steps)
+{
+    return OverRelax(A, x, b, epsilon, omega, steps);
+}
+
+TMElt SolveConjGrad(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps)
+{
+    return ConjGrad(A, x, b, epsilon, steps, 0);
+}
+
+TMElt SolveConjGrad_AtA(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps)
+{
+    return ConjGrad_AtA(A, x, b, epsilon, steps, 0);
+}
+
+#ifndef VL_MIXED
+TMElt SolveOverRelax(const TSparseMat& A, TRefVec x, TConstRefVec b, TMElt epsilon, TMElt omega, int* steps)
+{
+    return OverRelax(A, x, b, epsilon, omega, steps);
+}
+
+TMElt SolveConjGrad(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return ConjGrad(A, x, b, epsilon, steps, workspace ? workspace->Reserve(kConjGradVecs * A.Rows()) : 0);
+}
+
+TMElt SolveConjGrad(const TSparseMat& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return ConjGrad(A, x, b, epsilon, steps, workspace ? workspace->Reserve(kConjGradVecs * A.Rows()) : 0);
+}
+
+TMElt SolveConjGrad(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return ConjGrad(A, x, b, epsilon, steps, workspace ? workspace->Reserve(kConjGradVecs * A.Rows()) : 0);
+}
 
-    if (steps)
-        *steps = i;
+TMElt SolveConjGrad_AtA(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return ConjGrad_AtA(A, x, b, epsilon, steps, workspace ? workspace->Reserve(ConjGradAtAScratch(A)) : 0);
+}
 
-    return rSqrLen;
+TMElt SolveConjGrad_AtA(const TSparseMat& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return ConjGrad_AtA(A, x, b, epsilon, steps, workspace ? workspace->Reserve(ConjGradAtAScratch(A)) : 0);
 }
 
-TMElt SolveConjGrad_AtA
-(
-    TConstRefMat A,         // Solve AtA x = At b.
-    TRefVec      x,
-    TConstRefVec b,
-    TElt         epsilon,   // how low should we go?
-    int*         steps      // iterations to converge.
-)
+TMElt SolveConjGrad_AtA(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
 {
-    TVec r (A.Cols());      // Residual vector, Atb - AtAx
-    TVec t (A.Cols());      // temp
-    TVec t2(A.Rows());      // temp
+    return ConjGrad_AtA(A, x, b, epsilon, steps, workspace ? workspace->Reserve(ConjGradAtAScratch(A)) : 0);
+}
 
-    // r = Atb;
-    Multiply(b, A, r);
-    // r -= At A * x;
-    Multiply(A, x, t2);
-    Multiply(t2, A, t);     // tmp_t A = trans(A_t tmp)
-    Subtract(r, t, r);
+TMElt SolveConjGrad(TConstRefMat A, TRefVec x, TConstRefVec b, const TPreconditioner& M, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return PrecondConjGrad(A, x, b, M, epsilon, steps, workspace ? workspace->Reserve(kPrecondConjGradVecs * A.Rows()) : 0);
+}
 
-    TElt rSqrLen = sqrlen(r);
+TMElt SolveConjGrad(const TSparseMat& A, TRefVec x, TConstRefVec b, const TPreconditioner& M, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return PrecondConjGrad(A, x, b, M, epsilon, steps, workspace ? workspace->Reserve(kPrecondConjGradVecs * A.Rows()) : 0);
+}
+
+TMElt SolveConjGrad(const TLinearOperator& A, TRefVec x, TConstRefVec b, const TPreconditioner& M, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return PrecondConjGrad(A, x, b, M, epsilon, steps, workspace ? workspace->Reserve(kPrecondConjGradVecs * A.Rows()) : 0);
+}
 
-    int i = 0;
+TMElt SolveBiCGStab(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return BiCGStab(A, x, b, epsilon, steps, workspace ? workspace->Reserve(kBiCGStabVecs * A.Rows()) : 0);
+}
+
+TMElt SolveBiCGStab(const TSparseMat& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return BiCGStab(A, x, b, epsilon, steps, workspace ? workspace->Reserve(kBiCGStabVecs * A.Rows()) : 0);
+}
+
+TMElt SolveBiCGStab(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, TSolveWorkspace* workspace)
+{
+    return BiCGStab(A, x, b, epsilon, steps, workspace ? workspace->Reserve(kBiCGStabVecs * A.Rows()) : 0);
+}
+
+TMElt SolveGMRES(TConstRefMat A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, int restart, TSolveWorkspace* workspace)
+{
+    return GMRES(A, x, b, epsilon, steps, restart, workspace ? workspace->Reserve(GMRESScratch(A.Rows(), restart)) : 0);
+}
+
+TMElt SolveGMRES(const TSparseMat& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, int restart, TSolveWorkspace* workspace)
+{
+    return GMRES(A, x, b, epsilon, steps, restart, workspace ? workspace->Reserve(GMRESScratch(A.Rows(), restart)) : 0);
+}
+
+TMElt SolveGMRES(const TLinearOperator& A, TRefVec x, TConstRefVec b, TElt epsilon, int* steps, int restart, TSolveWorkspace* workspace)
+{
+    return GMRES(A, x, b, epsilon, steps, restart, workspace ? workspace->Reserve(GMRESScratch(A.Rows(), restart)) : 0);
+}
+
+
+// --- SolveWorkspace ---------------------------------------------------------
+
+TSolveWorkspace::TSolveWorkspace()
+{
+}
+
+TSolveWorkspace::TSolveWorkspace(int n, int restart)
+{
+    Reserve(vl_max(kBiCGStabVecs * n, GMRESScratch(n, restart)));
+}
+
+TElt* TSolveWorkspace::Reserve(int elts)
+{
+    if (storage.Elts() < elts)
+        storage.SetSize(elts);
 
-    if (rSqrLen > epsilon)  // If we haven't already converged...
+    return storage.data;
+}
+
+int TSolveWorkspace::Elts() const
+{
+    return storage.Elts();
+}
+#endif
+
+
+#ifndef VL_MIXED
+// --- Preconditioners --------------------------------------------------------
+
+TPreconditioner::~TPreconditioner()
+{
+}
+
+// Jacobi
+
+TJacobiPreconditioner::TJacobiPreconditioner(TConstRefMat A) :
+    invDiag(A.Rows())
+{
+    VL_ASSERT_MSG(is_square(A), "(JacobiPreconditioner) Matrix not square");
+
+    for (int i = 0; i < A.Rows(); i++)
+        invDiag[i] = A(i, i) != TElt(0) ? TElt(1) / A(i, i) : TElt(1);
+}
+
+TJacobiPreconditioner::TJacobiPreconditioner(const TSparseMat& A) :
+    invDiag(A.Rows())
+{
+    VL_ASSERT_MSG(is_square(A), "(JacobiPreconditioner) Matrix not square");
+
+    for (int i = 0; i < A.Rows(); i++)
+        invDiag[i] = A(i, i) != TElt(0) ? TElt(1) / A(i, i) : TElt(1);
+}
+
+void TJacobiPreconditioner::Apply(TConstRefVec r, TRefVec z) const
+{
+    Multiply(r, invDiag, z);
+}
+
+// Block Jacobi
+
+TBlockJacobiPreconditioner::TBlockJacobiPreconditioner(TConstRefMat A, int bs) :
+    blockSize(bs)
+{
+    Init(TSparseMat(A));
+}
+
+TBlockJacobiPreconditioner::TBlockJacobiPreconditioner(const TSparseMat& A, int bs) :
+    blockSize(bs)
+{
+    Init(A);
+}
+
+void TBlockJacobiPreconditioner::Init(const TSparseMat& A)
+{
+    VL_ASSERT_MSG(is_square(A), "(BlockJacobiPreconditioner) Matrix not square");
+    VL_ASSERT_MSG(blockSize > 0, "(BlockJacobiPreconditioner) Bad block size");
+
+    const int n = A.Rows();
+
+    invBlocks.SetSize(n, blockSize);
+    invBlocks = vl_0;
+
+    for (int i0 = 0; i0 < n; i0 += blockSize)
     {
-        TVec d(r);
+        int  nb = vl_min(blockSize, n - i0);
+        TMat block(nb, nb, vl_0);
 
-        int iMax;
-        if (steps)
-            iMax = *steps;
+        for (int i = 0; i < nb; i++)
+        {
+            const int*  indices = A.RowIndices(i0 + i);
+            const TElt* elts    = A.RowData(i0 + i);
+
+            for (int k = 0, kEnd = A.RowElts(i0 + i); k < kEnd; k++)
+                if (indices[k] >= i0 && indices[k] < i0 + nb)
+                    block(i, indices[k] - i0) = elts[k];
+        }
+
+        TMat result(nb, nb);
+
+        if (Invert(block, result))
+            for (int i = 0; i < nb; i++)
+                for (int j = 0; j < nb; j++)
+                    invBlocks(i0 + i, j) = result(i, j);
         else
-            iMax = kMaxSolveSteps;
+        {
+            VL_WARNING("(BlockJacobiPreconditioner) singular block, using its diagonal");
+
+            for (int i = 0; i < nb; i++)
+                invBlocks(i0 + i, i) = block(i, i) != TElt(0) ? TElt(1) / block(i, i) : TElt(1);
+        }
+    }
+}
 
-        while (i < iMax)
+void TBlockJacobiPreconditioner::Apply(TConstRefVec r, TRefVec z) const
+{
+    const int n = r.Elts();
+
+    for (int i0 = 0; i0 < n; i0 += blockSize)
+    {
+        int nb = vl_min(blockSize, n - i0);
+
+        for (int i = 0; i < nb; i++)
         {
-            i++;
-            // t = AtA * d;
-            Multiply(A, d, t2);
-            Multiply(t2, A, t);
-            TElt u = dot(d, t);
+            const TElt* row = invBlocks.data + (i0 + i) * blockSize;
+            TElt s = TElt(vl_zero);
+
+            for (int j = 0; j < nb; j++)
+                s += row[j] * r[i0 + j];
+
+            z[i0 + i] = s;
+        }
+    }
+}
+
+// SSOR
+
+TSSORPreconditioner::TSSORPreconditioner(TConstRefMat A, TElt w) :
+    m(A),
+    omega(w)
+{
+    Init();
+}
+
+TSSORPreconditioner::TSSORPreconditioner(const TSparseMat& A, TElt w) :
+    m(A),
+    omega(w)
+{
+    Init();
+}
+
+void TSSORPreconditioner::Init()
+{
+    VL_ASSERT_MSG(is_square(m), "(SSORPreconditioner) Matrix not square");
+    VL_ASSERT_MSG(omega > TElt(0) && omega < TElt(2), "(SSORPreconditioner) omega must be in (0, 2)");
+
+    diag.SetSize(m.Rows());
+
+    for (int i = 0; i < m.Rows(); i++)
+    {
+        diag[i] = m(i, i) / omega;
+
+        if (diag[i] == TElt(0))
+        {
+            VL_WARNING("(SSORPreconditioner) diagonal element = 0");
+            diag[i] = TElt(1);
+        }
+    }
+}
+
+void TSSORPreconditioner::Apply(TConstRefVec r, TRefVec z) const
+{
+    const int n = m.Rows();
+
+    // (D/w + L) y = r
+    for (int i = 0; i < n; i++)
+    {
+        const int*  indices = m.RowIndices(i);
+        const TElt* elts    = m.RowData(i);
+        TElt        s       = r[i];
+
+        for (int k = 0, kEnd = m.RowElts(i); k < kEnd && indices[k] < i; k++)
+            s -= elts[k] * z[indices[k]];
+
+        z[i] = s / diag[i];
+    }
+
+    // y = (D/w) y
+    Multiply(z, diag, z);
+
+    // (D/w + U) z = y
+    for (int i = n - 1; i >= 0; i--)
+    {
+        const int*  indices = m.RowIndices(i);
+        const TElt* elts    = m.RowData(i);
+        TElt        s       = z[i];
+
+        for (int k = m.RowElts(i) - 1; k >= 0 && indices[k] > i; k--)
+            s -= elts[k] * z[indices[k]];
+
+        z[i] = s / diag[i];
+    }
+
+    z *= (TElt(2) - omega) / omega;
+}
+
+// Incomplete Cholesky
+
+/*
+    NOTE
+
+    IC(0) computes L row by row, over the sparsity pattern of A's lower
+    triangle only:
+
+        L_ik = (a_ik - sum_j<k L_ij L_kj) / L_kk,    k < i
+        L_ii = sqrt(a_ii - sum_j<i L_ij^2)
+
+    where each sum is a merge of two sorted rows of L. Dropping fill-in
+    can make a pivot non-positive even for SPD A. When that happens we
+    fall back to the original diagonal element for that row, which keeps
+    M positive definite at some cost in effectiveness.
+*/
+
+TIC0Preconditioner::TIC0Preconditioner(TConstRefMat A)
+{
+    Init(TSparseMat(A));
+}
+
+TIC0Preconditioner::TIC0Preconditioner(const TSparseMat& A)
+{
+    Init(A);
+}
+
+void TIC0Preconditioner::Init(const TSparseMat& A)
+{
+    VL_ASSERT_MSG(is_square(A), "(IC0Preconditioner) Matrix not square");
+
+    const int n = A.Rows();
+
+    // Copy out the lower triangle, making sure every row has a diagonal
+    L.SetSize(n, n);
+
+    for (int i = 0; i < n; i++)
+    {
+        const int*  indices = A.RowIndices(i);
+        const TElt* elts    = A.RowData(i);
+        TElt        aii     = TElt(vl_zero);
 
-            if (u == 0.0)
+        for (int k = 0, kEnd = A.RowElts(i); k < kEnd && indices[k] <= i; k++)
+            if (indices[k] < i)
             {
-                VL_WARNING("(SolveConjGrad) d'Ad = 0");
-                break;
+                L.colIndices.push_back(indices[k]);
+                L.elts.push_back(elts[k]);
             }
+            else
+                aii = elts[k];
 
-            TElt alpha = rSqrLen / u;  // How far should we go?
-            // x += alpha * d;         // Take a step along direction d
-            // r -= alpha * t;
-            MultiplyAccum(d,  alpha, x);
-            MultiplyAccum(t, -alpha, r);
+        L.colIndices.push_back(i);
+        L.elts.push_back(aii);
+        L.rowStarts[i + 1] = int(L.elts.size());
+    }
 
-            TElt rSqrLenOld = rSqrLen;
-            rSqrLen = sqrlen(r);
+    TElt* l = L.elts.data();
+    const int* cols = L.colIndices.data();
+    const int* starts = L.rowStarts.data();
 
-            if (rSqrLen <= epsilon)
-                break;                  // Converged! Let's get out of here
+    for (int i = 0; i < n; i++)
+    {
+        int iBegin = starts[i];
+        int iDiag  = starts[i + 1] - 1;
 
-            TElt beta = rSqrLen / rSqrLenOld;
-            // d = r + beta * d;        //  Change direction
-            Multiply(d, beta, d);
-            Add(d, r, d);
+        for (int p = iBegin; p <= iDiag; p++)
+        {
+            int k = cols[p];
+
+            // s = sum_j<k L_ij L_kj
+            TElt s = TElt(vl_zero);
+            int  q = starts[k];
+            int  kDiag = starts[k + 1] - 1;
+
+            for (int pi = iBegin; pi < p && q < kDiag; )
+                if (cols[pi] < cols[q])
+                    pi++;
+                else if (cols[pi] > cols[q])
+                    q++;
+                else
+                    s += l[pi++] * l[q++];
+
+            if (k < i)
+                l[p] = (l[p] - s) / l[kDiag];
+            else
+            {
+                TElt d = l[p] - s;
+
+                if (d <= TElt(0))
+                {
+                    VL_WARNING("(IC0Preconditioner) non-positive pivot, using diagonal");
+                    d = abs(l[p]) > TElt(0) ? abs(l[p]) : TElt(1);
+                }
+
+                l[p] = sqrt(d);
+            }
         }
     }
+}
+
+void TIC0Preconditioner::Apply(TConstRefVec r, TRefVec z) const
+{
+    const int   n      = L.Rows();
+    const TElt* l      = L.elts.data();
+    const int*  cols   = L.colIndices.data();
+    const int*  starts = L.rowStarts.data();
+
+    // L y = r
+    for (int i = 0; i < n; i++)
+    {
+        TElt s = r[i];
+        int  iDiag = starts[i + 1] - 1;
+
+        for (int p = starts[i]; p < iDiag; p++)
+            s -= l[p] * z[cols[p]];
+
+        z[i] = s / l[iDiag];
+    }
 
-    if (steps)
-        *steps = i;
+    // Lt z = y, working through L's columns via its rows
+    for (int i = n - 1; i >= 0; i--)
+    {
+        int  iDiag = starts[i + 1] - 1;
+        TElt zi = (z[i] /= l[iDiag]);
+
+        for (int p = starts[i]; p < iDiag; p++)
+            z[cols[p]] -= l[p] * zi;
+    }
+}
+#endif
+
+
+#ifndef VL_MIXED
+// --- Linear operators -------------------------------------------------------
+
+TLinearOperator::~TLinearOperator()
+{
+}
+
+void TLinearOperator::ApplyTranspose(TConstRefVec, TRefVec) const
+{
+    VL_ERROR("(LinearOperator::ApplyTranspose) not implemented for this operator");
+}
+
+bool is_square(const TLinearOperator& A)
+{
+    return A.Rows() == A.Cols();
+}
+
+void Multiply(const TLinearOperator& A, TConstRefVec x, TRefVec y)
+{
+    VL_ASSERT_MSG(x.Elts() == A.Cols(), "(LinearOperator::*v) Operator/Vector dimensions don't match");
+    VL_ASSERT_MSG(y.Elts() == A.Rows(), "(LinearOperator::*v) Operator/Vector dimensions don't match");
+
+    A.Apply(x, y);
+}
+
+void Multiply(TConstRefVec x, const TLinearOperator& A, TRefVec y)
+{
+    VL_ASSERT_MSG(x.Elts() == A.Rows(), "(LinearOperator::v*) Vector/Operator dimensions don't match");
+    VL_ASSERT_MSG(y.Elts() == A.Cols(), "(LinearOperator::v*) Vector/Operator dimensions don't match");
 
-    return rSqrLen;
+    A.ApplyTranspose(x, y);
 }
+#endif
@@ -0,0 +1,287 @@
+/*
+    File:       SparseMat.cpp
+
+    Function:   Implements SparseMat.hpp
+
+    Copyright:  Andrew Willmott
+*/
+
+#include "VL/SparseMat.hpp"
+#include "Threads.cpp"
+
+VL_NS_END
+#include <algorithm>
+VL_NS_BEGIN
+
+/*
+    NOTE
+
+    Both building from triplets and transposing are done with counting
+    sorts rather than comparison sorts: the entries are first bucketed by
+    column, and then, stably, by row, which leaves each row's entries in
+    column order. This is O(non-zeros + rows + cols), which matters for
+    systems with millions of unknowns.
+
+    m v is a gather over each row, so it splits across threads by rows.
+    v m is a scatter into the result, and so is serial. If it's needed
+    in an inner loop on a large matrix, it's faster to form trans(m) once,
+    and use that.
+*/
+
+namespace
+{
+    void BucketEntries
+    (
+        int n, int count, const int* keys, const int* others, const TElt* values,
+        int* starts, int* othersOut, TElt* valuesOut, int* keysOut = 0
+    )
+    // Stable counting sort of 'count' entries by key, where 0 <= key < n.
+    // Sets up starts[0 .. n] as the start of each key's run.
+    {
+        for (int i = 0; i <= n; i++)
+            starts[i] = 0;
+
+        for (int k = 0; k < count; k++)
+        {
+            VL_RANGE_MSG(keys[k], 0, n, "(SparseMat) index out of range");
+            starts[keys[k] + 1]++;
+        }
+
+        for (int i = 0; i < n; i++)
+            starts[i + 1] += starts[i];
+
+        std::vector<int> next(starts, starts + n);
+
+        for (int k = 0; k < count; k++)
+        {
+            int p = next[keys[k]]++;
+
+            othersOut[p] = others[k];
+            valuesOut[p] = values[k];
+
+            if (keysOut)
+                keysOut[p] = keys[k];
+        }
+    }
+}
+
+
+// --- SparseMat Constructors -------------------------------------------------
+
+TSparseMat::TSparseMat() : cols(0), rows(0)
+{
+    rowStarts.assign(1, 0);
+}
+
+TSparseMat::TSparseMat(int r, int c)
+{
+    SetSize(r, c);
+}
+
+TSparseMat::TSparseMat(TConstRefMat m, TElt eps) : cols(m.cols), rows(m.rows)
+{
+    rowStarts.resize(rows + 1);
+    rowStarts[0] = 0;
+
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+            if (abs(m(i, j)) > eps)
+            {
+                colIndices.push_back(j);
+                elts.push_back(m(i, j));
+            }
+
+        rowStarts[i + 1] = int(elts.size());
+    }
+}
+
+
+// --- SparseMat Methods ------------------------------------------------------
+
+TElt TSparseMat::operator () (int i, int j) const
+{
+    VL_RANGE_MSG(i, 0, rows, "(SparseMat::()) illegal row index");
+    VL_RANGE_MSG(j, 0, cols, "(SparseMat::()) illegal column index");
+
+    const int* begin = colIndices.data() + rowStarts[i];
+    const int* end   = colIndices.data() + rowStarts[i + 1];
+    const int* p     = std::lower_bound(begin, end, j);
+
+    if (p != end && *p == j)
+        return elts[p - colIndices.data()];
+
+    return TElt(vl_zero);
+}
+
+void TSparseMat::SetSize(int r, int c)
+{
+    VL_ASSERT_MSG(r >= 0 && c >= 0, "(SparseMat::SetSize) illegal matrix size");
+
+    rows = r;
+    cols = c;
+
+    rowStarts.assign(rows + 1, 0);
+    colIndices.clear();
+    elts.clear();
+}
+
+void TSparseMat::SetFromTriplets
+(
+    int r, int c,
+    int count, const int* rowIndices, const int* colIndicesIn, const TElt* values
+)
+{
+    SetSize(r, c);
+
+    if (count == 0)
+        return;
+
+    // Sort by column, then stably by row
+    std::vector<int>  colStarts(cols + 1);
+    std::vector<int>  byColRows(count);
+    std::vector<int>  byColCols(count);
+    std::vector<TElt> byColValues(count);
+
+    BucketEntries(cols, count, colIndicesIn, rowIndices, values, colStarts.data(), byColRows.data(), byColValues.data(), byColCols.data());
+
+    colIndices.resize(count);
+    elts.resize(count);
+
+    BucketEntries(rows, count, byColRows.data(), byColCols.data(), byColValues.data(), rowStarts.data(), colIndices.data(), elts.data());
+
+    // Merge duplicates
+    int w = 0;
+
+    for (int i = 0; i < rows; i++)
+    {
+        int rowBegin = w;
+        int kEnd = rowStarts[i + 1];
+
+        for (int k = rowStarts[i]; k < kEnd; k++)
+            if (w > rowBegin && colIndices[w - 1] == colIndices[k])
+                elts[w - 1] += elts[k];
+            else
+            {
+                colIndices[w] = colIndices[k];
+                elts[w] = elts[k];
+                w++;
+            }
+
+        rowStarts[i] = rowBegin;
+    }
+
+    rowStarts[rows] = w;
+    colIndices.resize(w);
+    elts.resize(w);
+}
+
+
+// --- SparseMat Arithmetic Operators -----------------------------------------
+
+TVec operator * (const TSparseMat& m, TConstRefVec v)
+{
+    TVec result(m.rows);
+    Multiply(m, v, result);
+    return result;
+}
+
+TVec operator * (TConstRefVec v, const TSparseMat& m)
+{
+    TVec result(m.cols);
+    Multiply(v, m, result);
+    return result;
+}
+
+
+// --- SparseMat Functions ----------------------------------------------------
+
+TSparseMat trans(const TSparseMat& m)
+{
+    TSparseMat result;
+    Transpose(m, result);
+    return result;
+}
+
+TMat dense(const TSparseMat& m)
+{
+    TMat result(m.rows, m.cols, vl_0);
+
+    for (int i = 0; i < m.rows; i++)
+        for (int k = m.rowStarts[i]; k < m.rowStarts[i + 1]; k++)
+            result(i, m.colIndices[k]) = m.elts[k];
+
+    return result;
+}
+
+void Multiply(const TSparseMat& m, TConstRefVec v, TRefVec r)
+{
+    VL_ASSERT_MSG(v.elts == m.cols, "(SparseMat::*v) Matrix/Vector dimensions don't match");
+    VL_ASSERT_MSG(r.elts == m.rows, "(SparseMat::*v) Matrix/Vector dimensions don't match");
+    VL_ASSERT_MSG(r.data != v.data, "(SparseMat::*v) result can't be the same as v");
+
+    const int*  starts  = m.rowStarts.data();
+    const int*  indices = m.colIndices.data();
+    const TElt* elts    = m.elts.data();
+    const TElt* vd      = v.data;
+    double      rowWork = m.rows > 0 ? double(m.NonZeros()) / m.rows : 0.0;
+
+    vl_parallel_for(kVLThreadMultiply, m.NonZeros(), m.rows, vl_grain(rowWork),
+        [&](int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                TElt s = TElt(vl_zero);
+
+                for (int k = starts[i], kEnd = starts[i + 1]; k < kEnd; k++)
+                    s += elts[k] * vd[indices[k]];
+
+                r.data[i] = s;
+            }
+        }
+    );
+}
+
+void Multiply(TConstRefVec v, const TSparseMat& m, TRefVec r)
+{
+    VL_ASSERT_MSG(v.elts == m.rows, "(SparseMat::v*) Vector/Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.elts == m.cols, "(SparseMat::v*) Vector/Matrix dimensions don't match");
+    VL_ASSERT_MSG(r.data != v.data, "(SparseMat::v*) result can't be the same as v");
+
+    const int*  indices = m.colIndices.data();
+    const TElt* elts    = m.elts.data();
+
+    r = vl_zero;
+
+    for (int i = 0; i < m.rows; i++)
+    {
+        TElt vi = v.data[i];
+
+        for (int k = m.rowStarts[i], kEnd = m.rowStarts[i + 1]; k < kEnd; k++)
+            r.data[indices[k]] += elts[k] * vi;
+    }
+}
+
+void Transpose(const TSparseMat& m, TSparseMat& r)
+{
+    VL_ASSERT_MSG(&m != &r, "(SparseMat::trans) can't transpose in place");
+
+    int count = m.NonZeros();
+
+    // Row index of each entry, which becomes the column index
+    std::vector<int> rowIndices(count);
+
+    for (int i = 0; i < m.rows; i++)
+        for (int k = m.rowStarts[i]; k < m.rowStarts[i + 1]; k++)
+            rowIndices[k] = i;
+
+    r.rows = m.cols;
+    r.cols = m.rows;
+    r.rowStarts.resize(r.rows + 1);
+    r.colIndices.resize(count);
+    r.elts.resize(count);
+
+    // m's entries are in row order, so bucketing by column leaves each of
+    // r's rows sorted.
+    BucketEntries(r.rows, count, m.colIndices.data(), rowIndices.data(), m.elts.data(), r.rowStarts.data(), r.colIndices.data(), r.elts.data());
+}
@@ -323,4 +323,15 @@ istream& operator >> (istream& s, TMat4& m)
     return s;
 }
 
+#ifdef VL_MAT34_H
+ostream& operator << (ostream& s, const TMat34& m)
+{
+    int w = (int) s.width();
+
+    return s << '[' <<            m[0] << endl
+             << ' ' << setw(w) << m[1] << endl
+             << ' ' << setw(w) << m[2] << ']' << endl;
+}
+#endif
+
 #endif
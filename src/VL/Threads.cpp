@@ -0,0 +1,348 @@
+/*
+    File:       Threads.cpp
+
+    Function:   Work-stealing thread pool used to split large operations
+                across threads. See Threads.hpp for the user controls.
+
+                Everything here is inline, so the single pool is shared by
+                all the library variants linked into a program.
+
+    Copyright:  Andrew Willmott
+*/
+
+#ifndef VL_THREADS_IMPL
+#define VL_THREADS_IMPL
+
+VL_NS_END
+#include <vector>
+#ifndef VL_NO_THREADS
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+#endif
+VL_NS_BEGIN
+
+/*
+    NOTE
+
+    A parallel loop over n items is cut into chunks of 'grain' items, and
+    the chunks are dealt out as one contiguous range per participating
+    thread. Each thread works through its own range from the front, a chunk
+    at a time. When it runs dry it steals the back half of the largest
+    remaining range of another thread, so uneven work (e.g., triangular
+    loops) still balances out without a shared queue becoming a bottleneck.
+
+    The calling thread always takes part, so with n threads the pool holds
+    n - 1 workers. Calls made from inside a parallel loop, or while another
+    thread is using the pool, just run serially.
+*/
+
+#ifndef VL_NO_THREADS
+
+struct VLWorkRange
+{
+    std::mutex lock;
+    int        begin = 0;
+    int        end = 0;
+    char       pad[64];     // keep ranges on separate cache lines
+};
+
+struct VLWorkJob
+{
+    void      (*fn)(const void* context, int begin, int end);
+    const void* context;
+    int         n;
+    int         grain;
+    int         numRanges;
+    VLWorkRange* ranges;
+};
+
+class VLThreadPool
+{
+public:
+    static VLThreadPool& Get()
+    {
+        static VLThreadPool sPool;
+        return sPool;
+    }
+
+    static bool& InPool()
+    {
+        static thread_local bool sInPool = false;
+        return sInPool;
+    }
+
+    bool Run(int threads, void (*fn)(const void*, int, int), const void* context, int n, int grain)
+    // Runs fn over [0, n) with the given number of threads. Returns false
+    // if the pool is busy, in which case the caller should run serially.
+    {
+        if (InPool())
+            return false;
+
+        std::unique_lock<std::mutex> busy(mBusy, std::try_to_lock);
+        if (!busy.owns_lock())
+            return false;
+
+        if (int(mWorkers.size()) != threads - 1)
+            StartWorkers(threads - 1);
+
+        int numChunks = (n + grain - 1) / grain;
+        int numRanges = vl_min(threads, numChunks);
+
+        VLWorkRange* ranges = mRanges.data();
+
+        for (int i = 0; i < threads; i++)
+        {
+            ranges[i].begin = i < numRanges ? int((long long) numChunks *  i      / numRanges) : 0;
+            ranges[i].end   = i < numRanges ? int((long long) numChunks * (i + 1) / numRanges) : 0;
+        }
+
+        VLWorkJob job = { fn, context, n, grain, threads, ranges };
+
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mJob = &job;
+            mPending = int(mWorkers.size());
+            mGeneration++;
+        }
+        mWake.notify_all();
+
+        InPool() = true;
+        Work(job, 0);
+        InPool() = false;
+
+        std::unique_lock<std::mutex> lock(mLock);
+        mDone.wait(lock, [this] { return mPending == 0; });
+        mJob = nullptr;
+
+        return true;
+    }
+
+    ~VLThreadPool()
+    {
+        StopWorkers();
+    }
+
+protected:
+    std::mutex                  mBusy;      // held by the thread running a job
+    std::mutex                  mLock;      // protects the fields below
+    std::condition_variable     mWake;
+    std::condition_variable     mDone;
+    VLWorkJob*                  mJob = nullptr;
+    int                         mPending = 0;
+    unsigned                    mGeneration = 0;
+    bool                        mStop = false;
+    std::vector<std::thread>    mWorkers;
+    std::vector<VLWorkRange>    mRanges;    // one per thread, reused across jobs
+
+    void StartWorkers(int count)
+    {
+        StopWorkers();
+
+        std::vector<VLWorkRange>(count + 1).swap(mRanges);
+
+        mStop = false;
+        for (int i = 0; i < count; i++)
+            mWorkers.push_back(std::thread(&VLThreadPool::WorkerLoop, this, i + 1, mGeneration));
+    }
+
+    void StopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStop = true;
+        }
+        mWake.notify_all();
+
+        for (std::thread& worker : mWorkers)
+            worker.join();
+
+        mWorkers.clear();
+    }
+
+    void WorkerLoop(int index, unsigned generation)
+    {
+        InPool() = true;
+
+        while (true)
+        {
+            VLWorkJob* job;
+            {
+                std::unique_lock<std::mutex> lock(mLock);
+                mWake.wait(lock, [&] { return mStop || mGeneration != generation; });
+
+                if (mStop)
+                    return;
+
+                generation = mGeneration;
+                job = mJob;
+            }
+
+            Work(*job, index);
+
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                if (--mPending == 0)
+                    mDone.notify_one();
+            }
+        }
+    }
+
+    static void Work(VLWorkJob& job, int self)
+    {
+        VLWorkRange& own = job.ranges[self];
+
+        while (true)
+        {
+            int chunk = -1;
+            {
+                std::lock_guard<std::mutex> lock(own.lock);
+                if (own.begin < own.end)
+                    chunk = own.begin++;
+            }
+
+            if (chunk < 0 && !Steal(job, self, &chunk))
+                return;
+
+            int begin = chunk * job.grain;
+            int end   = vl_min(begin + job.grain, job.n);
+
+            job.fn(job.context, begin, end);
+        }
+    }
+
+    static bool Steal(VLWorkJob& job, int self, int* chunk)
+    // Moves the back half of the fullest other range into our own, and
+    // returns its first chunk.
+    {
+        while (true)
+        {
+            int victim = -1;
+            int most = 0;
+
+            for (int i = 0; i < job.numRanges; i++)
+            {
+                if (i == self)
+                    continue;
+
+                std::lock_guard<std::mutex> lock(job.ranges[i].lock);
+                int left = job.ranges[i].end - job.ranges[i].begin;
+
+                if (left > most)
+                {
+                    most = left;
+                    victim = i;
+                }
+            }
+
+            if (victim < 0)
+                return false;
+
+            int begin, end;
+            {
+                VLWorkRange& range = job.ranges[victim];
+                std::lock_guard<std::mutex> lock(range.lock);
+
+                int left = range.end - range.begin;
+                if (left <= 0)
+                    continue;   // someone beat us to it, look again
+
+                end = range.end;
+                begin = end - (left + 1) / 2;
+                range.end = begin;
+            }
+
+            VLWorkRange& own = job.ranges[self];
+            std::lock_guard<std::mutex> lock(own.lock);
+
+            *chunk = begin;
+            own.begin = begin + 1;
+            own.end = end;
+
+            return true;
+        }
+    }
+};
+
+inline int vl_thread_count(VLThreadOp op, double work)
+// Returns the number of threads to use for an operation of the given size
+{
+    int threads = vl_threads();
+
+    if (threads == 1 || work < vl_thread_threshold(op))
+        return 1;
+
+    if (threads <= 0)
+        threads = vl_max(int(std::thread::hardware_concurrency()), 1);
+
+    return threads;
+}
+
+#endif
+
+inline int vl_grain(double workPerItem)
+// Returns a chunk size giving a reasonable amount of work per chunk
+{
+    const double kChunkWork = 16384;
+    return workPerItem >= kChunkWork ? 1 : int(kChunkWork / vl_max(workPerItem, 1.0));
+}
+
+inline int vl_parallel_chunks(VLThreadOp op, double work, int n, int grain)
+// Returns the number of partial results vl_parallel_sum() combines for
+// these arguments, or 1 if it would run serially.
+{
+#ifndef VL_NO_THREADS
+    if (vl_thread_count(op, work) > 1 && n > grain)
+        return (n + grain - 1) / grain;
+#endif
+    return 1;
+}
+
+template<class T_FN> void vl_parallel_for_fn(const void* context, int begin, int end)
+{
+    (*(const T_FN*) context)(begin, end);
+}
+
+template<class T_FN> void vl_parallel_for(VLThreadOp op, double work, int n, int grain, const T_FN& fn)
+// Calls fn(begin, end) over chunks of [0, n) of at most 'grain' items,
+// splitting them across threads if 'work' is above the threshold for 'op'.
+{
+#ifndef VL_NO_THREADS
+    int threads = vl_thread_count(op, work);
+
+    if (threads > 1 && n > grain)
+        if (VLThreadPool::Get().Run(threads, vl_parallel_for_fn<T_FN>, &fn, n, grain))
+            return;
+#endif
+
+    fn(0, n);
+}
+
+template<class T, class T_FN> T vl_parallel_sum(VLThreadOp op, double work, int n, int grain, const T_FN& fn)
+// Returns the sum of fn(begin, end) over [0, n). When threaded, the partial
+// sums are per chunk and added in order, so the result doesn't depend on
+// scheduling.
+{
+    int numChunks = vl_parallel_chunks(op, work, n, grain);
+
+    if (numChunks == 1)
+        return fn(0, n);
+
+    std::vector<T> partial(numChunks);
+
+    vl_parallel_for(op, work, n, grain,
+        [&](int begin, int end)
+        {
+            for (int i = begin; i < end; i += grain)
+                partial[i / grain] = fn(i, vl_min(i + grain, end));
+        }
+    );
+
+    T s = partial[0];
+    for (int i = 1; i < numChunks; i++)
+        s += partial[i];
+
+    return s;
+}
+
+#endif
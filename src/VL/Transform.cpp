@@ -8,6 +8,8 @@
 
 
 #include "VL/Transform.hpp"
+#include "VL/Wide.hpp"
+#include "Threads.cpp"
 
 
 TMat2 CRot2(TElt theta)
@@ -368,3 +370,178 @@ TMat4 HRTrans4(const TVec3& t)
 
     return m;
 }
+
+
+// Mat34
+
+TMat34 HScale34(const TVec3& s)
+{
+    TMat34 m(vl_0);
+
+    m.x.x = s.x;
+    m.y.y = s.y;
+    m.z.z = s.z;
+
+    return m;
+}
+
+TMat34 HCRot34(const TVec3& axis, TElt theta)
+{
+    return TMat34(CRot3(axis, theta));
+}
+
+TMat34 HCRot34(VLAxis axis, TElt theta)
+{
+    return TMat34(CRot3(axis, theta));
+}
+
+TMat34 HCRot34(const TVec3& from, const TVec3& to)
+{
+    return TMat34(CRot3(from, to));
+}
+
+TMat34 HCTrans34(const TVec3& t)
+{
+    return TMat34(TMat3(vl_I), t);
+}
+
+
+// --- Batch transforms -------------------------------------------------------
+
+/*
+    NOTE
+
+    The batch transforms gather groups of vectors into a wide vector
+    filling the widest SIMD register available, apply the transform to the
+    whole group, and scatter the results back. Packed arrays are moved with
+    in-register transposes, and strided ones go through a small buffer.
+    Groups are independent, so large batches are split across threads.
+*/
+
+namespace
+{
+    const int kTransformLanes = VLLaneGroup<TElt>::kLanes;
+
+    typedef TVec3x<kTransformLanes> TWideVec3;
+
+    template<class T_FN> void TransformVectors
+    (
+        int count,
+        const TVec3* v, int vStride,
+        TVec3*       r, int rStride,
+        double       workPerVec,
+        const T_FN&  fn
+    )
+    // Sets r[i] = fn(v[i]), for strided v and r, a group at a time
+    {
+        const int N = kTransformLanes;
+
+        VL_ASSERT_MSG(count >= 0, "(Transform) negative count");
+        VL_ASSERT_MSG(vStride >= int(sizeof(TVec3)) && vStride % sizeof(TElt) == 0, "(Transform) bad input stride");
+        VL_ASSERT_MSG(rStride >= int(sizeof(TVec3)) && rStride % sizeof(TElt) == 0, "(Transform) bad result stride");
+
+        const char* vBytes = (const char*) v;
+        char*       rBytes = (char*) r;
+        int         groups = (count + N - 1) / N;
+
+        vl_parallel_for(kVLThreadTransform, workPerVec * count, groups, vl_grain(workPerVec * N),
+            [&](int begin, int end)
+            {
+                TVec3     buffer[N];
+                TWideVec3 w;
+
+                for (int g = begin; g < end; g++)
+                {
+                    int i = g * N;
+                    int n = vl_min(N, count - i);
+
+                    if (vStride == sizeof(TVec3))
+                        w.Load(v + i, n);
+                    else
+                    {
+                        for (int k = 0; k < n; k++)
+                            buffer[k] = *(const TVec3*) (vBytes + size_t(i + k) * vStride);
+
+                        w.Load(buffer, n);
+                    }
+
+                    w = fn(w);
+
+                    if (rStride == sizeof(TVec3))
+                        w.Store(r + i, n);
+                    else
+                    {
+                        w.Store(buffer, n);
+
+                        for (int k = 0; k < n; k++)
+                            *(TVec3*) (rBytes + size_t(i + k) * rStride) = buffer[k];
+                    }
+                }
+            }
+        );
+    }
+}
+
+void HApply(const TMat4& m, int count, const TVec3 p[], TVec3 r[], int pStride, int rStride)
+{
+    TransformVectors(count, p, pStride, r, rStride, 9,
+        [&m](const TWideVec3& v) { return HApply(m, v); }
+    );
+}
+
+void HProj(const TMat4& m, int count, const TVec3 p[], TVec3 r[], int pStride, int rStride)
+{
+    TransformVectors(count, p, pStride, r, rStride, 16,
+        [&m](const TWideVec3& v) { return HProj(m, v); }
+    );
+}
+
+void HApplyNormals(const TMat4& m, int count, const TVec3 n[], TVec3 r[], int nStride, int rStride, bool normalize)
+{
+    TMat3 a
+    (
+        m.x.x, m.x.y, m.x.z,
+        m.y.x, m.y.y, m.y.z,
+        m.z.x, m.z.y, m.z.z
+    );
+
+    TMat3 it = trans(inv(a));
+
+    if (normalize)
+        TransformVectors(count, n, nStride, r, rStride, 12,
+            [&it](const TWideVec3& v) { return norm(it * v); }
+        );
+    else
+        TransformVectors(count, n, nStride, r, rStride, 9,
+            [&it](const TWideVec3& v) { return it * v; }
+        );
+}
+
+void HApply(const TMat34& m, int count, const TVec3 p[], TVec3 r[], int pStride, int rStride)
+{
+    TransformVectors(count, p, pStride, r, rStride, 9,
+        [&m](const TWideVec3& v) { return HApply(m, v); }
+    );
+}
+
+void xform(const TMat3& m, int count, const TVec3 v[], TVec3 r[], int vStride, int rStride)
+{
+#ifdef VL_ROW_ORIENT
+    TMat3 a = trans(m);
+#else
+    const TMat3& a = m;
+#endif
+
+    TransformVectors(count, v, vStride, r, rStride, 9,
+        [&a](const TWideVec3& w) { return a * w; }
+    );
+}
+
+void xform(const TMat4& m, int count, const TVec3 p[], TVec3 r[], int pStride, int rStride)
+{
+#ifdef VL_ROW_ORIENT
+    HProj(trans(m), count, p, r, pStride, rStride);
+#else
+    HProj(m, count, p, r, pStride, rStride);
+#endif
+}
@@ -8,6 +8,7 @@
 
 
 #include "VL/Vec.hpp"
+#include "Simd.cpp"
 
 
 // --- RefVec Assignment Operators --------------------------------------------
@@ -37,7 +38,7 @@ const TRefVec& TRefVec::operator = (TConstSliceVec v) const
     VL_ASSERT_MSG(elts == v.elts, "(Vec::=) Vector sizes don't match");
 
     for (int i = 0; i < elts; i++)
-        data[i] = v.data[i];
+        data[i] = v.data[i * v.span];
 
     return *this;
 }
@@ -48,8 +49,7 @@ const TRefVec& TRefVec::operator += (TConstRefVec v) const
 {
     VL_ASSERT_MSG(elts == v.elts, "(Vec::+=) Vector sizes don't match");
 
-    for (int i = 0; i < elts; i++)
-        data[i] += v.data[i];
+    vl_add(data, v.data, data, elts);
 
     return *this;
 }
@@ -58,8 +58,7 @@ const TRefVec& TRefVec::operator -= (TConstRefVec v) const
 {
     VL_ASSERT_MSG(elts == v.elts, "(Vec::-=) Vector sizes don't match");
 
-    for (int i = 0; i < elts; i++)
-        data[i] -= v.data[i];
+    vl_subtract(data, v.data, data, elts);
 
     return *this;
 }
@@ -68,8 +67,7 @@ const TRefVec& TRefVec::operator *= (TConstRefVec v) const
 {
     VL_ASSERT_MSG(elts == v.elts, "(Vec::*=) Vector sizes don't match");
 
-    for (int i = 0; i < elts; i++)
-        data[i] *= v.data[i];
+    vl_multiply(data, v.data, data, elts);
 
     return *this;
 }
@@ -78,16 +76,14 @@ const TRefVec& TRefVec::operator /= (TConstRefVec v) const
 {
     VL_ASSERT_MSG(elts == v.elts, "(Vec::/=) Vector sizes don't match");
 
-    for (int i = 0; i < elts; i++)
-        data[i] /= v.data[i];
+    vl_divide(data, v.data, data, elts);
 
     return *this;
 }
 
 const TRefVec& TRefVec::operator *= (TElt s) const
 {
-    for (int i = 0; i < elts; i++)
-        data[i] *= s;
+    vl_scale(data, s, data, elts);
 
     return *this;
 }
@@ -421,22 +417,12 @@ TElt dot(TConstRefVec a, TConstRefVec b)
 {
     VL_ASSERT_MSG(a.elts == b.elts, "(Vec::dot) Vector sizes don't match");
 
-    TElt  sum = TElt(vl_zero);
-
-    for (int i = 0; i < a.elts; i++)
-        sum += a.data[i] * b.data[i];
-
-    return sum;
+    return vl_dot(a.data, b.data, a.elts);
 }
 
 TElt sum(TConstRefVec v)
 {
-    TElt s = TElt(vl_0);
-
-    for (int i = 0; i < v.elts; i++)
-        s += v.data[i];
-
-    return s;
+    return vl_sum(v.data, v.elts);
 }
 
 TVec abs(TConstRefVec v)
@@ -461,8 +447,7 @@ void Add(TConstRefVec a, TConstRefVec b, TRefVec result)
     VL_ASSERT_MSG(a.elts == b     .elts, "(Vec::+) Vector sizes don't match");
     VL_ASSERT_MSG(a.elts == result.elts, "(Vec::+) Vector sizes don't match");
 
-    for (int i = 0; i < a.elts; i++)
-        result.data[i] = a.data[i] + b.data[i];
+    vl_add(a.data, b.data, result.data, a.elts);
 }
 
 void Subtract(TConstRefVec a, TConstRefVec b, TRefVec result)
@@ -470,16 +455,14 @@ void Subtract(TConstRefVec a, TConstRefVec b, TRefVec result)
     VL_ASSERT_MSG(a.elts == b     .elts, "(Vec::-) Vector sizes don't match");
     VL_ASSERT_MSG(a.elts == result.elts, "(Vec::-) Vector sizes don't match");
 
-    for (int i = 0; i < a.elts; i++)
-        result.data[i] = a.data[i] - b.data[i];
+    vl_subtract(a.data, b.data, result.data, a.elts);
 }
 
 void Negate(TConstRefVec v, TRefVec result)
 {
     VL_ASSERT_MSG(v.elts == result.elts, "(Vec::-) Vector sizes don't match");
 
-    for (int i = 0; i < v.elts; i++)
-        result.data[i] = - v.data[i];
+    vl_negate(v.data, result.data, v.elts);
 }
 
 void Multiply(TConstRefVec a, TConstRefVec b, TRefVec result)
@@ -487,24 +470,21 @@ void Multiply(TConstRefVec a, TConstRefVec b, TRefVec result)
     VL_ASSERT_MSG(a.elts == b     .elts, "(Vec::*) Vector sizes don't match");
     VL_ASSERT_MSG(a.elts == result.elts, "(Vec::*) Vector sizes don't match");
 
-    for (int i = 0; i < a.elts; i++)
-        result.data[i] = a.data[i] * b.data[i];
+    vl_multiply(a.data, b.data, result.data, a.elts);
 }
 
 void Multiply(TConstRefVec v, TElt s, TRefVec result)
 {
     VL_ASSERT_MSG(v.elts == result.elts, "(Vec::*) Vector sizes don't match");
 
-    for (int i = 0; i < v.elts; i++)
-        result.data[i] = v.data[i] * s;
+    vl_scale(v.data, s, result.data, v.elts);
 }
 
 void MultiplyAccum(TConstRefVec v, const TElt s, TRefVec result)
 {
     VL_ASSERT_MSG(v.elts == result.elts, "(Vec::MultiplyAccum) Vector sizes don't match");
 
-    for (int i = 0; i < v.elts; i++)
-        result.data[i] += s * v.data[i];
+    vl_scale_accum(v.data, s, result.data, v.elts);
 }
 
 void Divide(TConstRefVec a, TConstRefVec b, TRefVec result)
@@ -512,17 +492,14 @@ void Divide(TConstRefVec a, TConstRefVec b, TRefVec result)
     VL_ASSERT_MSG(a.elts == b     .elts, "(Vec::/) Vector sizes don't match");
     VL_ASSERT_MSG(a.elts == result.elts, "(Vec::/) Vector sizes don't match");
 
-    for (int i = 0; i < a.elts; i++)
-        result.data[i] = a.data[i] / b.data[i];
+    vl_divide(a.data, b.data, result.data, a.elts);
 }
 
 void Divide(TConstRefVec v, TElt s, TRefVec result)
 {
     VL_ASSERT_MSG(v.elts == result.elts, "(Vec::/) Vector sizes don't match");
 
-    TElt t = TElt(vl_1) / s;
-    for (int i = 0; i < v.elts; i++)
-        result.data[i] = v.data[i] * t;
+    vl_scale(v.data, TElt(TElt(vl_1) / s), result.data, v.elts);
 }
 
 #ifndef VL_NO_REAL
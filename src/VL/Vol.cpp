@@ -7,6 +7,29 @@
 */
 
 #include "VL/Vol.hpp"
+#include "Threads.cpp"
+
+namespace
+{
+    // Large volumes have their elementwise operations split across threads,
+    // with each thread handling a contiguous span of elements.
+
+    template<class T_OP> inline void ForSpans(const TConstRefVol& v, const T_OP& op)
+    {
+        int n = v.Elts();
+        vl_parallel_for(kVLThreadElementwise, n, n, vl_grain(1), op);
+    }
+
+    inline TConstRefVec Span(TConstRefVol v, int begin, int end)
+    {
+        return TConstRefVec(end - begin, v.data + begin);
+    }
+
+    inline TRefVec Span(TRefVol v, int begin, int end)
+    {
+        return TRefVec(end - begin, v.data + begin);
+    }
+}
 
 
 // --- RefVol Assignment Operators --------------------------------------------
@@ -46,40 +69,40 @@ const TRefVol& TRefVol::operator = (TConstSliceVol v) const
 const TRefVol& TRefVol::operator += (TConstRefVol v) const
 {
     VL_ASSERT_MSG(same_size(*this, v), "(Vol::+=) Volume dimensions don't match");
-    AsVec() += v.AsVec();
+    ForSpans(*this, [&](int i0, int i1) { Span(*this, i0, i1) += Span(v, i0, i1); });
     return *this;
 }
 
 const TRefVol& TRefVol::operator -= (TConstRefVol v) const
 {
     VL_ASSERT_MSG(same_size(*this, v), "(Vol::-=) Volume dimensions don't match");
-    AsVec() -= v.AsVec();
+    ForSpans(*this, [&](int i0, int i1) { Span(*this, i0, i1) -= Span(v, i0, i1); });
     return *this;
 }
 
 const TRefVol& TRefVol::operator *= (TConstRefVol v) const
 {
     VL_ASSERT_MSG(same_size(*this, v), "(Vol::*=) Volume dimensions don't match");
-    AsVec() *= v.AsVec();
+    ForSpans(*this, [&](int i0, int i1) { Span(*this, i0, i1) *= Span(v, i0, i1); });
     return *this;
 }
 
 const TRefVol& TRefVol::operator /= (TConstRefVol v) const
 {
     VL_ASSERT_MSG(same_size(*this, v), "(Vol::/=) Volume dimensions don't match");
-    AsVec() /= v.AsVec();
+    ForSpans(*this, [&](int i0, int i1) { Span(*this, i0, i1) /= Span(v, i0, i1); });
     return *this;
 }
 
 const TRefVol& TRefVol::operator *= (TElt s) const
 {
-    AsVec() *= s;
+    ForSpans(*this, [&](int i0, int i1) { Span(*this, i0, i1) *= s; });
     return *this;
 }
 
 const TRefVol& TRefVol::operator /= (TElt s) const
 {
-    AsVec() /= s;
+    ForSpans(*this, [&](int i0, int i1) { Span(*this, i0, i1) /= s; });
     return *this;
 }
 
@@ -336,63 +359,63 @@ void Add(TConstRefVol a, TConstRefVol b, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(a, b), "(Vol::+) Volume dimensions don't match");
     VL_ASSERT_MSG(same_size(a, r), "(Vol::+) Volume dimensions don't match");
-    Add(a.AsVec(), b.AsVec(), r.AsVec());
+    ForSpans(a, [&](int i0, int i1) { Add(Span(a, i0, i1), Span(b, i0, i1), Span(r, i0, i1)); });
 }
 
 void Subtract(TConstRefVol a, TConstRefVol b, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(a, b), "(Vol::-) Volume dimensions don't match");
     VL_ASSERT_MSG(same_size(a, r), "(Vol::-) Volume dimensions don't match");
-    Subtract(a.AsVec(), b.AsVec(), r.AsVec());
+    ForSpans(a, [&](int i0, int i1) { Subtract(Span(a, i0, i1), Span(b, i0, i1), Span(r, i0, i1)); });
 }
 
 void Multiply(TConstRefVol a, TConstRefVol b, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(a, b), "(Vol::*) Volume dimensions don't match");
     VL_ASSERT_MSG(same_size(a, r), "(Vol::*) Volume dimensions don't match");
-    Multiply(a.AsVec(), b.AsVec(), r.AsVec());
+    ForSpans(a, [&](int i0, int i1) { Multiply(Span(a, i0, i1), Span(b, i0, i1), Span(r, i0, i1)); });
 }
 
 void Divide(TConstRefVol a, TConstRefVol b, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(a, b), "(Vol::/) Volume dimensions don't match");
     VL_ASSERT_MSG(same_size(a, r), "(Vol::/) Volume dimensions don't match");
-    Divide(a.AsVec(), b.AsVec(), r.AsVec());
+    ForSpans(a, [&](int i0, int i1) { Divide(Span(a, i0, i1), Span(b, i0, i1), Span(r, i0, i1)); });
 }
 
 void Negate(TConstRefVol v, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(v, r), "(Vol::-) Volume dimensions don't match");
-    Negate(v.AsVec(), r.AsVec());
+    ForSpans(v, [&](int i0, int i1) { Negate(Span(v, i0, i1), Span(r, i0, i1)); });
 }
 
 void Multiply(TConstRefVol v, TElt s, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(v, r), "(Vol::*s) Volume dimensions don't match");
-    Multiply(v.AsVec(), s, r.AsVec());
+    ForSpans(v, [&](int i0, int i1) { Multiply(Span(v, i0, i1), s, Span(r, i0, i1)); });
 }
 
 void MultiplyAccum(TConstRefVol v, TElt s, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(v, r), "(Vol::*s) Volume dimensions don't match");
-    MultiplyAccum(v.AsVec(), s, r.AsVec());
+    ForSpans(v, [&](int i0, int i1) { MultiplyAccum(Span(v, i0, i1), s, Span(r, i0, i1)); });
 }
 
 void Divide(TConstRefVol v, TElt s, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(v, r), "(Vol::/s) Volume dimensions don't match");
-    Divide(v.AsVec(), s, r.AsVec());
+    ForSpans(v, [&](int i0, int i1) { Divide(Span(v, i0, i1), s, Span(r, i0, i1)); });
 }
 
 void Absolute(TConstRefVol v, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(v, r), "(Vol::abs) Volume dimensions don't match");
-    Absolute(v.AsVec(), r.AsVec());
+    ForSpans(v, [&](int i0, int i1) { Absolute(Span(v, i0, i1), Span(r, i0, i1)); });
 }
 
 void Clamp(TRefVol v, TElt fuzz)
 {
-    Clamp(v.AsVec(), fuzz);
+    ForSpans(v, [&](int i0, int i1) { Clamp(Span(v, i0, i1), fuzz); });
 }
 
 TElt InnerProduct(TConstRefVol a, TConstRefVol b)
@@ -401,6 +424,19 @@ TElt InnerProduct(TConstRefVol a, TConstRefVol b)
     return dot(a.AsVec(), b.AsVec());
 }
 
+TElt sumsqr(TConstRefVol v)
+{
+    int n = v.Elts();
+
+    return vl_parallel_sum<TElt>(kVLThreadReduce, n, n, vl_grain(1),
+        [&](int i0, int i1)
+        {
+            TConstRefVec s(Span(v, i0, i1));
+            return dot(s, s);
+        }
+    );
+}
+
 void OuterProduct(TConstRefVec a, TConstRefVec b, TConstRefVec c, TRefVol r)
 {
     VL_ASSERT_MSG(a.elts == r.slices, "(Vol::oprod) Volume dimensions don't match");
@@ -417,6 +453,6 @@ void HadamardProduct(TConstRefVol a, TConstRefVol b, TRefVol r)
 {
     VL_ASSERT_MSG(same_size(a, b), "(Vol::-) Volume dimensions don't match");
     VL_ASSERT_MSG(same_size(a, r), "(Vol::-) Volume dimensions don't match");
-    Multiply(a.AsVec(), b.AsVec(), r.AsVec());
+    ForSpans(a, [&](int i0, int i1) { Multiply(Span(a, i0, i1), Span(b, i0, i1), Span(r, i0, i1)); });
 }
 
@@ -23,6 +23,11 @@ void Test3DStuff();
 void Test4DStuff();
 void TestH2DStuff();
 void TestH3DStuff();
+void Test3DFactor();
+void Test3DWide();
+void Test3DBatchTransforms();
+void Test3DBatchQuat();
+void Test3DAffine();
 void TestComparisons();
 
 #define TEST_VL_N
@@ -30,7 +35,23 @@ void TestComparisons();
 void TestNInit();
 void TestND();
 void TestNDSub();
+void TestNDProducts();
+void TestNDKernels();
+void TestNDThreads();
 void TestNDNumerical();
+void TestNDLU();
+void TestNDSVD();
+void TestNDQR();
+void TestNDCholesky();
+void TestNDCholeskyUpdate();
+void TestNDEigen();
+void TestNDSparse();
+void TestNDPrecond();
+void TestNDOperator();
+void TestNDLanczos();
+void TestNDRandomizedSVD();
+void TestNDNonSymmetric();
+void TestNDWorkspace();
 void TestNDFunc();
 void TestNComparisons();
 
@@ -254,6 +275,34 @@ void Test4DStuff()
     M *= 6.0f;
     M /= 3.0f;
     cout << "M *= 6/3 :\n" << M << endl;
+
+    // Mat4f, which has SSE/NEON versions under VL_SIMD
+    Mat4f A(1,2,3,0, 2,3,0,5, 3,0,5,6, 0,5,6,7);
+    Mat4f B = HCTrans4f(Vec3f(1, 2, 3)) * HCRot4f(vl_y, 1.256f);
+    Mat4f AB = A;
+    AB *= B;
+    Vec4f xA = x;
+    xA *= A;
+
+    Mat4d Ad(1,2,3,0, 2,3,0,5, 3,0,5,6, 0,5,6,7);
+    Mat4d Bd = HCTrans4d(Vec3d(1, 2, 3)) * HCRot4d(vl_y, 1.256);
+
+    float error = 0.0f;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+        {
+            error = vl_max(error, float(abs((A * B)[i][j] - (Ad * Bd)[i][j])));
+            error = vl_max(error, float(abs(AB[i][j]      - (Ad * Bd)[i][j])));
+            error = vl_max(error, float(abs(inv(A)[i][j]  - inv(Ad)[i][j])));
+            error = vl_max(error, float(abs(trans(A)[i][j] - A[j][i])));
+        }
+    for (int i = 0; i < 4; i++)
+    {
+        error = vl_max(error, float(abs((A * x)[i] - (Ad * x)[i])));
+        error = vl_max(error, float(abs((x * A)[i] - (x * Ad)[i])));
+        error = vl_max(error, float(abs(xA[i]      - (x * Ad)[i])));
+    }
+    cout << "Mat4f matches Mat4d: " << (error < 1e-5f) << endl;
 }
 
 void TestH2DStuff()
@@ -308,6 +357,344 @@ void TestH3DStuff()
         "* HScale4(Vec3(1,2,1)) * y = " << x << endl;
 }
 
+void Test3DFactor()
+{
+    cout << "\n+ Test3DFactor\n\n";
+
+    auto size = [](const Mat3d& m) { return len(m[0]) + len(m[1]) + len(m[2]); };
+
+    const int n = 7;
+    Mat3d A[n] =
+    {
+        Mat3d(1, 2, 3, 4, 5, 6, 7, 8, 10),
+        Mat3d(vl_I),
+        Mat3d(vl_0),
+        Mat3d(1, 2, 3, 2, 4, 6, 1, 1, 1),           // rank 2
+        Scale3d(Vec3d(2, 1, -1)),                   // reflection
+        CRot3d(Vec3d(1, 2, 3) / len(Vec3d(1, 2, 3)), 0.7) * Scale3d(Vec3d(3, 3, 1)),
+        Mat3d(0.1, -2, 0.3, 4, 0.5, -0.6, 0.7, 8, 0.9)
+    };
+
+    Mat3d U[n], V[n];
+    Vec3d D[n];
+
+    SVDFactorization(n, A, U, V, D);
+
+    // Compare U Vt rather than U and V, as with repeated singular values
+    // they're only unique up to a rotation of that subspace.
+    for (int k = 0; k < n; k++)
+    {
+        Mat3d Us, Vs;
+        Vec3d Ds;
+        SVDFactorization(A[k], Us, Vs, Ds);
+
+        cout << "D: " << D[k] << endl;
+        cout << "  U D Vt = A: " << (size(U[k] * Mat3d(D[k]) * trans(V[k]) - A[k]) < 1e-12)
+             << ", rotations: " << (size(trans(U[k]) * U[k] - Mat3d(vl_I)) < 1e-12 && det(U[k]) > 0 && det(V[k]) > 0)
+             << ", sorted: " << (D[k][0] > D[k][1] - 1e-12 && D[k][1] > abs(D[k][2]) - 1e-12)
+             << ", matches scalar: " << (len(Ds - D[k]) + size(Us * trans(Vs) - U[k] * trans(V[k])) < 1e-12) << endl;
+    }
+
+    Mat3d R[n], S[n];
+    PolarDecomposition(n, A, R, S);
+
+    for (int k = 0; k < n; k++)
+        cout << "R S = A: " << (size(R[k] * S[k] - A[k]) < 1e-12)
+             << ", S symmetric: " << (size(S[k] - trans(S[k])) < 1e-12)
+             << ", R rotation: " << (size(trans(R[k]) * R[k] - Mat3d(vl_I)) < 1e-12 && det(R[k]) > 0) << endl;
+
+    Mat3d sym = A[0] + trans(A[0]);
+    Mat3d E;
+    Vec3d values;
+    SymmetricEigen(sym, E, values);
+
+    cout << "eigenvalues: " << values << endl;
+    cout << "V D Vt = S: " << (size(E * Mat3d(values) * trans(E) - sym) < 1e-12) << endl;
+}
+
+void Test3DWide()
+{
+    cout << "\n+ Test3DWide\n\n";
+
+    const int n = 21;   // leaves a partial group
+    Vec3f a[n], b[n], r[n];
+
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = Vec3f(1.0f + i, 2.0f - 0.5f * i, 0.25f * i * i);
+        b[i] = Vec3f(-1.0f, 0.1f * i, 3.0f - i);
+    }
+
+    Mat3f m3 = CRot3f(norm(Vec3f(1, 2, 3)), 0.7f) * Scale3f(Vec3f(1, 2, 3));
+    Mat4f m4 = HCTrans4f(Vec3f(1, -2, 3)) * HCRot4f(norm(Vec3f(3, 1, 2)), -0.4f);
+    m4[3] = Vec4f(0.01f, 0.02f, 0.0f, 1.0f);   // perspective
+
+    for (int i = 0; i < n; i += 8)
+    {
+        int count = vl_min(n - i, 8);
+
+        Vec3fx8 wa, wb;
+        wa.Load(a + i, count);
+        wb.Load(b + i, count);
+
+        Vec3fx8 w = m3 * norm(cross(wa, wb)) * dot(wa, wb) + lerp(wa, wb, 0.25f);
+        xform(m4, w).Store(r + i, count);
+    }
+
+    float error = 0.0f;
+    for (int i = 0; i < n; i++)
+    {
+        Vec3f v = m3 * norm(cross(a[i], b[i])) * dot(a[i], b[i]) + lerp(a[i], b[i], 0.25f);
+        error = vl_max(error, len(xform(m4, v) - r[i]) / len(r[i]));
+    }
+    cout << "Vec3fx8 matches Vec3f: " << (error < 1e-5f) << endl;
+
+    Vec4f c[n], s[n];
+    for (int i = 0; i < n; i++)
+        c[i] = Vec4f(a[i], 1.0f + 0.1f * i);
+
+    for (int i = 0; i < n; i += 4)
+    {
+        Vec4fx4 w;
+        w.Load(c + i, vl_min(n - i, 4));
+        (m4 * norm(w)).Store(s + i, vl_min(n - i, 4));
+    }
+
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(m4 * norm(c[i]) - s[i]));
+    cout << "Vec4fx4 matches Vec4f: " << (error < 1e-5f) << endl;
+
+    Vec3dx4 wd(Vec3d(1, 2, 2));
+    wd.Set(2, Vec3d(0, 3, 4));
+    Vec3dx4 hd = HApply(HCTrans4d(Vec3d(1, 1, 1)), wd * len(wd));
+
+    cout << "Vec3dx4 len: " << len(wd)[0] << ", " << len(wd)[2]
+         << ", HApply: " << hd.Get(0) << ", " << hd.Get(2) << endl;
+}
+
+void Test3DBatchTransforms()
+{
+    cout << "\n+ Test3DBatchTransforms\n\n";
+
+    struct Vertex
+    {
+        Vec3f p;
+        Vec3f n;
+        Vec2f uv;
+    };
+
+    const int n = 203;
+    Vec3f p[n], r[n], normals[n];
+    Vertex vertices[n];
+
+    for (int i = 0; i < n; i++)
+    {
+        p[i] = Vec3f(1.0f + i % 7, 0.5f * (i % 5), 2.0f - 0.1f * i);
+        vertices[i].p = p[i];
+        normals[i] = norm(Vec3f(1.0f, 0.1f * i, -0.5f));
+        vertices[i].n = normals[i];
+        vertices[i].uv = Vec2f(vl_0);
+    }
+
+    Mat4f m = HCTrans4f(Vec3f(1, 2, 3)) * HCRot4f(norm(Vec3f(1, 2, 3)), 0.3f) * HScale4f(Vec3f(1, 2, -3));
+    Mat4f persp = m;
+    persp[3] = Vec4f(0.01f, 0.02f, 0.0f, 1.0f);
+
+    HApply(m, n, p, r);
+    float error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(HApply(m, p[i]) - r[i]));
+    cout << "HApply batch matches: " << (error < 1e-5f) << endl;
+
+    HProj(persp, n, p, r);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(HProj(persp, p[i]) - r[i]));
+    cout << "HProj batch matches: " << (error < 1e-5f) << endl;
+
+    xform(Mat3f(m[0].AsVec3(), m[1].AsVec3(), m[2].AsVec3()), n, p, r);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(xform(Mat3f(m[0].AsVec3(), m[1].AsVec3(), m[2].AsVec3()), p[i]) - r[i]));
+    cout << "xform batch matches: " << (error < 1e-5f) << endl;
+
+    xform(persp, n, p, r);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(xform(persp, p[i]) - r[i]));
+    cout << "xform Mat4 batch matches: " << (error < 1e-5f) << endl;
+
+    // Normals transform by the inverse transpose of m's 3x3 part
+    Mat3f it = trans(inv(Mat3f(m[0].AsVec3(), m[1].AsVec3(), m[2].AsVec3())));
+
+    HApplyNormals(m, n, normals, r, sizeof(Vec3f), sizeof(Vec3f), false);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(it * normals[i] - r[i]));
+    cout << "HApplyNormals unnormalized batch matches: " << (error < 1e-5f) << endl;
+
+    // Interleaved, in place
+    vl_set_threads(4);
+    vl_set_thread_threshold(kVLThreadTransform, 0);
+
+    HApply(m, n, &vertices[0].p, &vertices[0].p, sizeof(Vertex), sizeof(Vertex));
+    HApplyNormals(m, n, &vertices[0].n, &vertices[0].n, sizeof(Vertex), sizeof(Vertex));
+
+    vl_set_thread_threshold(kVLThreadTransform, 1 << 20);
+    vl_set_threads(1);
+
+    float normalError = 0.0f, unitError = 0.0f, perpError = 0.0f;
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+    {
+        error = vl_max(error, len(HApply(m, p[i]) - vertices[i].p));
+
+        Vec3f ti = cross(normals[i], Vec3f(vl_z));  // tangent to this vertex's normal
+        Vec3f mt = HApply(m, p[i] + ti) - HApply(m, p[i]);
+
+        normalError = vl_max(normalError, len(norm(it * normals[i]) - vertices[i].n));
+        unitError   = vl_max(unitError,   abs(len(vertices[i].n) - 1.0f));
+        perpError   = vl_max(perpError,   abs(dot(mt, vertices[i].n)) / len(mt));
+    }
+
+    cout << "strided points match: " << (error < 1e-5f)
+         << ", normals match: " << (normalError < 1e-5f)
+         << ", normals unit: " << (unitError < 1e-5f)
+         << ", normals perpendicular: " << (perpError < 1e-5f)
+         << ", uvs untouched: " << (vertices[n - 1].uv == Vec2f(vl_0)) << endl;
+}
+
+void Test3DBatchQuat()
+{
+    cout << "\n+ Test3DBatchQuat\n\n";
+
+    const int n = 37;
+    Quatf a[n], b[n], r[n];
+    Vec3f p[n], rp[n], t[n];
+    Mat3f m3[n];
+    Mat4f m4[n];
+
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = MakeQuat(norm(Vec3f(1.0f, 0.1f * i, -0.5f)), 0.2f * i);
+        b[i] = MakeQuat(norm(Vec3f(0.3f * i, 1.0f, 0.5f)), 2.0f - 0.15f * i);
+        p[i] = Vec3f(1.0f + i % 7, 0.5f * (i % 5), 2.0f - 0.1f * i);
+        t[i] = Vec3f(float(i), 1.0f, -2.0f);
+    }
+
+    QuatApply(n, p, a, rp);
+    float error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(QuatApply(p[i], a[i]) - rp[i]));
+    cout << "QuatApply batch matches: " << (error < 1e-5f) << endl;
+
+    QuatMult(n, a, b, r);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(QuatMult(a[i], b[i]) - r[i]));
+    cout << "QuatMult batch matches: " << (error < 1e-5f) << endl;
+
+    NLerp(n, a, b, 0.3f, r);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(NLerp(a[i], b[i], 0.3f) - r[i]));
+    cout << "NLerp batch matches: " << (error < 1e-5f) << endl;
+
+    SLerp(n, a, b, 0.3f, r);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(SLerp(a[i], b[i], 0.3f) - r[i]));
+    cout << "SLerp batch matches: " << (error < 1e-5f) << endl;
+
+    // SLerpFast against exact SLerp along the shorter arc
+    float fastError = 0.0f;
+    error = 0.0f;
+    for (int j = 0; j <= 10; j++)
+    {
+        float s = 0.1f * j;
+        SLerpFast(n, a, b, s, r);
+
+        for (int i = 0; i < n; i++)
+        {
+            error = vl_max(error, len(SLerpFast(a[i], b[i], s) - r[i]));
+            fastError = vl_max(fastError, len(SLerp(a[i], QuatConstrain(a[i], b[i]), s) - r[i]));
+        }
+    }
+    cout << "SLerpFast batch matches: " << (error < 1e-5f) << ", error bounded: " << (fastError < 1e-4f) << endl;
+
+    CRotFromQuat(n, a, m3);
+    CRotFromQuat(n, a, m4, t);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+    {
+        Mat3f e3 = m3[i] - CRotFromQuat(a[i]);
+        Mat4f e4 = m4[i] - HCTrans4f(t[i]) * HCRot4f(a[i]);
+
+        for (int j = 0; j < 3; j++)
+            error = vl_max(error, len(e3[j]));
+        for (int j = 0; j < 4; j++)
+            error = vl_max(error, len(e4[j]));
+    }
+    cout << "CRotFromQuat batch matches: " << (error < 1e-5f) << endl;
+}
+
+void Test3DAffine()
+{
+    cout << "\n+ Test3DAffine\n\n";
+
+    Mat34f a = HCTrans34f(Vec3f(1.0f, 2.0f, 3.0f)) * HCRot34f(norm(Vec3f(1.0f, 2.0f, 3.0f)), 0.3f) * HScale34f(Vec3f(1.0f, 2.0f, -3.0f));
+    Mat4f  a4 = HCTrans4f(Vec3f(1.0f, 2.0f, 3.0f)) * HCRot4f(norm(Vec3f(1.0f, 2.0f, 3.0f)), 0.3f) * HScale4f(Vec3f(1.0f, 2.0f, -3.0f));
+    Mat34f b = HCRot34f(MakeQuat(norm(Vec3f(1.0f, 1.0f, 0.0f)), 0.7f), Vec3f(4.0f, 5.0f, 6.0f));
+    Vec3f  p(0.5f, -1.0f, 2.0f);
+
+    cout << "a = \n" << a << endl;
+
+    float error = 0.0f;
+    Mat4f e4 = a.AsMat4() - a4;
+    for (int i = 0; i < 4; i++)
+        error = vl_max(error, len(e4[i]));
+    cout << "matches Mat4: " << (error < 1e-5f) << endl;
+
+    error = 0.0f;
+    Mat4f c4 = (a * b).AsMat4() - a4 * b.AsMat4();
+    for (int i = 0; i < 4; i++)
+        error = vl_max(error, len(c4[i]));
+    cout << "composition matches Mat4: " << (error < 1e-5f) << endl;
+
+    cout << "HApply matches: " << (len(HApply(a, p) - xform(a4, p)) < 1e-5f)
+         << ", HApplyVector matches: " << (len(HApplyVector(a, p) - (a4 * Vec4f(p, 0.0f)).AsVec3()) < 1e-5f) << endl;
+
+    Mat34f ia = a * inv(a) - Mat34f(vl_I);
+    Mat34f ib = b * inv_rigid(b) - Mat34f(vl_I);
+    error = 0.0f;
+    for (int i = 0; i < 3; i++)
+        error = vl_max(error, vl_max(len(ia[i]), len(ib[i])));
+    cout << "inv and inv_rigid: " << (error < 1e-5f) << endl;
+
+    const int n = 37;
+    Vec3f pts[n], r[n];
+    for (int i = 0; i < n; i++)
+        pts[i] = Vec3f(1.0f + i % 7, 0.5f * (i % 5), 2.0f - 0.1f * i);
+
+    HApply(a, n, pts, r, sizeof(Vec3f), sizeof(Vec3f));
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(HApply(a, pts[i]) - r[i]));
+    cout << "batch HApply matches: " << (error < 1e-5f) << endl;
+
+    Quatf  q[n];
+    Mat34f m[n];
+    for (int i = 0; i < n; i++)
+        q[i] = MakeQuat(norm(Vec3f(1.0f, 0.1f * i, -0.5f)), 0.2f * i);
+
+    CRotFromQuat(n, q, m, pts);
+    error = 0.0f;
+    for (int i = 0; i < n; i++)
+        error = vl_max(error, len(HApply(m[i], r[i]) - (QuatApply(r[i], q[i]) + pts[i])));
+    cout << "batch CRotFromQuat matches: " << (error < 1e-4f) << endl;
+}
+
 void TestComparisons()
 {
     cout << "\n+ TestComparisons\n" << endl;
@@ -457,6 +844,216 @@ void TestNDSub()
     cout << "\nM:\n" << M << endl;
 }
 
+void TestNDProducts()
+{
+    cout << "\n+ TestNDProducts\n\n";
+
+    // Large enough to use the blocked multiply path
+    Matd A(100, 70), B(70, 90), C(100, 90);
+
+    for (int i = 0; i < A.Rows(); i++)
+        for (int j = 0; j < A.Cols(); j++)
+            A(i, j) = (i * 7 + j * 3) % 11 - 5;
+    for (int i = 0; i < B.Rows(); i++)
+        for (int j = 0; j < B.Cols(); j++)
+            B(i, j) = (i * 5 + j * 2) % 13 - 6;
+
+    for (int i = 0; i < C.Rows(); i++)
+        for (int j = 0; j < C.Cols(); j++)
+        {
+            C(i, j) = 0;
+            for (int k = 0; k < A.Cols(); k++)
+                C(i, j) += A(i, k) * B(k, j);
+        }
+
+    cout << "A * B error: " << frob(A * B - C) << endl;
+    cout << "Bt * At error: " << frob(transpose(gen(B)) * transpose(gen(A)) - trans(C)) << endl;
+
+    Matd AA(first(A, 70, 70));
+    AA *= first(B, 70, 70);
+    cout << "In-place A *= B error: " << frob(AA - first(A, 70, 70) * first(B, 70, 70)) << endl;
+
+    // Transposed products, without forming the transposes
+    Matd AtC(70, 90), ABt(100, 90), AtA(70, 70), AAt(100, 100);
+    Vecd x(70), AtAx(70);
+
+    for (int i = 0; i < x.Elts(); i++)
+        x[i] = i % 5 - 2;
+
+    MultiplyAtB(A, C, AtC);
+    MultiplyABt(A, trans(B), ABt);
+    MultiplyAtA(A, AtA);
+    MultiplyAAt(A, AAt);
+    MultiplyAtAx(A, x, AtAx);
+
+    cout << "At * C error: " << frob(AtC - trans(A) * C) << endl;
+    cout << "A * Bt error: " << frob(ABt - C) << endl;
+    cout << "At * A error: " << frob(AtA - trans(A) * A) << ", gram: " << frob(gram(A) - AtA) << endl;
+    cout << "A * At error: " << frob(AAt - A * trans(A)) << endl;
+    cout << "At * (A * x) error: " << len(AtAx - (A * x) * A) << endl;
+}
+
+template<class T_VEC> double KernelErrors(int n)
+{
+    // Integer-valued data, so all results should be exact whatever the
+    // vector width or summation order.
+    T_VEC a(n), b(n), c(n), r(n);
+
+    double d = 0.0;
+    double s = 0.0;
+
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = (i * 7) % 11 - 5;
+        b[i] = (i * 5) % 13 + 1;
+        c[i] = (i * 3) % 7;
+        d += a[i] * b[i];
+        s += a[i];
+    }
+
+    double err = 0.0;
+    err += fabs(dot(a, b) - d);
+    err += fabs(sum(a) - s);
+
+    r = a + b;   for (int i = 0; i < n; i++) err += fabs(r[i] - (a[i] + b[i]));
+    r = a - b;   for (int i = 0; i < n; i++) err += fabs(r[i] - (a[i] - b[i]));
+    r = a * b;   for (int i = 0; i < n; i++) err += fabs(r[i] - (a[i] * b[i]));
+    r = a / b;   for (int i = 0; i < n; i++) err += fabs(r[i] - (a[i] / b[i]));
+    r = -a;      for (int i = 0; i < n; i++) err += fabs(r[i] + a[i]);
+    r = a * 3;   for (int i = 0; i < n; i++) err += fabs(r[i] - (a[i] * 3));
+    r = a / 4;   for (int i = 0; i < n; i++) err += fabs(r[i] - (a[i] / 4));
+
+    r = c;
+    MultiplyAccum(a, 2, r);
+    for (int i = 0; i < n; i++)
+        err += fabs(r[i] - (c[i] + 2 * a[i]));
+
+    return err;
+}
+
+template<class T_MAT> double TransposeErrors(int rows, int cols)
+{
+    T_MAT a(rows, cols), r(cols, rows);
+
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            a(i, j) = i * cols + j;
+
+    double err = 0.0;
+
+    Transpose(a, r);
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            err += fabs(r(j, i) - a(i, j));
+
+    T_MAT b(a);
+    TransposeInPlace(b);
+    err += (b.Rows() != cols || b.Cols() != rows);
+    err += frob(b - r);
+
+    return err;
+}
+
+void TestNDKernels()
+{
+    cout << "\n+ TestNDKernels\n\n";
+
+    // Cover all the vector widths and remainder cases
+    double errf = 0.0;
+    double errd = 0.0;
+
+    for (int n = 1; n <= 70; n++)
+    {
+        errf += KernelErrors<Vecf>(n);
+        errd += KernelErrors<Vecd>(n);
+    }
+
+    cout << "Vecf kernel error: " << errf << endl;
+    cout << "Vecd kernel error: " << errd << endl;
+
+    // Transposes, covering partial tiles and micro-tiles, square and not
+    errf = 0.0;
+    errd = 0.0;
+
+    const int sizes[] = { 1, 3, 4, 7, 32, 33, 70 };
+
+    for (int r : sizes)
+        for (int c : sizes)
+        {
+            errf += TransposeErrors<Matf>(r, c);
+            errd += TransposeErrors<Matd>(r, c);
+        }
+
+    cout << "Matf transpose error: " << errf << endl;
+    cout << "Matd transpose error: " << errd << endl;
+}
+
+void TestNDThreads()
+{
+    cout << "\n+ TestNDThreads\n\n";
+
+    Matd A(150, 130), B(130, 170);
+    Vecd x(130);
+    Vold V(20, 30, 40), W(20, 30, 40);
+
+    for (int i = 0; i < A.Rows(); i++)
+        for (int j = 0; j < A.Cols(); j++)
+            A(i, j) = (i * 7 + j * 3) % 11 - 5 + (i == j ? 40 : 0);
+    for (int i = 0; i < B.Rows(); i++)
+        for (int j = 0; j < B.Cols(); j++)
+            B(i, j) = (i * 5 + j * 2) % 13 - 6;
+    for (int i = 0; i < x.Elts(); i++)
+        x[i] = i % 5 - 2;
+    for (int i = 0; i < V.Elts(); i++)
+    {
+        V.data[i] = i % 17 - 8;
+        W.data[i] = i % 7 + 1;
+    }
+
+    Matd AB(A * B), BtAt(trans(B) * trans(A)), At(trans(A)), AtA(gram(A));
+    Vecd Ax(A * x), AtAx(Ax * A);
+    Matd Ai(inv(sub(A, 0, 0, 130, 130)));
+    Vold VW(V * W), VpW(V + W);
+    VW -= V / W;
+    double AA = sumsqr(A), VV = sumsqr(V);
+
+    // Use more threads than cores, and low thresholds, to exercise stealing
+    double thresholds[kVLThreadOps];
+
+    vl_set_threads(4);
+    for (int i = 0; i < kVLThreadOps; i++)
+    {
+        thresholds[i] = vl_thread_threshold(VLThreadOp(i));
+        vl_set_thread_threshold(VLThreadOp(i), 1000);
+    }
+
+    Vold TVW(V * W);
+    TVW -= V / W;
+
+    Matd Bsq(sub(B, 0, 0, 130, 130));
+    TransposeInPlace(Bsq);
+
+    Vecd TAtAx(130);
+    MultiplyAtAx(A, x, TAtAx);
+
+    cout << "A * B diff: " << frob(A * B - AB) << endl;
+    cout << "Bt * At diff: " << frob(trans(B) * trans(A) - BtAt) << endl;
+    cout << "A * x diff: " << len(A * x - Ax) << endl;
+    cout << "gram(A) diff: " << frob(gram(A) - AtA) << endl;
+    cout << "At * (A * x) diff: " << len(TAtAx - AtAx) << endl;
+    cout << "trans(A) diff: " << frob(trans(A) - At) << endl;
+    cout << "in-place transpose diff: " << frob(Bsq - trans(sub(B, 0, 0, 130, 130))) << endl;
+    cout << "inv(A) diff: " << frob(inv(sub(A, 0, 0, 130, 130)) - Ai) << endl;
+    cout << "V + W diff: " << frob(V + W - VpW) << endl;
+    cout << "V * W - V / W diff: " << frob(TVW - VW) << endl;
+    cout << "sumsqr(A) diff: " << sumsqr(A) - AA << endl;
+    cout << "sumsqr(V) diff: " << sumsqr(V) - VV << endl;
+
+    vl_set_threads(1);
+    for (int i = 0; i < kVLThreadOps; i++)
+        vl_set_thread_threshold(VLThreadOp(i), thresholds[i]);
+}
+
 #ifdef TEST_VL_SOLVE
 
 void TestNDNumerical()
@@ -597,6 +1194,886 @@ void TestNDNumerical()
     cout << endl;
 }
 
+
+void TestNDLU()
+{
+    cout << "\n+ TestNDLU\n" << endl;
+
+    // Big enough to exercise the blocked path
+    const int n = 150;
+    Matd A(n, n);
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            A(i, j) = ((i * 7 + j * 13) % 17) - 8.0 + (i == j ? 4.0 * n : 0.0);
+
+    Vecd b(n);
+    Matd B(n, 3);
+
+    for (int i = 0; i < n; i++)
+    {
+        b[i] = (i % 5) - 2.0;
+        B(i, 0) = i;
+        B(i, 1) = (i % 3) - 1.0;
+        B(i, 2) = 1.0;
+    }
+
+    LUFactord lu(A);
+
+    cout << "singular: " << lu.IsSingular() << endl;
+    cout << "|A x - b| < 1e-10: " << (len(A * lu.Solve(b) - b) < 1e-10) << endl;
+    cout << "|A X - B| < 1e-10: " << (frob(A * lu.Solve(B) - B) < 1e-10) << endl;
+    cout << "|inv(A) A - I| < 1e-10: " << (frob(lu.Inverse() * A - Matd(n, n, vl_I)) < 1e-10) << endl;
+
+    // Needs pivoting, compare against inv()
+    Matd P(4, 4,
+        1.0, 2.0, 3.0, 0.0,
+        2.0, 3.0, 0.0, 5.0,
+        3.0, 0.0, 5.0, 6.0,
+        0.0, 5.0, 6.0, 7.0
+    );
+    double det;
+    Matd Pi = inv(P, &det);
+
+    lu.Factor(P);
+
+    cout << "det(P): " << lu.Det() << " vs " << det << endl;
+    cout << "inv(P) - lu.Inverse():\n" << clamped(Pi - lu.Inverse());
+
+    Vecd x(4, 1.0, 2.0, 3.0, 4.0);
+    Vecd y = P * x;
+    lu.Solve(y, y);
+    cout << "in-place solve: " << clamped(y - x) << endl;
+
+    Matd S(3, 3, vl_1);
+    lu.Factor(S);
+    cout << "singular: " << lu.IsSingular() << endl;
+}
+
+void TestNDSVD()
+{
+    cout << "\n+ TestNDSVD\n" << endl;
+
+    // Tall enough to go via QR, and square enough not to
+    const int sizes[][2] = { { 200, 12 }, { 15, 12 } };
+
+    for (auto size : sizes)
+    {
+        const int m = size[0];
+        const int n = size[1];
+        Matd A(m, n);
+
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < n; j++)
+                A(i, j) = ((i * 5 + j * 11) % 23) - 11.0 + (i == j ? 20.0 : 0.0);
+
+        Matd AM(A);
+        Matd U, V;
+        Vecd diagonal;
+
+        SVDFactorization(AM, U, V, diagonal);
+
+        Matd D(n, n, vl_0);
+        diag(D) = diagonal;
+
+        cout << m << " x " << n << ":" << endl;
+        cout << "|UtU - I| < 1e-10: " << (frob(trans(U) * U - Matd(n, n, vl_I)) < 1e-10) << endl;
+        cout << "|VtV - I| < 1e-10: " << (frob(trans(V) * V - Matd(n, n, vl_I)) < 1e-10) << endl;
+        cout << "|U D Vt - A| < 1e-10: " << (frob(U * D * trans(V) - A) < 1e-10) << endl;
+
+        // Values only should give the same results, without U and V
+        Vecd values;
+        AM = A;
+        SVDFactorization(AM, values);
+
+        cout << "values only matches: " << (len(values - diagonal) < 1e-10) << endl;
+
+        // One-sided Jacobi should find the same values, though maybe in a different order
+        AM = A;
+        SVDFactorization(AM, U, V, values, kVLSVDJacobi);
+
+        Matd DJ(n, n, vl_0);
+        diag(DJ) = values;
+
+        cout << "Jacobi |UtU - I|, |VtV - I|, |U D Vt - A| < 1e-10: "
+             << (frob(trans(U) * U - Matd(n, n, vl_I)) < 1e-10)
+             << (frob(trans(V) * V - Matd(n, n, vl_I)) < 1e-10)
+             << (frob(U * DJ * trans(V) - A) < 1e-10) << endl;
+
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++)
+            {
+                if (values[j] > values[i])
+                    std::swap(values[i], values[j]);
+                if (diagonal[j] > diagonal[i])
+                    std::swap(diagonal[i], diagonal[j]);
+            }
+
+        cout << "Jacobi values match: " << (len(values - diagonal) < 1e-10) << endl;
+    }
+
+    // Jacobi finds tiny singular values to high relative accuracy. A's
+    // columns are orthogonal, with lengths 1, 1e-3, .. 1e-21.
+    {
+        const int m = 12;
+        const int n = 8;
+        Matd A(m, n, vl_0);
+
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < n; j++)
+                A(i, j) = ((i * 7 + j * 3) % 5) - 2.0;
+
+        Matd Q, QR;
+        QRFactorization(A, Q, QR);
+
+        for (int j = 0; j < n; j++)
+            col(Q, j) *= pow(1e-3, j);
+
+        Vecd values;
+        SVDFactorization(Q, values, kVLSVDJacobi);
+
+        double maxRelErr = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            double best = 1.0;
+
+            for (int i = 0; i < n; i++)
+                best = vl_min(best, abs(values[i] - pow(1e-3, j)) / pow(1e-3, j));
+
+            maxRelErr = vl_max(maxRelErr, best);
+        }
+
+        cout << "Jacobi graded relative error < 1e-14: " << (maxRelErr < 1e-14) << endl;
+    }
+
+    // Rank from the singular values
+    Matd R(40, 6);
+
+    for (int i = 0; i < 40; i++)
+        for (int j = 0; j < 6; j++)
+            R(i, j) = (j < 3) ? (i % 7) + j * (i % 3) : R(i, j - 3) * (j + 1);
+
+    Vecd values;
+    SVDFactorization(R, values);
+
+    double maxValue = 0.0;
+    for (int i = 0; i < values.Elts(); i++)
+        maxValue = vl_max(maxValue, values[i]);
+
+    int rank = 0;
+    for (int i = 0; i < values.Elts(); i++)
+        if (values[i] > 1e-8 * maxValue)
+            rank++;
+
+    cout << "rank: " << rank << endl;
+}
+
+void TestNDQR()
+{
+    cout << "\n+ TestNDQR\n" << endl;
+
+    // Several blocks wide, with a partial block at the end
+    const int m = 300;
+    const int n = 70;
+    Matd A(m, n);
+
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++)
+            A(i, j) = ((i * 7 + j * 3) % 19) - 9.0 + (i == j ? 30.0 : 0.0);
+
+    QRFactord qr(A);
+    Matd Q = qr.Q();
+    Matd R = qr.R();
+
+    cout << "|QtQ - I| < 1e-10: " << (frob(trans(Q) * Q - Matd(n, n, vl_I)) < 1e-10) << endl;
+    cout << "|Q R - A| < 1e-10: " << (frob(Q * R - A) < 1e-10) << endl;
+
+    bool upper = true;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < i; j++)
+            upper = upper && R(i, j) == 0.0;
+    cout << "R upper triangular: " << upper << endl;
+
+    // Implicit Q: blocked and vector paths should agree, and Qt undo Q
+    Matd X(m, 3);
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < 3; j++)
+            X(i, j) = ((i + 1) * (j + 2) % 11) - 5.0;
+
+    Matd QX(X);
+    qr.ApplyQ(QX);
+
+    Vecd x0(col(X, 0));
+    qr.ApplyQ(x0);
+    cout << "|Q x - (Q X)_0| < 1e-10: " << (len(x0 - Vecd(col(QX, 0))) < 1e-10) << endl;
+
+    qr.ApplyQt(QX);
+    cout << "|Qt Q X - X| < 1e-10: " << (frob(QX - X) < 1e-10) << endl;
+
+    // Least squares, against the normal equations
+    Vecd b(col(X, 1));
+    Vecd x = qr.Solve(b);
+    Vecd xn = LUFactord(trans(A) * A).Solve(trans(A) * b);
+
+    cout << "|x - x_normal| < 1e-8: " << (len(x - xn) < 1e-8) << endl;
+    cout << "|At (A x - b)| < 1e-8: " << (len(trans(A) * (A * x - b)) < 1e-8) << endl;
+
+    Matd Xs = qr.Solve(X);
+    cout << "|Xs_1 - x| < 1e-10: " << (len(Vecd(col(Xs, 1)) - x) < 1e-10) << endl;
+}
+
+void TestNDCholesky()
+{
+    cout << "\n+ TestNDCholesky\n" << endl;
+
+    // Several blocks, with a partial one at the end
+    const int n = 150;
+    Matd B(n, n);
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            B(i, j) = ((i * 5 + j * 7) % 13) - 6.0;
+
+    Matd A(B * trans(B) + Matd(n, n, vl_I) * n);
+    Matd L(n, n);
+
+    cout << "factored: " << Cholesky(A, L) << endl;
+    cout << "|L Lt - A| < 1e-8: " << (frob(L * trans(L) - A) < 1e-8) << endl;
+
+    bool lower = true;
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            lower = lower && L(i, j) == 0.0;
+    cout << "L lower triangular: " << lower << endl;
+
+    // Many right-hand sides at once
+    Matd X(n, 4);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < 4; j++)
+            X(i, j) = ((i + 3) * (j + 1) % 7) - 3.0;
+
+    Matd Y(n, 4);
+    BacksolveLLt(L, Y, X);
+    cout << "|A Y - X| < 1e-10: " << (frob(A * Y - X) < 1e-10) << endl;
+
+    Vecd y(n);
+    BacksolveLLt(L, y, Vecd(col(X, 2)));
+    cout << "matches vector solve: " << (len(y - Vecd(col(Y, 2))) < 1e-12) << endl;
+
+    // Whitening: W = L^-1 X, so L W = X
+    Matd W(X);
+    SolveLower(L, W);
+    cout << "|L W - X| < 1e-10: " << (frob(L * W - X) < 1e-10) << endl;
+    SolveLowerT(L, W);
+    cout << "|Lt^-1 L^-1 X - Y| < 1e-12: " << (frob(W - Y) < 1e-12) << endl;
+
+    // In place, and threaded
+    double thresholds[kVLThreadOps];
+
+    vl_set_threads(4);
+    for (int i = 0; i < kVLThreadOps; i++)
+    {
+        thresholds[i] = vl_thread_threshold(VLThreadOp(i));
+        vl_set_thread_threshold(VLThreadOp(i), 1000);
+    }
+
+    Matd LT(A);
+    Cholesky(LT, LT);
+    cout << "threaded in-place matches: " << (frob(LT - L) < 1e-12) << endl;
+
+    vl_set_threads(1);
+    for (int i = 0; i < kVLThreadOps; i++)
+        vl_set_thread_threshold(VLThreadOp(i), thresholds[i]);
+
+    // Not positive definite
+    A(n / 2, n / 2) = -1.0;
+    cout << "indefinite factored: " << Cholesky(A, L) << endl;
+}
+
+void TestNDCholeskyUpdate()
+{
+    cout << "\n+ TestNDCholeskyUpdate\n" << endl;
+
+    const int n = 40;
+    Matd B(n, n);
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            B(i, j) = ((i * 3 + j * 5) % 11) - 5.0;
+
+    Matd A(B * trans(B) + Matd(n, n, vl_I) * n);
+    Matd L(n, n), L0(n, n), Lv(n, n);
+    Vecd v(n);
+
+    for (int i = 0; i < n; i++)
+        v[i] = ((i * 7) % 9) - 4.0;
+
+    Cholesky(A, L0);
+    Cholesky(A + oprod(v, v), Lv);
+
+    L = L0;
+    CholeskyUpdate(L, v);
+    cout << "update matches refactor: " << (frob(L - Lv) < 1e-10) << endl;
+
+    cout << "downdate succeeded: " << CholeskyDowndate(L, v) << endl;
+    cout << "downdate matches original: " << (frob(L - L0) < 1e-10) << endl;
+
+    // Removing too much leaves L alone
+    Matd Lc(L);
+    cout << "over-downdate succeeded: " << CholeskyDowndate(L, v * 100.0) << endl;
+    cout << "L unchanged: " << (frob(L - Lc) == 0.0) << endl;
+}
+
+void TestNDEigen()
+{
+    cout << "\n+ TestNDEigen\n" << endl;
+
+    const int n = 30;
+    Matd A(n, n);
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j <= i; j++)
+            A(i, j) = A(j, i) = ((i * 7 + j * 3 + i * j) % 13) - 6.0;
+
+    Matd AM(A);
+    Matd V;
+    Vecd values;
+
+    SymmetricEigen(AM, V, values);
+
+    Matd D(n, n, vl_0);
+    diag(D) = values;
+
+    bool sorted = true;
+    for (int i = 1; i < n; i++)
+        sorted = sorted && values[i] <= values[i - 1];
+
+    cout << "|VtV - I| < 1e-10: " << (frob(trans(V) * V - Matd(n, n, vl_I)) < 1e-10) << endl;
+    cout << "|A V - V D| < 1e-10: " << (frob(A * V - V * D) < 1e-10) << endl;
+    cout << "sorted: " << sorted << ", has negative values: " << (values[n - 1] < 0) << endl;
+
+    // Values only should match
+    Vecd valuesOnly;
+    AM = A;
+    SymmetricEigen(AM, valuesOnly);
+
+    cout << "values only matches: " << (len(valuesOnly - values) < 1e-10) << endl;
+
+    // Eigenvalues of the tridiagonal -1 2 -1 matrix are 2 - 2 cos(k pi / (m + 1))
+    const int m = 8;
+    Matd T(m, m, vl_0);
+
+    for (int i = 0; i < m; i++)
+    {
+        T(i, i) = 2.0;
+
+        if (i > 0)
+            T(i, i - 1) = T(i - 1, i) = -1.0;
+    }
+
+    SymmetricEigen(T, valuesOnly);
+
+    double maxErr = 0.0;
+    for (int k = 1; k <= m; k++)
+        maxErr = vl_max(maxErr, abs(valuesOnly[m - k] - (2.0 - 2.0 * cos(k * vl_pi / (m + 1)))));
+
+    cout << "-1 2 -1 eigenvalues match: " << (maxErr < 1e-12) << endl;
+}
+
+void TestNDSparse()
+{
+    cout << "\n+ TestNDSparse\n" << endl;
+
+    // Small example, built with duplicate and out-of-order entries
+    int    ri[] = { 2, 0, 1, 0, 2, 1, 0 };
+    int    ci[] = { 1, 0, 2, 2, 1, 0, 0 };
+    double vi[] = { 1.0, 4.0, 3.0, 2.0, 5.0, 7.0, 1.0 };
+
+    SparseMatd S;
+    S.SetFromTriplets(3, 4, 7, ri, ci, vi);
+
+    cout << "non-zeros: " << S.NonZeros() << endl;
+    cout << "S:\n" << dense(S);
+    cout << "trans(S):\n" << dense(trans(S));
+    cout << "S(2, 1): " << S(2, 1) << ", S(2, 2): " << S(2, 2) << endl;
+
+    Vecd x(4, 1.0, 2.0, 3.0, 4.0);
+    Vecd y(3, 1.0, 2.0, 3.0);
+    cout << "S x: " << S * x << " vs " << dense(S) * x << endl;
+    cout << "y S: " << y * S << " vs " << y * dense(S) << endl;
+
+    // 2D Poisson problem on an n x n grid
+    const int n = 20;
+    const int N = n * n;
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            int r = i * n + j;
+            int neighbours[4][2] = { { i - 1, j }, { i + 1, j }, { i, j - 1 }, { i, j + 1 } };
+
+            rows.push_back(r); cols.push_back(r); values.push_back(4.0);
+
+            for (auto& nb : neighbours)
+                if (nb[0] >= 0 && nb[0] < n && nb[1] >= 0 && nb[1] < n)
+                {
+                    rows.push_back(r); cols.push_back(nb[0] * n + nb[1]); values.push_back(-1.0);
+                }
+        }
+
+    SparseMatd A;
+    A.SetFromTriplets(N, N, int(values.size()), rows.data(), cols.data(), values.data());
+    SparseMatd Ad(dense(A));
+
+    Vecd b(N);
+    for (int i = 0; i < N; i++)
+        b[i] = (i % 7) - 3.0;
+
+    cout << "non-zeros: " << A.NonZeros() << ", from dense: " << Ad.NonZeros() << endl;
+    cout << "A b == dense(A) b: " << (len(A * b - dense(A) * b) < 1e-12) << endl;
+    cout << "b A == A b: " << (len(b * A - A * b) < 1e-12) << endl;
+
+    Vecd xs(N, vl_0);
+    int steps = 1000;
+    SolveConjGrad(A, xs, b, 1e-20, &steps);
+    cout << "conjugate-gradient |A x - b| < 1e-5: " << (len(A * xs - b) < 1e-5) << endl;
+
+    xs.MakeZero();
+    steps = 1000;
+    SolveOverRelax(A, xs, b, 1e-16, 1.8, &steps);
+    cout << "over-relaxation |A x - b| < 1e-6: " << (len(A * xs - b) < 1e-6) << endl;
+
+    xs.MakeZero();
+    steps = 1000;
+    SolveConjGrad_AtA(A, xs, b, 1e-20, &steps);
+    cout << "conjugate-gradient AtA |A x - b| < 1e-6: " << (len(A * xs - b) < 1e-6) << endl;
+}
+
+struct DiagPreconditioner : public Preconditionerd
+{
+    Vecd invDiag;
+
+    DiagPreconditioner(const SparseMatd& A) : invDiag(A.Rows())
+    {
+        for (int i = 0; i < A.Rows(); i++)
+            invDiag[i] = 1.0 / A(i, i);
+    }
+
+    void Apply(ConstRefVecd r, RefVecd z) const override
+    {
+        Multiply(r, invDiag, z);
+    }
+};
+
+void TestNDPrecond()
+{
+    cout << "\n+ TestNDPrecond\n" << endl;
+
+    // Poisson-style problem with strongly varying coefficients
+    const int n = 16;
+    const int N = n * n;
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+
+    auto add = [&](int r, int c, double v) { rows.push_back(r); cols.push_back(c); values.push_back(v); };
+    auto coeff = [](int i, int j) { return (i / 4 + j / 4) % 2 ? 1000.0 : 1.0; };
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            int p = i * n + j;
+            add(p, p, 0.01);
+
+            int neighbours[2][2] = { { i + 1, j }, { i, j + 1 } };
+
+            for (auto& nb : neighbours)
+                if (nb[0] < n && nb[1] < n)
+                {
+                    int    q = nb[0] * n + nb[1];
+                    double w = coeff(i, j) + coeff(nb[0], nb[1]);
+
+                    add(p, p, w);
+                    add(q, q, w);
+                    add(p, q, -w);
+                    add(q, p, -w);
+                }
+        }
+
+    SparseMatd A;
+    A.SetFromTriplets(N, N, int(values.size()), rows.data(), cols.data(), values.data());
+
+    Vecd b(N);
+    for (int i = 0; i < N; i++)
+        b[i] = (i % 7) - 3.0;
+
+    double epsilon = 1e-20 * sqrlen(b);
+    Vecd x(N);
+
+    x.MakeZero();
+    int cgSteps = 10000;
+    SolveConjGrad(A, x, b, epsilon, &cgSteps);
+
+    JacobiPreconditionerd      jacobi(A);
+    BlockJacobiPreconditionerd blockJacobi(A, 4);
+    SSORPreconditionerd        ssor(A, 1.2);
+    IC0Preconditionerd         ic0(A);
+    IC0Preconditionerd         ic0Dense(dense(A));
+    DiagPreconditioner         user(A);
+
+    const Preconditionerd* preconditioners[] = { &jacobi, &blockJacobi, &ssor, &ic0, &ic0Dense, &user };
+    const char* names[] = { "Jacobi", "block Jacobi", "SSOR", "IC0", "IC0 from dense", "user" };
+
+    for (int i = 0; i < 6; i++)
+    {
+        x.MakeZero();
+        int steps = 10000;
+        SolveConjGrad(A, x, b, *preconditioners[i], epsilon, &steps);
+
+        cout << names[i] << ": fewer iterations " << (steps < cgSteps)
+             << ", |A x - b| small " << (len(A * x - b) < 1e-7 * len(b)) << endl;
+    }
+
+    Matd D(dense(A));
+    x.MakeZero();
+    SolveConjGrad(D, x, b, ic0, epsilon);
+    cout << "dense A with IC0: |A x - b| small " << (len(D * x - b) < 1e-7 * len(b)) << endl;
+}
+
+struct StencilOperator : public LinearOperatord
+// 1D second difference, 2 x_i - x_i-1 - x_i+1, plus an optional upwind term
+// that makes it non-symmetric.
+{
+    int    n;
+    double upwind;
+
+    StencilOperator(int size, double u) : n(size), upwind(u) {}
+
+    int Rows() const override { return n; }
+    int Cols() const override { return n; }
+
+    void Apply(ConstRefVecd x, RefVecd y) const override
+    {
+        for (int i = 0; i < n; i++)
+            y[i] = (2.0 + upwind) * x[i] - (1.0 + upwind) * (i > 0 ? x[i - 1] : 0.0) - (i < n - 1 ? x[i + 1] : 0.0);
+    }
+
+    void ApplyTranspose(ConstRefVecd x, RefVecd y) const override
+    {
+        for (int i = 0; i < n; i++)
+            y[i] = (2.0 + upwind) * x[i] - (i > 0 ? x[i - 1] : 0.0) - (1.0 + upwind) * (i < n - 1 ? x[i + 1] : 0.0);
+    }
+
+    SparseMatd Matrix() const
+    {
+        Matd m(n, n, vl_0);
+
+        for (int i = 0; i < n; i++)
+        {
+            m(i, i) = 2.0 + upwind;
+            if (i > 0)
+                m(i, i - 1) = -(1.0 + upwind);
+            if (i < n - 1)
+                m(i, i + 1) = -1.0;
+        }
+
+        return SparseMatd(m);
+    }
+};
+
+void TestNDOperator()
+{
+    cout << "\n+ TestNDOperator\n" << endl;
+
+    const int n = 50;
+    Vecd b(n), x(n), y(n);
+
+    for (int i = 0; i < n; i++)
+        b[i] = (i % 5) - 2.0;
+
+    StencilOperator laplacian(n, 0.0);
+    SparseMatd      A = laplacian.Matrix();
+
+    Multiply(laplacian, b, y);
+    cout << "Apply matches matrix: " << (len(y - A * b) < 1e-12) << endl;
+
+    x.MakeZero();
+    SolveConjGrad(laplacian, x, b, 1e-20);
+    cout << "conjugate-gradient |A x - b| < 1e-6: " << (len(A * x - b) < 1e-6) << endl;
+
+    x.MakeZero();
+    SolveConjGrad(laplacian, x, b, JacobiPreconditionerd(A), 1e-20);
+    cout << "preconditioned |A x - b| < 1e-6: " << (len(A * x - b) < 1e-6) << endl;
+
+    StencilOperator convection(n, 0.5);
+    SparseMatd      C = convection.Matrix();
+
+    Multiply(b, convection, y);
+    cout << "ApplyTranspose matches matrix: " << (len(y - b * C) < 1e-12) << endl;
+
+    x.MakeZero();
+    SolveConjGrad_AtA(convection, x, b, 1e-20);
+    cout << "conjugate-gradient AtA |A x - b| < 1e-6: " << (len(C * x - b) < 1e-6) << endl;
+}
+
+void TestNDLanczos()
+{
+    cout << "\n+ TestNDLanczos\n" << endl;
+
+    const int n = 60;
+    const int k = 4;
+    Matd A(n, n);
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j <= i; j++)
+            A(i, j) = A(j, i) = ((i * 7 + j * 3 + i * j) % 13) - 6.0;
+
+    Matd AM(A);
+    Vecd allValues;
+    SymmetricEigen(AM, allValues);
+
+    Matd V;
+    Vecd values;
+    int  converged = LanczosEigen(A, k, V, values, 1e-10);
+
+    Matd D(k, k, vl_0);
+    diag(D) = values;
+
+    cout << "converged: " << (converged == k) << endl;
+    cout << "top values match: " << (len(values - first(allValues, k)) < 1e-8) << endl;
+    cout << "|A V - V D| < 1e-8: " << (frob(A * V - V * D) < 1e-8) << endl;
+    cout << "|VtV - I| < 1e-10: " << (frob(trans(V) * V - Matd(k, k, vl_I)) < 1e-10) << endl;
+
+    // Largest eigenvalues of the -1 2 -1 matrix are 2 - 2 cos(i pi / (m + 1)), for i = m, m - 1, ...
+    const int m = 200;
+    StencilOperator laplacian(m, 0.0);
+
+    converged = LanczosEigen(laplacian, 3, V, values, 1e-8);
+
+    double maxErr = 0.0;
+    for (int i = 0; i < 3; i++)
+        maxErr = vl_max(maxErr, abs(values[i] - (2.0 - 2.0 * cos((m - i) * vl_pi / (m + 1)))));
+
+    cout << "operator converged: " << (converged == 3) << ", values match: " << (maxErr < 1e-8) << endl;
+
+    // Top singular triplets
+    Matd B(50, 30);
+
+    for (int i = 0; i < B.Rows(); i++)
+        for (int j = 0; j < B.Cols(); j++)
+            B(i, j) = ((i * 5 + j * 11 + i * j) % 17) - 8.0;
+
+    Matd BM(B), BU, BV;
+    Vecd allSingular;
+    SVDFactorization(BM, BU, BV, allSingular);
+
+    for (int i = 0; i < allSingular.Elts(); i++)
+        for (int j = i + 1; j < allSingular.Elts(); j++)
+            if (allSingular[j] > allSingular[i])
+                std::swap(allSingular[i], allSingular[j]);
+
+    Matd U;
+    converged = LanczosSVD(B, k, U, V, values, 1e-10);
+    diag(D) = values;
+
+    cout << "SVD converged: " << (converged == k) << endl;
+    cout << "top singular values match: " << (len(values - first(allSingular, k)) < 1e-8) << endl;
+    cout << "|B V - U D| < 1e-8: " << (frob(B * V - U * D) < 1e-8) << endl;
+    cout << "|Bt U - V D| < 1e-8: " << (frob(trans(B) * U - V * D) < 1e-8) << endl;
+
+    // Sparse and operator forms should agree
+    StencilOperator convection(m, 0.5);
+    Vecd opValues;
+
+    LanczosSVD(convection, 3, U, V, opValues, 1e-8);
+    LanczosSVD(convection.Matrix(), 3, U, V, values, 1e-8);
+
+    cout << "operator matches sparse: " << (len(opValues - values) < 1e-8) << endl;
+}
+
+void TestNDRandomizedSVD()
+{
+    cout << "\n+ TestNDRandomizedSVD\n" << endl;
+
+    // Rank 6 matrix with a decaying spectrum, plus a little noise
+    const int m = 120;
+    const int n = 80;
+    const int k = 6;
+    Matd A(m, n, vl_0);
+
+    for (int r = 0; r < k; r++)
+    {
+        Vecd u(m), v(n);
+
+        for (int i = 0; i < m; i++)
+            u[i] = ((i * (r + 3) + r) % 11) - 5.0;
+        for (int j = 0; j < n; j++)
+            v[j] = ((j * (r + 5) + 2 * r) % 7) - 3.0;
+
+        A += pow(0.5, r) * oprod(u, v);
+    }
+
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++)
+            A(i, j) += 1e-6 * (((i * 13 + j * 7) % 5) - 2.0);
+
+    Matd AM(A), AU, AV;
+    Vecd allSingular;
+    SVDFactorization(AM, AU, AV, allSingular);
+
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            if (allSingular[j] > allSingular[i])
+                std::swap(allSingular[i], allSingular[j]);
+
+    Matd U, V;
+    Vecd values;
+    RandomizedSVD(A, k, U, V, values);
+
+    Matd D(k, k, vl_0);
+    diag(D) = values;
+
+    cout << "top singular values match: " << (len(values - first(allSingular, k)) < 1e-8 * allSingular[0]) << endl;
+    cout << "|UtU - I| < 1e-10: " << (frob(trans(U) * U - Matd(k, k, vl_I)) < 1e-10) << endl;
+    cout << "|VtV - I| < 1e-10: " << (frob(trans(V) * V - Matd(k, k, vl_I)) < 1e-10) << endl;
+    // The best rank k approximation leaves the remaining singular values
+    double best = sqrt(sqrlen(allSingular) - sqrlen(first(allSingular, k)));
+    cout << "|A - U D Vt| near optimal: " << (frob(A - U * D * trans(V)) < 1.01 * best) << endl;
+
+    // Wide matrices work too
+    Matd At(trans(A));
+    RandomizedSVD(At, k, V, U, values, 1);
+
+    cout << "wide matches: " << (len(values - first(allSingular, k)) < 1e-8 * allSingular[0]) << endl;
+}
+
+void TestNDNonSymmetric()
+{
+    cout << "\n+ TestNDNonSymmetric\n" << endl;
+
+    // Convection-diffusion problem on an n x n grid
+    const int n = 16;
+    const int N = n * n;
+    const double c = 0.8;
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+
+    auto add = [&](int r, int c, double v) { rows.push_back(r); cols.push_back(c); values.push_back(v); };
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            int p = i * n + j;
+
+            add(p, p, 4.0 + c);
+            if (i > 0)     add(p, p - n, -1.0 - c);
+            if (i < n - 1) add(p, p + n, -1.0);
+            if (j > 0)     add(p, p - 1, -1.0);
+            if (j < n - 1) add(p, p + 1, -1.0);
+        }
+
+    SparseMatd A;
+    A.SetFromTriplets(N, N, int(values.size()), rows.data(), cols.data(), values.data());
+    Matd D(dense(A));
+
+    Vecd b(N);
+    for (int i = 0; i < N; i++)
+        b[i] = (i % 7) - 3.0;
+
+    double epsilon = 1e-20 * sqrlen(b);
+    double tolerance = 1e-8 * len(b);
+    Vecd x(N);
+
+    x.MakeZero();
+    int atSteps = 10000;
+    SolveConjGrad_AtA(A, x, b, epsilon, &atSteps);
+
+    x.MakeZero();
+    int steps = 10000;
+    SolveBiCGStab(A, x, b, epsilon, &steps);
+    cout << "BiCGStab: fewer iterations than AtA " << (steps < atSteps) << ", |A x - b| small " << (len(A * x - b) < tolerance) << endl;
+
+    x.MakeZero();
+    SolveBiCGStab(D, x, b, epsilon);
+    cout << "BiCGStab dense: |A x - b| small " << (len(D * x - b) < tolerance) << endl;
+
+    x.MakeZero();
+    steps = 10000;
+    SolveGMRES(A, x, b, epsilon, &steps);
+    cout << "GMRES(30): fewer iterations than AtA " << (steps < atSteps) << ", |A x - b| small " << (len(A * x - b) < tolerance) << endl;
+
+    x.MakeZero();
+    steps = 10000;
+    SolveGMRES(D, x, b, epsilon, &steps, 5);
+    cout << "GMRES(5) dense: |A x - b| small " << (len(D * x - b) < tolerance) << endl;
+
+    StencilOperator convection(50, 0.5);
+    SparseMatd C = convection.Matrix();
+    Vecd bc(50), xc(50);
+
+    for (int i = 0; i < 50; i++)
+        bc[i] = (i % 5) - 2.0;
+
+    xc.MakeZero();
+    SolveBiCGStab(convection, xc, bc, 1e-20);
+    cout << "BiCGStab operator: |A x - b| < 1e-8 " << (len(C * xc - bc) < 1e-8) << endl;
+
+    xc.MakeZero();
+    SolveGMRES(convection, xc, bc, 1e-20);
+    cout << "GMRES operator: |A x - b| < 1e-8 " << (len(C * xc - bc) < 1e-8) << endl;
+
+    // Small system, where GMRES converges in n steps
+    Matd S(3, 3,
+        1.0, 2.0, 0.0,
+        0.0, 1.0, 3.0,
+        4.0, 0.0, 1.0
+    );
+    Vecd bs(3, 1.0, 2.0, 3.0);
+    Vecd xs(3, vl_0);
+
+    steps = 100;
+    SolveGMRES(S, xs, bs, 1e-24, &steps);
+    cout << "GMRES 3x3: x = " << clamped(xs) << ", steps = " << steps << endl;
+}
+
+void TestNDWorkspace()
+{
+    cout << "\n+ TestNDWorkspace\n" << endl;
+
+    const int n = 40;
+    StencilOperator op(n, 0.5);
+    SparseMatd      A = op.Matrix();
+    Matd            D = dense(A);
+    Vecd b(n), x(n), xw(n);
+
+    for (int i = 0; i < n; i++)
+        b[i] = (i % 5) - 2.0;
+
+    SolveWorkspaced workspace(n);
+    int elts = workspace.Elts();
+
+    // Results should be identical with or without a workspace
+    x.MakeZero();
+    xw.MakeZero();
+    SolveConjGrad_AtA(D, x, b, 1e-20);
+    SolveConjGrad_AtA(D, xw, b, 1e-20, 0, &workspace);
+    cout << "ConjGrad_AtA same: " << (x == xw) << endl;
+
+    x.MakeZero();
+    xw.MakeZero();
+    SolveBiCGStab(A, x, b, 1e-20);
+    SolveBiCGStab(A, xw, b, 1e-20, 0, &workspace);
+    cout << "BiCGStab same: " << (x == xw) << endl;
+
+    x.MakeZero();
+    xw.MakeZero();
+    SolveGMRES(op, x, b, 1e-20, 0, 10);
+    SolveGMRES(op, xw, b, 1e-20, 0, 10, &workspace);
+    cout << "GMRES same: " << (x == xw) << endl;
+
+    cout << "no growth: " << (workspace.Elts() == elts) << endl;
+}
 #endif
 
 void TestNDFunc()
@@ -673,6 +2150,12 @@ int main(int, char **)
     TestH2DStuff();
     TestH3DStuff();
 
+    Test3DFactor();
+    Test3DWide();
+    Test3DBatchTransforms();
+    Test3DBatchQuat();
+    Test3DAffine();
+
     TestComparisons();
 #endif
 
@@ -680,8 +2163,24 @@ int main(int, char **)
     TestNInit();
     TestND();
     TestNDSub();
+    TestNDProducts();
+    TestNDKernels();
+    TestNDThreads();
 #ifdef TEST_VL_SOLVE
     TestNDNumerical();
+    TestNDLU();
+    TestNDSVD();
+    TestNDQR();
+    TestNDCholesky();
+    TestNDCholeskyUpdate();
+    TestNDEigen();
+    TestNDSparse();
+    TestNDPrecond();
+    TestNDOperator();
+    TestNDLanczos();
+    TestNDRandomizedSVD();
+    TestNDNonSymmetric();
+    TestNDWorkspace();
 #endif
     TestNComparisons();
 #endif